@@ -1,63 +1,337 @@
 {
+    "variables": {
+        "multihash_core_sources": [
+            "multihash.c",
+            "difficulty.c",
+            "sharefilter.c",
+            "membudget.c",
+            "ring.c",
+            "crosscheck.c",
+            "perfcount.c",
+            "stratum.c",
+            "sched.c",
+            "flight.c",
+            "interleave.c",
+        ],
+        "multihash_sph_sources": [
+            "hashchain.c",
+            "keccak.c",
+            "skein.c",
+            "x11.c",
+            "quark.c",
+            "groestl.c",
+            "blake.c",
+            "fugue.c",
+            "qubit.c",
+            "hefty1.c",
+            "shavite3.c",
+            "x13.c",
+            "nist5.c",
+            "x15.c",
+            "fresh.c",
+            "sophia.c",
+            "sha3/sph_hefty1.c",
+            "sha3/sph_fugue.c",
+            "sha3/aes_helper.c",
+            "sha3/sph_blake.c",
+            "sha3/sph_bmw.c",
+            "sha3/sph_cubehash.c",
+            "sha3/sph_echo.c",
+            "sha3/sph_groestl.c",
+            "sha3/sph_jh.c",
+            "sha3/sph_keccak.c",
+            "sha3/sph_luffa.c",
+            "sha3/sph_shavite.c",
+            "sha3/sph_simd.c",
+            "sha3/sph_skein.c",
+            "sha3/sph_whirlpool.c",
+            "sha3/sph_shabal.c",
+            "sha3/hamsi.c",
+        ],
+        "multihash_scrypt_sources": [
+            "scryptjane.c",
+            "scryptn.c",
+        ],
+        "multihash_cryptonote_sources": [
+            "cryptonight.c",
+            "boolberry.cc",
+            "crypto/c_keccak.c",
+            "crypto/c_groestl.c",
+            "crypto/c_blake256.c",
+            "crypto/c_jh.c",
+            "crypto/c_skein.c",
+            "crypto/hash.c",
+            "crypto/aesb.c",
+            "crypto/wild_keccak.cpp",
+        ],
+        "multihash_misc_sources": [
+            "bcrypt.c",
+            "sha1.c",
+        ],
+        # x86-64-v2 and x86-64-v3, spelled out for compilers without -march=x86-64-v*
+        "isa_v2_cflags": [
+            "-msse3", "-mssse3", "-msse4.1", "-msse4.2", "-mpopcnt", "-mcx16", "-msahf",
+        ],
+        "isa_v3_cflags": [
+            "-msse3", "-mssse3", "-msse4.1", "-msse4.2", "-mpopcnt", "-mcx16", "-msahf",
+            "-mavx", "-mavx2", "-mbmi", "-mbmi2", "-mfma", "-mf16c", "-mlzcnt", "-mmovbe", "-mxsave",
+        ],
+        "multihash_sources": [
+            "<@(multihash_core_sources)",
+            "<@(multihash_sph_sources)",
+            "<@(multihash_scrypt_sources)",
+            "<@(multihash_cryptonote_sources)",
+            "<@(multihash_misc_sources)",
+        ],
+    },
+    "target_defaults": {
+        "include_dirs": [
+            "crypto",
+        ],
+        "defines": [
+            "NAPI_VERSION=8"
+        ],
+        "cflags_cc": [
+            "-std=c++0x"
+        ],
+    },
     "targets": [
+        {
+            "target_name": "multihash",
+            "type": "static_library",
+            "product_prefix": "lib",
+            "standalone_static_library": 1,
+            "sources": [
+                "<@(multihash_sources)",
+            ],
+        },
+        {
+            "target_name": "multihash_shared",
+            "product_name": "multihash",
+            "type": "shared_library",
+            "product_prefix": "lib",
+            "sources": [
+                "<@(multihash_sources)",
+            ],
+            "link_settings": {
+                "libraries": [
+                    "-lcrypto",
+                    "-lpthread"
+                ],
+            },
+        },
+        {
+            "target_name": "multihash-verify",
+            "type": "executable",
+            "sources": [
+                "multihash_verify.c",
+            ],
+            "dependencies": [
+                "multihash",
+            ],
+            "link_settings": {
+                "libraries": [
+                    "-lcrypto",
+                    "-lpthread"
+                ],
+            },
+        },
         {
             "target_name": "multihashing",
             "sources": [
                 "multihashing.cc",
-                "scryptjane.c",
-                "scryptn.c",
-                "keccak.c",
-                "skein.c",
-                "x11.c",
-                "quark.c",
-                "bcrypt.c",
-                "groestl.c",
-                "blake.c",
-                "fugue.c",
-                "qubit.c",
-                "hefty1.c",
-                "shavite3.c",
-                "cryptonight.c",
-                "x13.c",
-                "boolberry.cc",
-                "nist5.c",
-                "sha1.c",
-                "x15.c",
-                "fresh.c",
-                "sha3/sph_hefty1.c",
-                "sha3/sph_fugue.c",
-                "sha3/aes_helper.c",
-                "sha3/sph_blake.c",
-                "sha3/sph_bmw.c",
-                "sha3/sph_cubehash.c",
-                "sha3/sph_echo.c",
-                "sha3/sph_groestl.c",
-                "sha3/sph_jh.c",
-                "sha3/sph_keccak.c",
-                "sha3/sph_luffa.c",
-                "sha3/sph_shavite.c",
-                "sha3/sph_simd.c",
-                "sha3/sph_skein.c",
-                "sha3/sph_whirlpool.c",
-                "sha3/sph_shabal.c",
-                "sha3/hamsi.c",
-                "crypto/oaes_lib.c",
-                "crypto/c_keccak.c",
-                "crypto/c_groestl.c",
-                "crypto/c_blake256.c",
-                "crypto/c_jh.c",
-                "crypto/c_skein.c",
-                "crypto/hash.c",
-                "crypto/aesb.c",
-                "crypto/wild_keccak.cpp",
-                "sophia.c",
-            ],
-            "include_dirs": [
-                "crypto",
-            ],
-            "cflags_cc": [
-                "-std=c++0x"
+            ],
+            "defines": [
+                "MULTIHASHING_SPH",
+                "MULTIHASHING_SCRYPT",
+                "MULTIHASHING_CRYPTONOTE",
+                "MULTIHASHING_MISC"
+            ],
+            "dependencies": [
+                "multihash",
+            ],
+        },
+        # Per-family modules, loaded on first use by index.js: each one carries
+        # only its own algorithms next to the shared core.
+        {
+            "target_name": "multihashing_core",
+            "sources": [
+                "multihashing.cc",
+                "<@(multihash_core_sources)",
+            ],
+            "defines": [
+                "MULTIHASH_WEAK_ALGOS"
+            ],
+        },
+        {
+            "target_name": "multihashing_sph",
+            "sources": [
+                "multihashing.cc",
+                "<@(multihash_core_sources)",
+                "<@(multihash_sph_sources)",
+            ],
+            "defines": [
+                "MULTIHASH_WEAK_ALGOS",
+                "MULTIHASHING_SPH"
+            ],
+        },
+        {
+            "target_name": "multihashing_scrypt",
+            "sources": [
+                "multihashing.cc",
+                "<@(multihash_core_sources)",
+                "<@(multihash_scrypt_sources)",
+            ],
+            "defines": [
+                "MULTIHASH_WEAK_ALGOS",
+                "MULTIHASHING_SCRYPT"
+            ],
+        },
+        {
+            "target_name": "multihashing_cryptonote",
+            "sources": [
+                "multihashing.cc",
+                "<@(multihash_core_sources)",
+                "<@(multihash_cryptonote_sources)",
+            ],
+            "defines": [
+                "MULTIHASH_WEAK_ALGOS",
+                "MULTIHASHING_CRYPTONOTE"
+            ],
+        },
+        {
+            "target_name": "multihashing_misc",
+            "sources": [
+                "multihashing.cc",
+                "<@(multihash_core_sources)",
+                "<@(multihash_misc_sources)",
+            ],
+            "defines": [
+                "MULTIHASH_WEAK_ALGOS",
+                "MULTIHASHING_MISC"
             ],
         }
+    ],
+    "conditions": [
+        # The compute-heavy families (and the complete module HashRing runs on) once
+        # more for each x86-64 level; families.js loads the highest the cpu runs.
+        ["target_arch=='x64' and OS!='win'", {
+            "targets": [
+                {
+                    "target_name": "multihashing_sph_v2",
+                    "sources": [
+                        "multihashing.cc",
+                        "<@(multihash_core_sources)",
+                        "<@(multihash_sph_sources)",
+                    ],
+                    "defines": [
+                        "MULTIHASH_WEAK_ALGOS",
+                        "MULTIHASHING_SPH"
+                    ],
+                    "cflags": ["<@(isa_v2_cflags)"],
+                    "xcode_settings": {"OTHER_CFLAGS": ["<@(isa_v2_cflags)"]},
+                },
+                {
+                    "target_name": "multihashing_scrypt_v2",
+                    "sources": [
+                        "multihashing.cc",
+                        "<@(multihash_core_sources)",
+                        "<@(multihash_scrypt_sources)",
+                    ],
+                    "defines": [
+                        "MULTIHASH_WEAK_ALGOS",
+                        "MULTIHASHING_SCRYPT"
+                    ],
+                    "cflags": ["<@(isa_v2_cflags)"],
+                    "xcode_settings": {"OTHER_CFLAGS": ["<@(isa_v2_cflags)"]},
+                },
+                {
+                    "target_name": "multihashing_cryptonote_v2",
+                    "sources": [
+                        "multihashing.cc",
+                        "<@(multihash_core_sources)",
+                        "<@(multihash_cryptonote_sources)",
+                    ],
+                    "defines": [
+                        "MULTIHASH_WEAK_ALGOS",
+                        "MULTIHASHING_CRYPTONOTE"
+                    ],
+                    "cflags": ["<@(isa_v2_cflags)"],
+                    "xcode_settings": {"OTHER_CFLAGS": ["<@(isa_v2_cflags)"]},
+                },
+                {
+                    "target_name": "multihashing_all_v2",
+                    "sources": [
+                        "multihashing.cc",
+                        "<@(multihash_sources)",
+                    ],
+                    "defines": [
+                        "MULTIHASHING_SPH",
+                        "MULTIHASHING_SCRYPT",
+                        "MULTIHASHING_CRYPTONOTE",
+                        "MULTIHASHING_MISC"
+                    ],
+                    "cflags": ["<@(isa_v2_cflags)"],
+                    "xcode_settings": {"OTHER_CFLAGS": ["<@(isa_v2_cflags)"]}
+                },
+                {
+                    "target_name": "multihashing_sph_v3",
+                    "sources": [
+                        "multihashing.cc",
+                        "<@(multihash_core_sources)",
+                        "<@(multihash_sph_sources)",
+                    ],
+                    "defines": [
+                        "MULTIHASH_WEAK_ALGOS",
+                        "MULTIHASHING_SPH"
+                    ],
+                    "cflags": ["<@(isa_v3_cflags)"],
+                    "xcode_settings": {"OTHER_CFLAGS": ["<@(isa_v3_cflags)"]},
+                },
+                {
+                    "target_name": "multihashing_scrypt_v3",
+                    "sources": [
+                        "multihashing.cc",
+                        "<@(multihash_core_sources)",
+                        "<@(multihash_scrypt_sources)",
+                    ],
+                    "defines": [
+                        "MULTIHASH_WEAK_ALGOS",
+                        "MULTIHASHING_SCRYPT"
+                    ],
+                    "cflags": ["<@(isa_v3_cflags)"],
+                    "xcode_settings": {"OTHER_CFLAGS": ["<@(isa_v3_cflags)"]},
+                },
+                {
+                    "target_name": "multihashing_cryptonote_v3",
+                    "sources": [
+                        "multihashing.cc",
+                        "<@(multihash_core_sources)",
+                        "<@(multihash_cryptonote_sources)",
+                    ],
+                    "defines": [
+                        "MULTIHASH_WEAK_ALGOS",
+                        "MULTIHASHING_CRYPTONOTE"
+                    ],
+                    "cflags": ["<@(isa_v3_cflags)"],
+                    "xcode_settings": {"OTHER_CFLAGS": ["<@(isa_v3_cflags)"]},
+                },
+                {
+                    "target_name": "multihashing_all_v3",
+                    "sources": [
+                        "multihashing.cc",
+                        "<@(multihash_sources)",
+                    ],
+                    "defines": [
+                        "MULTIHASHING_SPH",
+                        "MULTIHASHING_SCRYPT",
+                        "MULTIHASHING_CRYPTONOTE",
+                        "MULTIHASHING_MISC"
+                    ],
+                    "cflags": ["<@(isa_v3_cflags)"],
+                    "xcode_settings": {"OTHER_CFLAGS": ["<@(isa_v3_cflags)"]}
+                }
+            ]
+        }]
     ]
 }
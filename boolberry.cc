@@ -1,4 +1,6 @@
 #include "boolberry.h"
+
+#include <string>
 #include "crypto/cryptonote_core/cryptonote_format_utils.h"
 
 #include <iostream>
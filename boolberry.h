@@ -1,6 +1,16 @@
-#pragma once
+#ifndef BOOLBERRY_H
+#define BOOLBERRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 #include <stdint.h>
-#include <string>
 
 void boolberry_hash(const char* input, uint32_t input_len, const char* scratchpad, uint64_t spad_length, char* output, uint64_t height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
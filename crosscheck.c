@@ -0,0 +1,172 @@
+#include "multihash.h"
+
+#include <pthread.h>
+#include <string.h>
+
+/*
+ * Sampling cross-check of the fast paths. multihash.c hands every hash an
+ * algorithm's fast path produced to multihash_crosscheck_sample; about one in
+ * `rate` of them is copied into a small queue and recomputed with the scalar
+ * reference on a background thread. The hashing threads never wait: when the
+ * queue is full the sample is dropped and counted.
+ */
+
+#define QUEUE_SIZE 64
+
+typedef struct sample {
+    int algo;
+    multihash_params params;
+    size_t len;
+    char input[MULTIHASH_CROSSCHECK_INPUT_MAX];
+    char output[MULTIHASH_OUTPUT_SIZE];
+} sample;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static sample queue[QUEUE_SIZE];
+static unsigned head, tail;     /* tail - head samples are queued */
+static int busy;                /* the checker is recomputing one */
+static int started;
+
+static uint32_t rate;           /* 0: off */
+static int auto_disable;
+
+static uint64_t sampled[MULTIHASH_ALGO_COUNT];
+static uint64_t checked[MULTIHASH_ALGO_COUNT];
+static uint64_t mismatches[MULTIHASH_ALGO_COUNT];
+static uint64_t dropped[MULTIHASH_ALGO_COUNT];
+static int fast_path_off[MULTIHASH_ALGO_COUNT];
+
+static __thread uint64_t random_state;
+
+/* xorshift64*, seeded per thread from its own address */
+static uint64_t next_random(void)
+{
+    uint64_t x = random_state;
+    if (!x)
+        x = (uint64_t) (uintptr_t) &random_state * 0x9e3779b97f4a7c15ULL | 1;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    random_state = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+static void* checker(void* arg)
+{
+    sample s;
+    char expected[MULTIHASH_OUTPUT_SIZE];
+
+    (void) arg;
+
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        while (head == tail) {
+            busy = 0;
+            pthread_cond_broadcast(&cond);
+            pthread_cond_wait(&cond, &lock);
+        }
+        busy = 1;
+        s = queue[head % QUEUE_SIZE];
+        head++;
+        pthread_mutex_unlock(&lock);
+
+        if (multihash_hash_reference(s.algo, &s.params, s.input, s.len, expected) == MULTIHASH_OK) {
+            __sync_fetch_and_add(&checked[s.algo], 1);
+            if (memcmp(expected, s.output, MULTIHASH_OUTPUT_SIZE) != 0) {
+                __sync_fetch_and_add(&mismatches[s.algo], 1);
+                if (__atomic_load_n(&auto_disable, __ATOMIC_RELAXED))
+                    __atomic_store_n(&fast_path_off[s.algo], 1, __ATOMIC_RELAXED);
+            }
+        }
+
+        pthread_mutex_lock(&lock);
+    }
+    return NULL;
+}
+
+void multihash_crosscheck_configure(uint32_t one_in, int disable_on_mismatch)
+{
+    __atomic_store_n(&auto_disable, disable_on_mismatch, __ATOMIC_RELAXED);
+    __atomic_store_n(&rate, one_in, __ATOMIC_RELAXED);
+}
+
+/* the checker thread starts with the first sample; called with lock held */
+static int start_checker(void)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    if (started)
+        return 1;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    started = pthread_create(&thread, &attr, checker, NULL) == 0;
+    pthread_attr_destroy(&attr);
+    return started;
+}
+
+void multihash_crosscheck_sample(int algo, const multihash_params* params,
+                                 const void* input, size_t len, const void* output)
+{
+    uint32_t one_in = __atomic_load_n(&rate, __ATOMIC_RELAXED);
+    sample* s;
+
+    if (!one_in || next_random() % one_in != 0)
+        return;
+    /* boolberry's scratchpad belongs to the caller and may be gone by the time we look */
+    if (len > MULTIHASH_CROSSCHECK_INPUT_MAX || (params && params->scratchpad))
+        return;
+
+    pthread_mutex_lock(&lock);
+    if (tail - head == QUEUE_SIZE || !start_checker()) {
+        pthread_mutex_unlock(&lock);
+        __sync_fetch_and_add(&dropped[algo], 1);
+        return;
+    }
+    s = &queue[tail % QUEUE_SIZE];
+    s->algo = algo;
+    if (params)
+        s->params = *params;
+    else
+        memset(&s->params, 0, sizeof(s->params));
+    s->len = len;
+    memcpy(s->input, input, len);
+    memcpy(s->output, output, MULTIHASH_OUTPUT_SIZE);
+    tail++;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+
+    __sync_fetch_and_add(&sampled[algo], 1);
+}
+
+void multihash_crosscheck_flush(void)
+{
+    pthread_mutex_lock(&lock);
+    while (started && (head != tail || busy))
+        pthread_cond_wait(&cond, &lock);
+    pthread_mutex_unlock(&lock);
+}
+
+void multihash_crosscheck_get_stats(int algo, multihash_crosscheck_stats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (algo < 0 || algo >= MULTIHASH_ALGO_COUNT)
+        return;
+    stats->sampled = __atomic_load_n(&sampled[algo], __ATOMIC_RELAXED);
+    stats->checked = __atomic_load_n(&checked[algo], __ATOMIC_RELAXED);
+    stats->mismatches = __atomic_load_n(&mismatches[algo], __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&dropped[algo], __ATOMIC_RELAXED);
+    stats->fast_path = multihash_fast_path_enabled(algo);
+}
+
+int multihash_fast_path_enabled(int algo)
+{
+    return algo >= 0 && algo < MULTIHASH_ALGO_COUNT && !__atomic_load_n(&fast_path_off[algo], __ATOMIC_RELAXED);
+}
+
+void multihash_fast_path_enable(int algo, int enable)
+{
+    if (algo >= 0 && algo < MULTIHASH_ALGO_COUNT)
+        __atomic_store_n(&fast_path_off[algo], !enable, __ATOMIC_RELAXED);
+}
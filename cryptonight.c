@@ -2,7 +2,7 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
-#include "crypto/oaes_lib.h"
+#include "cryptonight.h"
 #include "crypto/c_keccak.h"
 #include "crypto/c_groestl.h"
 #include "crypto/c_blake256.h"
@@ -10,6 +10,13 @@
 #include "crypto/c_skein.h"
 #include "crypto/int-util.h"
 #include "crypto/hash-ops.h"
+#include "multihash.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
 
 #define MEMORY         (1 << 21) /* 2 MiB */
 #define ITER           (1 << 20)
@@ -50,130 +57,431 @@ static void (* const extra_hashes[4])(const void *, size_t, char *) = {
     do_blake_hash, do_groestl_hash, do_jh_hash, do_skein_hash
 };
 
-extern int aesb_single_round(const uint8_t *in, uint8_t*out, const uint8_t *expandedKey);
 extern int aesb_pseudo_round(const uint8_t *in, uint8_t *out, const uint8_t *expandedKey);
 
-static inline size_t e2i(const uint8_t* a) {
-    return (*((uint64_t*) a) / AES_BLOCK_SIZE) & (MEMORY / AES_BLOCK_SIZE - 1);
+/* the forward round tables of crypto/aesb.c */
+extern const uint32_t t_fn[4][256];
+
+/* byte offset of the 16 byte block a scratchpad address word points at */
+#define BLOCK_OFFSET(x) ((x) & (MEMORY - AES_BLOCK_SIZE))
+
+static inline void xor_blocks(uint8_t* a, const uint8_t* b) {
+    ((uint64_t*) a)[0] ^= ((uint64_t*) b)[0];
+    ((uint64_t*) a)[1] ^= ((uint64_t*) b)[1];
+}
+
+static inline uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
 }
 
-static void mul(const uint8_t* a, const uint8_t* b, uint8_t* res) {
-    ((uint64_t*) res)[1] = mul128(((uint64_t*) a)[0], ((uint64_t*) b)[0], (uint64_t*) res);
+/* the 64x64 -> 128 bit product: one mul on targets with 128 bit integers */
+static inline uint64_t mul64(uint64_t x, uint64_t y, uint64_t* hi) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128) x * y;
+    *hi = (uint64_t) (product >> 64);
+    return (uint64_t) product;
+#else
+    return mul128(x, y, hi);
+#endif
 }
 
-static void mul_sum_xor_dst(const uint8_t* a, uint8_t* c, uint8_t* dst) {
-    uint64_t hi, lo = mul128(((uint64_t*) a)[0], ((uint64_t*) dst)[0], &hi) + ((uint64_t*) c)[1];
-    hi += ((uint64_t*) c)[0];
+#define T(n, w, byte) t_fn[n][((w) >> (8 * (byte))) & 0xff]
+
+/*
+ * One AES round (aesb_single_round) of the block x0:x1 with the round key
+ * k0:k1, on 64 bit halves so the block and key stay in registers.
+ */
+static inline void aes_round(uint64_t x0, uint64_t x1, uint64_t k0, uint64_t k1, uint64_t* y0, uint64_t* y1) {
+    uint32_t w0 = (uint32_t) x0, w1 = (uint32_t) (x0 >> 32), w2 = (uint32_t) x1, w3 = (uint32_t) (x1 >> 32);
+    uint32_t r0 = T(0, w0, 0) ^ T(1, w1, 1) ^ T(2, w2, 2) ^ T(3, w3, 3);
+    uint32_t r1 = T(0, w1, 0) ^ T(1, w2, 1) ^ T(2, w3, 2) ^ T(3, w0, 3);
+    uint32_t r2 = T(0, w2, 0) ^ T(1, w3, 1) ^ T(2, w0, 2) ^ T(3, w1, 3);
+    uint32_t r3 = T(0, w3, 0) ^ T(1, w0, 1) ^ T(2, w1, 2) ^ T(3, w2, 3);
 
-    ((uint64_t*) c)[0] = ((uint64_t*) dst)[0] ^ hi;
-    ((uint64_t*) c)[1] = ((uint64_t*) dst)[1] ^ lo;
-    ((uint64_t*) dst)[0] = hi;
-    ((uint64_t*) dst)[1] = lo;
+    *y0 = ((uint64_t) r1 << 32 | r0) ^ k0;
+    *y1 = ((uint64_t) r3 << 32 | r2) ^ k1;
 }
 
-static void sum_half_blocks(uint8_t* a, const uint8_t* b) {
-    uint64_t a0, a1, b0, b1;
+#undef T
+
+/*
+ * The memory-hard loop. a and b (from the keccak state k) go round 2^19
+ * times; each round is one AES round on the block a points at, written back
+ * xored with b, then a 64x64 multiply-add with the block the result points
+ * at. The two scratchpad reads depend on each other, which is what bounds it.
+ *
+ * It is kept as a lane cut at those two reads, so a batch can run several
+ * with multihash_interleave: each stage ends with a prefetch of the block the
+ * next one reads. A single hash just runs the stages of one lane back to back.
+ */
+typedef struct main_lane {
+    uint8_t* long_state;
+    uint64_t a0, a1, b0, b1, c0, c1;
+    size_t i;
+    int mul_next;               /* the next stage is the multiply-add */
+} main_lane;
 
-    a0 = SWAP64LE(((uint64_t*) a)[0]);
-    a1 = SWAP64LE(((uint64_t*) a)[1]);
-    b0 = SWAP64LE(((uint64_t*) b)[0]);
-    b1 = SWAP64LE(((uint64_t*) b)[1]);
-    a0 += b0;
-    a1 += b1;
-    ((uint64_t*) a)[0] = SWAP64LE(a0);
-    ((uint64_t*) a)[1] = SWAP64LE(a1);
+static void lane_start(main_lane* l, uint8_t* long_state, const uint8_t* k) {
+    l->long_state = long_state;
+    l->a0 = load64(k) ^ load64(k + 32);
+    l->a1 = load64(k + 8) ^ load64(k + 40);
+    l->b0 = load64(k + 16) ^ load64(k + 48);
+    l->b1 = load64(k + 24) ^ load64(k + 56);
+    l->c0 = l->c1 = 0;
+    l->i = 0;
+    l->mul_next = 0;
+    __builtin_prefetch(long_state + BLOCK_OFFSET(l->a0), 1);
 }
 
-static inline void copy_block(uint8_t* dst, const uint8_t* src) {
-    ((uint64_t*) dst)[0] = ((uint64_t*) src)[0];
-    ((uint64_t*) dst)[1] = ((uint64_t*) src)[1];
+/* the multiply-add with the block c points at; 0 once the last round is done */
+static inline int lane_mul(main_lane* l) {
+    uint64_t* p = (uint64_t*) (l->long_state + BLOCK_OFFSET(l->c0));
+    uint64_t d0 = p[0], d1 = p[1], hi, lo;
+
+    lo = mul64(l->c0, d0, &hi);
+    l->a0 += hi;
+    l->a1 += lo;
+    p[0] = l->a0;
+    p[1] = l->a1;
+    l->a0 ^= d0;
+    l->a1 ^= d1;
+    l->b0 = l->c0;
+    l->b1 = l->c1;
+
+    __builtin_prefetch(l->long_state + BLOCK_OFFSET(l->a0), 1);
+    l->mul_next = 0;
+    return ++l->i < ITER / 2;
 }
 
-static void swap_blocks(uint8_t* a, uint8_t* b) {
-    size_t i;
-    uint8_t t;
-    for (i = 0; i < AES_BLOCK_SIZE; i++) {
-        t = a[i];
-        a[i] = b[i];
-        b[i] = t;
-    }
+static int main_step(void* lane) {
+    main_lane* l = (main_lane*) lane;
+    uint64_t* p;
+
+    if (l->mul_next)
+        return lane_mul(l);
+
+    p = (uint64_t*) (l->long_state + BLOCK_OFFSET(l->a0));
+    aes_round(p[0], p[1], l->a0, l->a1, &l->c0, &l->c1);
+    p[0] = l->c0 ^ l->b0;
+    p[1] = l->c1 ^ l->b1;
+
+    __builtin_prefetch(l->long_state + BLOCK_OFFSET(l->c0), 1);
+    l->mul_next = 1;
+    return 1;
 }
 
-static inline void xor_blocks(uint8_t* a, const uint8_t* b) {
-    ((uint64_t*) a)[0] ^= ((uint64_t*) b)[0];
-    ((uint64_t*) a)[1] ^= ((uint64_t*) b)[1];
+static void main_loop(uint8_t* long_state, const uint8_t* k) {
+    main_lane lane;
+
+    lane_start(&lane, long_state, k);
+    while (main_step(&lane))
+        ;
+}
+
+/* the pseudo rounds use the first 10 of the 15 AES-256 round keys */
+#define ROUND_KEYS 10
+
+/* S-box of each byte of w; byte 1 of a t_fn[0] entry is the S-box value of its index */
+static uint32_t sub_word(uint32_t w) {
+    return ((t_fn[0][w & 0xff] >> 8) & 0xff) |
+           (t_fn[0][(w >> 8) & 0xff] & 0xff00) |
+           ((t_fn[0][(w >> 16) & 0xff] << 8) & 0xff0000) |
+           ((t_fn[0][w >> 24] << 16) & 0xff000000);
 }
 
-static inline void xor_blocks_dst(const uint8_t* a, const uint8_t* b, uint8_t* dst) {
-    ((uint64_t*) dst)[0] = ((uint64_t*) a)[0] ^ ((uint64_t*) b)[0];
-    ((uint64_t*) dst)[1] = ((uint64_t*) a)[1] ^ ((uint64_t*) b)[1];
+/* AES-256 key expansion into the round keys aesb_pseudo_round reads */
+static void expand_key(const uint8_t* key, uint32_t* w) {
+    static const uint8_t rcon[4] = { 0x01, 0x02, 0x04, 0x08 };
+    uint32_t t;
+    size_t i;
+
+    memcpy(w, key, AES_KEY_SIZE);
+    for (i = AES_KEY_SIZE / 4; i < ROUND_KEYS * 4; i++) {
+        t = w[i - 1];
+        if (i % 8 == 0)
+            t = sub_word(t >> 8 | t << 24) ^ rcon[i / 8 - 1];
+        else if (i % 8 == 4)
+            t = sub_word(t);
+        w[i] = w[i - 8] ^ t;
+    }
 }
 
 struct cryptonight_ctx {
     uint8_t long_state[MEMORY];
     union cn_slow_hash_state state;
     uint8_t text[INIT_SIZE_BYTE];
-    uint8_t a[AES_BLOCK_SIZE];
-    uint8_t b[AES_BLOCK_SIZE];
-    uint8_t c[AES_BLOCK_SIZE];
-    uint8_t aes_key[AES_KEY_SIZE];
-    oaes_ctx* aes_ctx;
 };
 
-void cryptonight_hash(const char* input, char* output, uint32_t len) {
-    struct cryptonight_ctx *ctx = alloca(sizeof(struct cryptonight_ctx));
-    hash_process(&ctx->state.hs, (const uint8_t*) input, len);
-    memcpy(ctx->text, ctx->state.init, INIT_SIZE_BYTE);
-    memcpy(ctx->aes_key, ctx->state.hs.b, AES_KEY_SIZE);
-    ctx->aes_ctx = (oaes_ctx*) oaes_alloc();
+/* scratchpad fill from the keccak state, on the aesb tables */
+static void explode_portable(struct cryptonight_ctx* ctx) {
+    uint32_t round_keys[ROUND_KEYS * 4];
     size_t i, j;
 
-    oaes_key_import_data(ctx->aes_ctx, ctx->aes_key, AES_KEY_SIZE);
+    memcpy(ctx->text, ctx->state.init, INIT_SIZE_BYTE);
+    expand_key(ctx->state.hs.b, round_keys);
     for (i = 0; i < MEMORY / INIT_SIZE_BYTE; i++) {
         for (j = 0; j < INIT_SIZE_BLK; j++) {
             aesb_pseudo_round(&ctx->text[AES_BLOCK_SIZE * j],
                     &ctx->text[AES_BLOCK_SIZE * j],
-                    ctx->aes_ctx->key->exp_data);
+                    (const uint8_t*) round_keys);
         }
         memcpy(&ctx->long_state[i * INIT_SIZE_BYTE], ctx->text, INIT_SIZE_BYTE);
     }
+}
 
-    for (i = 0; i < 16; i++) {
-        ctx->a[i] = ctx->state.k[i] ^ ctx->state.k[32 + i];
-        ctx->b[i] = ctx->state.k[16 + i] ^ ctx->state.k[48 + i];
-    }
-
-    for (i = 0; i < ITER / 2; i++) {
-        /* Dependency chain: address -> read value ------+
-         * written value <-+ hard function (AES or MUL) <+
-         * next address  <-+
-         */
-        /* Iteration 1 */
-        j = e2i(ctx->a);
-        aesb_single_round(&ctx->long_state[j * AES_BLOCK_SIZE], ctx->c, ctx->a);
-        xor_blocks_dst(ctx->c, ctx->b, &ctx->long_state[j * AES_BLOCK_SIZE]);
-        /* Iteration 2 */
-        mul_sum_xor_dst(ctx->c, ctx->a,
-                &ctx->long_state[e2i(ctx->c) * AES_BLOCK_SIZE]);
-        copy_block(ctx->b, ctx->c);
-    }
+/* scratchpad folded back into the keccak state */
+static void implode_portable(struct cryptonight_ctx* ctx) {
+    uint32_t round_keys[ROUND_KEYS * 4];
+    size_t i, j;
 
     memcpy(ctx->text, ctx->state.init, INIT_SIZE_BYTE);
-    oaes_key_import_data(ctx->aes_ctx, &ctx->state.hs.b[32], AES_KEY_SIZE);
+    expand_key(&ctx->state.hs.b[32], round_keys);
     for (i = 0; i < MEMORY / INIT_SIZE_BYTE; i++) {
         for (j = 0; j < INIT_SIZE_BLK; j++) {
             xor_blocks(&ctx->text[j * AES_BLOCK_SIZE],
                     &ctx->long_state[i * INIT_SIZE_BYTE + j * AES_BLOCK_SIZE]);
             aesb_pseudo_round(&ctx->text[j * AES_BLOCK_SIZE],
                     &ctx->text[j * AES_BLOCK_SIZE],
-                    ctx->aes_ctx->key->exp_data);
+                    (const uint8_t*) round_keys);
         }
     }
     memcpy(ctx->state.init, ctx->text, INIT_SIZE_BYTE);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define HAVE_AESNI
+
+/*
+ * The same steps on the AES-NI instructions, compiled for them whatever the
+ * target flags and only run when cpuid reports them. The round keys and the
+ * eight blocks of text stay in xmm registers.
+ */
+#define AESNI __attribute__((target("aes,sse2")))
+
+static AESNI inline __m128i expand_step(__m128i k, __m128i assist) {
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    return _mm_xor_si128(k, assist);
+}
+
+/* round keys 2n and 2n + 1 from the two before them (aeskeygenassist wants rcon as an immediate) */
+#define EXPAND_PAIR(k, n, rcon) do { \
+        k[2 * (n)] = expand_step(k[2 * (n) - 2], \
+                _mm_shuffle_epi32(_mm_aeskeygenassist_si128(k[2 * (n) - 1], rcon), 0xff)); \
+        k[2 * (n) + 1] = expand_step(k[2 * (n) - 1], \
+                _mm_shuffle_epi32(_mm_aeskeygenassist_si128(k[2 * (n)], 0x00), 0xaa)); \
+    } while (0)
+
+static AESNI void expand_key_aesni(const uint8_t* key, __m128i* k) {
+    k[0] = _mm_loadu_si128((const __m128i*) key);
+    k[1] = _mm_loadu_si128((const __m128i*) (key + 16));
+    EXPAND_PAIR(k, 1, 0x01);
+    EXPAND_PAIR(k, 2, 0x02);
+    EXPAND_PAIR(k, 3, 0x04);
+    EXPAND_PAIR(k, 4, 0x08);
+}
+
+#undef EXPAND_PAIR
+
+static AESNI void explode_aesni(struct cryptonight_ctx* ctx) {
+    __m128i k[ROUND_KEYS], x[INIT_SIZE_BLK];
+    __m128i* block;
+    size_t i, j, r;
+
+    for (j = 0; j < INIT_SIZE_BLK; j++)
+        x[j] = _mm_loadu_si128((const __m128i*) &ctx->state.init[j * AES_BLOCK_SIZE]);
+    expand_key_aesni(ctx->state.hs.b, k);
+    for (i = 0; i < MEMORY / INIT_SIZE_BYTE; i++) {
+        for (r = 0; r < ROUND_KEYS; r++)
+            for (j = 0; j < INIT_SIZE_BLK; j++)
+                x[j] = _mm_aesenc_si128(x[j], k[r]);
+        block = (__m128i*) &ctx->long_state[i * INIT_SIZE_BYTE];
+        for (j = 0; j < INIT_SIZE_BLK; j++)
+            _mm_storeu_si128(&block[j], x[j]);
+    }
+}
+
+/* main_step with the AES round on aesenc */
+static AESNI int main_step_aesni(void* lane) {
+    main_lane* l = (main_lane*) lane;
+    __m128i* p;
+    __m128i c;
+
+    if (l->mul_next)
+        return lane_mul(l);
+
+    p = (__m128i*) (l->long_state + BLOCK_OFFSET(l->a0));
+    c = _mm_aesenc_si128(_mm_loadu_si128(p), _mm_set_epi64x((long long) l->a1, (long long) l->a0));
+    _mm_storeu_si128(p, _mm_xor_si128(c, _mm_set_epi64x((long long) l->b1, (long long) l->b0)));
+    l->c0 = (uint64_t) _mm_cvtsi128_si64(c);
+    l->c1 = (uint64_t) _mm_cvtsi128_si64(_mm_unpackhi_epi64(c, c));
+
+    __builtin_prefetch(l->long_state + BLOCK_OFFSET(l->c0), 1);
+    l->mul_next = 1;
+    return 1;
+}
+
+static AESNI void main_loop_aesni(uint8_t* long_state, const uint8_t* k) {
+    main_lane lane;
+
+    lane_start(&lane, long_state, k);
+    while (main_step_aesni(&lane))
+        ;
+}
+
+static AESNI void implode_aesni(struct cryptonight_ctx* ctx) {
+    __m128i k[ROUND_KEYS], x[INIT_SIZE_BLK];
+    __m128i* block;
+    size_t i, j, r;
+
+    for (j = 0; j < INIT_SIZE_BLK; j++)
+        x[j] = _mm_loadu_si128((const __m128i*) &ctx->state.init[j * AES_BLOCK_SIZE]);
+    expand_key_aesni(&ctx->state.hs.b[32], k);
+    for (i = 0; i < MEMORY / INIT_SIZE_BYTE; i++) {
+        block = (__m128i*) &ctx->long_state[i * INIT_SIZE_BYTE];
+        for (j = 0; j < INIT_SIZE_BLK; j++)
+            x[j] = _mm_xor_si128(x[j], _mm_loadu_si128(&block[j]));
+        for (r = 0; r < ROUND_KEYS; r++)
+            for (j = 0; j < INIT_SIZE_BLK; j++)
+                x[j] = _mm_aesenc_si128(x[j], k[r]);
+    }
+    for (j = 0; j < INIT_SIZE_BLK; j++)
+        _mm_storeu_si128((__m128i*) &ctx->state.init[j * AES_BLOCK_SIZE], x[j]);
+}
+
+static int cpu_has_aesni(void) {
+    static int has = -1;
+    unsigned eax, ebx, ecx, edx;
+
+    if (has == -1)
+        has = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES) && (edx & bit_SSE2);
+    return has;
+}
+#endif
+
+typedef struct cryptonight_variant {
+    const char* name;
+    void (*explode)(struct cryptonight_ctx* ctx);
+    void (*main_loop)(uint8_t* long_state, const uint8_t* k);
+    multihash_step_fn main_step;
+    void (*implode)(struct cryptonight_ctx* ctx);
+} cryptonight_variant;
+
+static const cryptonight_variant variants[] = {
+#ifdef HAVE_AESNI
+    { "aesni", explode_aesni, main_loop_aesni, main_step_aesni, implode_aesni },
+#endif
+    { "portable", explode_portable, main_loop, main_step, implode_portable },
+};
+
+#define VARIANT_COUNT (int) (sizeof(variants) / sizeof(variants[0]))
+#define VARIANT_PORTABLE (VARIANT_COUNT - 1)
+
+/* index of the pinned variant, -1 for the cpu default */
+static int variant_pinned = -1;
+
+static int variant_supported(int index) {
+    if (index < 0 || index >= VARIANT_COUNT)
+        return 0;
+#ifdef HAVE_AESNI
+    if (variants[index].main_step == main_step_aesni)
+        return cpu_has_aesni();
+#endif
+    return 1;
+}
+
+int cryptonight_variant_count(void) {
+    return VARIANT_COUNT;
+}
+
+const char* cryptonight_variant_name(int index) {
+    return variant_supported(index) ? variants[index].name : NULL;
+}
+
+int cryptonight_select_variant(int index) {
+    if (index != -1 && !variant_supported(index))
+        return -1;
+    __atomic_store_n(&variant_pinned, index, __ATOMIC_RELAXED);
+    return 0;
+}
+
+int cryptonight_selected_variant(void) {
+    int index = __atomic_load_n(&variant_pinned, __ATOMIC_RELAXED);
+    if (index >= 0)
+        return index;
+    for (index = 0; !variant_supported(index); index++)
+        ;
+    return index;
+}
+
+struct cryptonight_ctx* cryptonight_alloc_ctx(void) {
+    return (struct cryptonight_ctx*) malloc(sizeof(struct cryptonight_ctx));
+}
+
+void cryptonight_free_ctx(struct cryptonight_ctx* ctx) {
+    free(ctx);
+}
+
+size_t cryptonight_ctx_size(void) {
+    return sizeof(struct cryptonight_ctx);
+}
+
+void cryptonight_hash(const char* input, char* output, uint32_t len) {
+    struct cryptonight_ctx *ctx = alloca(sizeof(struct cryptonight_ctx));
+    cryptonight_hash_ctx(input, output, len, ctx);
+}
+
+static void hash_variant(const char* input, char* output, uint32_t len, struct cryptonight_ctx* ctx, int variant) {
+    const cryptonight_variant* v = &variants[variant];
+
+    multihash_flight_mark(MULTIHASH_PHASE_INIT);
+    hash_process(&ctx->state.hs, (const uint8_t*) input, len);
+    v->explode(ctx);
+
+    multihash_flight_mark(MULTIHASH_PHASE_MAIN);
+    v->main_loop(ctx->long_state, ctx->state.k);
+
+    multihash_flight_mark(MULTIHASH_PHASE_FINAL);
+    v->implode(ctx);
     hash_permutation(&ctx->state.hs);
     /*memcpy(hash, &state, 32);*/
     extra_hashes[ctx->state.hs.b[0] & 3](&ctx->state, 200, output);
-    oaes_free((OAES_CTX **) &ctx->aes_ctx);
+}
+
+void cryptonight_hash_ctx(const char* input, char* output, uint32_t len, struct cryptonight_ctx* ctx) {
+    hash_variant(input, output, len, ctx, cryptonight_selected_variant());
+}
+
+void cryptonight_hash_ctx_reference(const char* input, char* output, uint32_t len, struct cryptonight_ctx* ctx) {
+    hash_variant(input, output, len, ctx, VARIANT_PORTABLE);
+}
+
+void cryptonight_hash_interleaved(const char* inputs, size_t stride, uint32_t len, size_t count,
+                                  char* outputs, struct cryptonight_ctx* ctxs) {
+    const cryptonight_variant* v = &variants[cryptonight_selected_variant()];
+    main_lane lanes[MULTIHASH_INTERLEAVE_MAX];
+    size_t done, n, i;
+
+    for (done = 0; done < count; done += n) {
+        n = count - done < MULTIHASH_INTERLEAVE_MAX ? count - done : MULTIHASH_INTERLEAVE_MAX;
+
+        for (i = 0; i < n; i++) {
+            hash_process(&ctxs[i].state.hs, (const uint8_t*) inputs + (done + i) * stride, len);
+            v->explode(&ctxs[i]);
+            lane_start(&lanes[i], ctxs[i].long_state, ctxs[i].state.k);
+        }
+
+        multihash_interleave(v->main_step, lanes, sizeof(main_lane), n);
+
+        for (i = 0; i < n; i++) {
+            v->implode(&ctxs[i]);
+            hash_permutation(&ctxs[i].state.hs);
+            extra_hashes[ctxs[i].state.hs.b[0] & 3](&ctxs[i].state, 200, outputs + (done + i) * HASH_SIZE);
+        }
+    }
 }
 
 void cryptonight_fast_hash(const char* input, char* output, uint32_t len) {
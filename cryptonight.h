@@ -5,11 +5,43 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 
+struct cryptonight_ctx;
+
 void cryptonight_hash(const char* input, char* output, uint32_t len);
 void cryptonight_fast_hash(const char* input, char* output, uint32_t len);
 
+/* Reusable 2 MiB scratchpad, so callers can avoid a fresh alloca per hash */
+struct cryptonight_ctx* cryptonight_alloc_ctx(void);
+void cryptonight_free_ctx(struct cryptonight_ctx* ctx);
+size_t cryptonight_ctx_size(void);
+void cryptonight_hash_ctx(const char* input, char* output, uint32_t len, struct cryptonight_ctx* ctx);
+
+/*
+	The AES kernels built in (aesni on x86-64, portable), fastest first. By default
+	the first one the cpu supports runs; cryptonight_select_variant pins another, -1
+	returns to the default. cryptonight_variant_name is NULL for kernels this cpu
+	cannot run, which cryptonight_select_variant refuses with -1.
+*/
+int cryptonight_variant_count(void);
+const char* cryptonight_variant_name(int index);
+int cryptonight_select_variant(int index);
+int cryptonight_selected_variant(void);
+
+/* cryptonight_hash_ctx on the portable kernel, whatever variant is selected */
+void cryptonight_hash_ctx_reference(const char* input, char* output, uint32_t len, struct cryptonight_ctx* ctx);
+
+/*
+	Hashes count inputs, len bytes each and stride bytes apart, into consecutive 32 byte
+	outputs, running up to MULTIHASH_INTERLEAVE_MAX main loops at a time interleaved (see
+	multihash_interleave). ctxs is an array of that many contexts, e.g. one allocation of
+	that many times cryptonight_ctx_size().
+*/
+void cryptonight_hash_interleaved(const char* inputs, size_t stride, uint32_t len, size_t count,
+                                  char* outputs, struct cryptonight_ctx* ctxs);
+
 #ifdef __cplusplus
 }
 #endif
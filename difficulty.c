@@ -0,0 +1,108 @@
+#include "multihash.h"
+
+#include <math.h>
+#include <string.h>
+
+static uint64_t load_le64(const uint8_t* p)
+{
+    return (uint64_t) p[0]       | (uint64_t) p[1] << 8  | (uint64_t) p[2] << 16 | (uint64_t) p[3] << 24 |
+           (uint64_t) p[4] << 32 | (uint64_t) p[5] << 40 | (uint64_t) p[6] << 48 | (uint64_t) p[7] << 56;
+}
+
+/*
+ * Correctly rounded conversion of a 256 bit little endian integer: the 64 bits
+ * below the leading one go through the uint64 -> double conversion, with
+ * anything further down folded into a sticky bit so the rounding matches a
+ * bignum's toNumber().
+ */
+double multihash_le256_to_double(const void* value)
+{
+    const uint8_t* b = (const uint8_t*) value;
+    uint64_t w[4], m, sticky = 0;
+    int top, lz = 0, i;
+
+    for (i = 0; i < 4; i++)
+        w[i] = load_le64(b + 8 * i);
+
+    for (top = 3; top >= 0 && w[top] == 0; top--)
+        ;
+    if (top < 0)
+        return 0.0;
+
+    while (!(w[top] & ((uint64_t) 1 << (63 - lz))))
+        lz++;
+
+    m = w[top] << lz;
+    if (top > 0) {
+        if (lz)
+            m |= w[top - 1] >> (64 - lz);
+        sticky = lz ? w[top - 1] << lz : w[top - 1];
+        for (i = top - 2; i >= 0; i--)
+            sticky |= w[i];
+    }
+    if (sticky)
+        m |= 1;
+
+    return ldexp((double) m, top * 64 - lz);
+}
+
+double multihash_hash_to_difficulty(const void* hash, double diff1)
+{
+    return diff1 / multihash_le256_to_double(hash);
+}
+
+void multihash_hash_to_difficulty_batch(const void* hashes, size_t count, double diff1, double* difficulties)
+{
+    const uint8_t* h = (const uint8_t*) hashes;
+    size_t i;
+
+    for (i = 0; i < count; i++)
+        difficulties[i] = diff1 / multihash_le256_to_double(h + i * MULTIHASH_OUTPUT_SIZE);
+}
+
+int multihash_meets_target(const void* hash, const void* target)
+{
+    const uint8_t* h = (const uint8_t*) hash;
+    const uint8_t* t = (const uint8_t*) target;
+    int i;
+
+    for (i = 31; i >= 0; i--)
+        if (h[i] != t[i])
+            return h[i] < t[i];
+    return 1;
+}
+
+int multihash_nbits_to_target(uint32_t nbits, void* target)
+{
+    uint8_t* t = (uint8_t*) target;
+    uint32_t mantissa = nbits & 0x007fffff;
+    int size = (int) (nbits >> 24), i;
+
+    memset(t, 0, 32);
+    if (nbits & 0x00800000)
+        return MULTIHASH_EINVAL;            /* negative */
+
+    /* mantissa * 256^(size - 3), byte by byte */
+    for (i = 0; i < 3; i++) {
+        uint8_t byte = (uint8_t) (mantissa >> (8 * i));
+        int at = size - 3 + i;
+
+        if (at < 0 || !byte)
+            continue;
+        if (at >= 32) {
+            memset(t, 0, 32);
+            return MULTIHASH_EINVAL;        /* overflow */
+        }
+        t[at] = byte;
+    }
+    return MULTIHASH_OK;
+}
+
+void multihash_meets_target_batch(const void* hashes, size_t count, const void* target, uint8_t* results)
+{
+    const uint8_t* h = (const uint8_t*) hashes;
+    size_t i;
+
+    for (i = 0; i < count; i++)
+        results[i] = (uint8_t) multihash_meets_target(h + i * MULTIHASH_OUTPUT_SIZE, target);
+}
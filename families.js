@@ -0,0 +1,233 @@
+/*
+    Besides the complete multihashing.node, binding.gyp builds one native module per
+    algorithm family plus a small core (difficulty, share filter, memory budget). A
+    process only maps the families it actually calls, so a scrypt pool never loads
+    the sph tables or the cryptonote code.
+*/
+
+var bindings = require('bindings');
+
+var families = {
+    sph: ['quark', 'x11', 'keccak', 'skein', 'groestl', 'groestlmyriad', 'blake', 'fugue', 'qubit',
+          'hefty1', 'shavite3', 'x13', 'nist5', 'x15', 'fresh', 'sophia', 'chain',
+          'keccakInto', 'blakeInto', 'skeinInto', 'groestlInto'],
+    scrypt: ['scrypt', 'scryptn', 'scryptjane'],
+    cryptonote: ['cryptonight', 'boolberry', 'cryptonightFastInto'],
+    misc: ['bcrypt', 'sha1'],
+    core: ['hashToDifficulty', 'hashToDifficultyBatch', 'meetsTarget', 'meetsTargetBatch',
+           'shareFilter', 'setMemoryBudget', 'memoryUsage', 'algorithms',
+           'recordSlowHashes', 'slowHashes', 'clearSlowHashes']
+};
+
+/* algorithm names as in multihash.h, for hashBatch */
+var algorithmFamilies = {
+    scrypt: 'scrypt', scryptn: 'scrypt', scryptjane: 'scrypt',
+    cryptonight: 'cryptonote', cryptonightfast: 'cryptonote', boolberry: 'cryptonote',
+    bcrypt: 'misc', sha1: 'misc'
+};
+
+var loaded = {};
+
+/* families also built for x86-64-v2 and -v3 (binding.gyp), and the level each was loaded at */
+var tiered = {sph: true, scrypt: true, cryptonote: true, all: true};
+var levels = {};
+var cpuLevel = null;
+
+/* algorithm name -> kernel variant in effect, seeded from the tune cache file */
+var variants = null;
+
+/* crossCheck options in effect, for modules loaded later */
+var crossCheckOptions = null;
+
+/* algorithms (and 'chain') being profiled, for modules loaded later */
+var profiled = {};
+
+var counterNames = ['cycles', 'instructions', 'l1dMisses', 'llcReferences', 'llcMisses', 'dtlbMisses'];
+
+function familyOf(algo){
+    var name = typeof algo === 'number' ? load('core').algorithms[algo] : algo;
+    return algorithmFamilies[name] || 'sph';
+}
+
+/* a variant the cpu cannot run (cache copied from another host) keeps the default */
+function applyVariant(module, algo, name){
+    try {
+        module.selectVariant(algo, name);
+    }
+    catch (e){
+    }
+}
+
+/*
+    The highest x86-64 level both the cpu and MULTIHASHING_ISA (1, 2 or 3, to hold a
+    process at a lower one) allow.
+*/
+function isaLevel(){
+    if (cpuLevel === null){
+        cpuLevel = load('core').isaLevel().cpu;
+        var cap = parseInt(process.env.MULTIHASHING_ISA, 10);
+        if (cap > 0)
+            cpuLevel = Math.min(cpuLevel, cap);
+    }
+    return cpuLevel;
+}
+
+/* the module built for the highest level this host runs; builds without the tiers fall back to the baseline */
+function loadTiered(family){
+    var base = family === 'all' ? 'multihashing' : 'multihashing_' + family;
+    var module = null;
+
+    for (var level = tiered[family] ? isaLevel() : 1; level > 1 && !module; level--){
+        try {
+            module = bindings(base + '_v' + level + '.node');
+        }
+        catch (e){
+        }
+    }
+    module = module || bindings(base + '.node');
+    levels[family] = module.isaLevel().built;
+    return module;
+}
+
+function load(family){
+    if (loaded[family])
+        return loaded[family];
+
+    var module = family === 'core' ? bindings('multihashing_core.node') : loadTiered(family);
+
+    /* one memory budget, one slow-hash table and one scheduler for the process, not one per module */
+    if (family !== 'core'){
+        module.useMemoryGovernor(load('core').memoryGovernor());
+        module.useFlightRecorder(load('core').flightRecorder());
+        module.useScheduler(load('core').scheduler());
+    }
+
+    if (!variants)
+        variants = Object.assign({}, require('./tune').cached().variants);
+    Object.keys(variants).forEach(function(algo){
+        if (family === 'all' || familyOf(algo) === family)
+            applyVariant(module, algo, variants[algo]);
+    });
+
+    if (crossCheckOptions)
+        module.crossCheck(crossCheckOptions);
+    Object.keys(profiled).forEach(function(algo){
+        if (family === 'all' || familyOf(algo) === family)
+            module.profile(algo, true);
+    });
+
+    return loaded[family] = module;
+}
+
+function forAlgorithm(algo){
+    return load(familyOf(algo));
+}
+
+/* the algorithm's family module, and the complete module when HashRing loaded it */
+function carriers(algo){
+    var module = forAlgorithm(algo);
+    return loaded.all && loaded.all !== module ? [module, loaded.all] : [module];
+}
+
+function crossCheck(options){
+    crossCheckOptions = options;
+    Object.keys(loaded).forEach(function(family){
+        loaded[family].crossCheck(options);
+    });
+}
+
+/* each module samples the hashes it computes itself, so the counts add up */
+function crossCheckStats(algo, flush){
+    var total = {sampled: 0, checked: 0, mismatches: 0, dropped: 0, fastPath: true};
+    carriers(algo).forEach(function(module){
+        var stats = module.crossCheckStats(algo, flush);
+        total.sampled += stats.sampled;
+        total.checked += stats.checked;
+        total.mismatches += stats.mismatches;
+        total.dropped += stats.dropped;
+        total.fastPath = total.fastPath && stats.fastPath;
+    });
+    return total;
+}
+
+function setFastPath(algo, enabled){
+    carriers(algo).forEach(function(module){
+        module.setFastPath(algo, enabled);
+    });
+}
+
+/* algos: a name, 'chain' or a list of them */
+function profile(algos, enabled){
+    enabled = enabled !== false;
+    [].concat(algos).forEach(function(algo){
+        var key = typeof algo === 'number' ? load('core').algorithms[algo] : algo;
+        carriers(algo).forEach(function(module){
+            module.profile(algo, enabled);
+        });
+        if (enabled)
+            profiled[key] = true;
+        else
+            delete profiled[key];
+    });
+}
+
+/* each module counts the calls it runs itself, so the totals add up */
+function profileStats(algo){
+    var total = {calls: 0, hashes: 0, counted: 0, available: [], error: null};
+
+    counterNames.forEach(function(name){ total[name] = null; });
+    carriers(algo).forEach(function(module){
+        var stats = module.profileStats(algo);
+        total.calls += stats.calls;
+        total.hashes += stats.hashes;
+        total.counted += stats.counted;
+        counterNames.forEach(function(name){
+            if (stats[name] !== null)
+                total[name] = (total[name] || 0) + stats[name];
+        });
+        stats.available.forEach(function(name){
+            if (total.available.indexOf(name) < 0)
+                total.available.push(name);
+        });
+        total.error = total.error || stats.error;
+    });
+    total.ipc = total.cycles ? total.instructions / total.cycles : null;
+    return total;
+}
+
+function profileReset(){
+    Object.keys(loaded).forEach(function(family){
+        loaded[family].profileReset();
+    });
+}
+
+/* every loaded module carrying the algorithm runs its own copy of the kernels */
+function selectVariant(algo, name){
+    var modules = carriers(algo);
+    var key = typeof algo === 'number' ? load('core').algorithms[algo] : algo;
+
+    modules[0].selectVariant(algo, name);
+    if (name == null)
+        delete variants[key];
+    else
+        variants[key] = name;
+    if (modules[1])
+        applyVariant(modules[1], algo, name);
+}
+
+/* {cpu, families: {sph: 3, ...}}: the level of the cpu and of every loaded module */
+function isaLevels(){
+    return {cpu: isaLevel(), families: Object.assign({}, levels)};
+}
+
+exports.families = families;
+exports.isaLevels = isaLevels;
+exports.load = load;
+exports.forAlgorithm = forAlgorithm;
+exports.selectVariant = selectVariant;
+exports.crossCheck = crossCheck;
+exports.crossCheckStats = crossCheckStats;
+exports.setFastPath = setFastPath;
+exports.profile = profile;
+exports.profileStats = profileStats;
+exports.profileReset = profileReset;
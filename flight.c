@@ -0,0 +1,246 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     /* RUSAGE_THREAD, sched_getcpu */
+#endif
+
+#include "multihash.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+/*
+ * Flight recorder for the memory-hard calls (see multihash_flight_configure).
+ * Every such call is timed phase by phase on its own thread; only a call slow
+ * enough to displace one of the kept records, or arriving after the oldest
+ * one left the window, takes the lock. Like the memory governor, the table
+ * can be shared by the copies of the library in the per-family modules.
+ */
+
+#define DEFAULT_CAPACITY 32
+#define DEFAULT_WINDOW_NS (60 * 1000000000ull)
+
+typedef struct recorder_state {
+    pthread_mutex_t lock;
+    size_t capacity;
+    uint64_t window_ns;
+    size_t used;
+    uint64_t threshold;             /* a call must take longer to be kept; 0 while there is room */
+    uint64_t expiry;                /* when the oldest record leaves the window */
+    multihash_flight_record records[MULTIHASH_FLIGHT_MAX];
+    uint64_t started[MULTIHASH_FLIGHT_MAX];  /* CLOCK_MONOTONIC start of each record */
+} recorder_state;
+
+static recorder_state own_recorder = {
+    PTHREAD_MUTEX_INITIALIZER, DEFAULT_CAPACITY, DEFAULT_WINDOW_NS, 0, 0, UINT64_MAX, { { 0 } }, { 0 }
+};
+static recorder_state* recorder = &own_recorder;
+
+/* the call in progress on this thread */
+static __thread struct {
+    int active;
+    uint64_t marks[MULTIHASH_PHASE_COUNT];
+    struct rusage usage;
+    uint64_t wall;
+} current;
+
+static uint64_t now_ns(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void thread_usage(struct rusage* usage)
+{
+#ifdef RUSAGE_THREAD
+    getrusage(RUSAGE_THREAD, usage);
+#else
+    getrusage(RUSAGE_SELF, usage);
+#endif
+}
+
+void* multihash_flight_recorder(void)
+{
+    return recorder;
+}
+
+void multihash_flight_use_recorder(void* other)
+{
+    recorder = other ? (recorder_state*) other : &own_recorder;
+}
+
+int multihash_flight_configure(size_t capacity, uint64_t window_ms)
+{
+    if (capacity > MULTIHASH_FLIGHT_MAX || window_ms == 0)
+        return MULTIHASH_EINVAL;
+
+    pthread_mutex_lock(&recorder->lock);
+    recorder->capacity = capacity;
+    recorder->window_ns = window_ms * 1000000ull;
+    recorder->used = 0;
+    __atomic_store_n(&recorder->threshold, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&recorder->expiry, UINT64_MAX, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&recorder->lock);
+    return MULTIHASH_OK;
+}
+
+void multihash_flight_reset(void)
+{
+    pthread_mutex_lock(&recorder->lock);
+    recorder->used = 0;
+    __atomic_store_n(&recorder->threshold, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&recorder->expiry, UINT64_MAX, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&recorder->lock);
+}
+
+/* drops what left the window; then threshold and expiry for the records that remain */
+static void expire(recorder_state* r, uint64_t now)
+{
+    uint64_t threshold = UINT64_MAX, oldest = UINT64_MAX;
+    size_t i = 0;
+
+    while (i < r->used) {
+        if (r->started[i] + r->window_ns <= now) {
+            r->used--;
+            r->records[i] = r->records[r->used];
+            r->started[i] = r->started[r->used];
+            continue;
+        }
+        if (r->records[i].total_ns < threshold)
+            threshold = r->records[i].total_ns;
+        if (r->started[i] < oldest)
+            oldest = r->started[i];
+        i++;
+    }
+
+    __atomic_store_n(&r->threshold, r->used < r->capacity ? 0 : threshold, __ATOMIC_RELAXED);
+    __atomic_store_n(&r->expiry, r->used ? oldest + r->window_ns : UINT64_MAX, __ATOMIC_RELAXED);
+}
+
+size_t multihash_flight_dump(multihash_flight_record* records, size_t max)
+{
+    recorder_state* r = recorder;
+    multihash_flight_record record;
+    uint64_t started;
+    size_t count, i, j;
+
+    pthread_mutex_lock(&r->lock);
+    expire(r, now_ns(CLOCK_MONOTONIC));
+
+    /* slowest first; nothing else depends on the order of the table */
+    for (i = 1; i < r->used; i++) {
+        record = r->records[i];
+        started = r->started[i];
+        for (j = i; j > 0 && r->records[j - 1].total_ns < record.total_ns; j--) {
+            r->records[j] = r->records[j - 1];
+            r->started[j] = r->started[j - 1];
+        }
+        r->records[j] = record;
+        r->started[j] = started;
+    }
+
+    count = r->used < max ? r->used : max;
+    memcpy(records, r->records, count * sizeof(multihash_flight_record));
+    pthread_mutex_unlock(&r->lock);
+    return count;
+}
+
+/*
+ * multihash.c brackets the memory-hard calls with begin and end; the kernels
+ * (cryptonight.c, scryptn.c, scryptjane.c) mark where each later phase starts.
+ * begin returns 0 while the recorder is off.
+ */
+int multihash_flight_begin(void)
+{
+    if (!__atomic_load_n(&recorder->capacity, __ATOMIC_RELAXED))
+        return 0;
+
+    memset(current.marks, 0, sizeof(current.marks));
+    current.active = 1;
+    current.wall = now_ns(CLOCK_REALTIME);
+    thread_usage(&current.usage);
+    current.marks[MULTIHASH_PHASE_ALLOC] = now_ns(CLOCK_MONOTONIC);
+    return 1;
+}
+
+void multihash_flight_mark(int phase)
+{
+    if (current.active && phase > 0 && phase < MULTIHASH_PHASE_COUNT)
+        current.marks[phase] = now_ns(CLOCK_MONOTONIC);
+}
+
+void multihash_flight_end(int algo, const multihash_params* params, int status)
+{
+    multihash_flight_record record;
+    struct rusage usage;
+    uint64_t end, start = current.marks[MULTIHASH_PHASE_ALLOC], total, next;
+    size_t slot, i;
+    int phase, later;
+
+    end = now_ns(CLOCK_MONOTONIC);
+    current.active = 0;
+    total = end - start;
+
+    if (total <= __atomic_load_n(&recorder->threshold, __ATOMIC_RELAXED) &&
+        end < __atomic_load_n(&recorder->expiry, __ATOMIC_RELAXED))
+        return;
+
+    thread_usage(&usage);
+
+    memset(&record, 0, sizeof(record));
+    record.algo = algo;
+    record.status = status;
+    if (params) {
+        record.N = params->N;
+        record.r = params->r;
+        record.nfactor = params->nfactor;
+        record.height = params->height;
+    }
+    record.start_ns = current.wall;
+    record.total_ns = total;
+    for (phase = 0; phase < MULTIHASH_PHASE_COUNT; phase++) {
+        if (!current.marks[phase])
+            continue;
+        next = end;
+        for (later = phase + 1; later < MULTIHASH_PHASE_COUNT; later++) {
+            if (current.marks[later]) {
+                next = current.marks[later];
+                break;
+            }
+        }
+        record.phase_ns[phase] = next - current.marks[phase];
+    }
+    record.minor_faults = usage.ru_minflt - current.usage.ru_minflt;
+    record.major_faults = usage.ru_majflt - current.usage.ru_majflt;
+    record.voluntary_switches = usage.ru_nvcsw - current.usage.ru_nvcsw;
+    record.involuntary_switches = usage.ru_nivcsw - current.usage.ru_nivcsw;
+#if defined(__linux__)
+    record.cpu = sched_getcpu();
+#else
+    record.cpu = -1;
+#endif
+
+    pthread_mutex_lock(&recorder->lock);
+    expire(recorder, end);
+    if (recorder->used < recorder->capacity) {
+        slot = recorder->used++;
+    } else {
+        slot = recorder->capacity;
+        for (i = 0; i < recorder->used; i++)
+            if (recorder->records[i].total_ns < total &&
+                (slot == recorder->capacity || recorder->records[i].total_ns < recorder->records[slot].total_ns))
+                slot = i;
+    }
+    if (slot < recorder->capacity) {
+        recorder->records[slot] = record;
+        recorder->started[slot] = start;
+        expire(recorder, end);
+    }
+    pthread_mutex_unlock(&recorder->lock);
+}
@@ -0,0 +1,166 @@
+#include "multihash.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sha3/sph_blake.h"
+#include "sha3/sph_bmw.h"
+#include "sha3/sph_groestl.h"
+#include "sha3/sph_jh.h"
+#include "sha3/sph_keccak.h"
+#include "sha3/sph_skein.h"
+#include "sha3/sph_luffa.h"
+#include "sha3/sph_cubehash.h"
+#include "sha3/sph_shavite.h"
+#include "sha3/sph_simd.h"
+#include "sha3/sph_echo.h"
+#include "sha3/sph_hamsi.h"
+#include "sha3/sph_fugue.h"
+#include "sha3/sph_shabal.h"
+#include "sha3/sph_whirlpool.h"
+
+/*
+ * x11-style chains assembled at runtime: the first stage hashes the input,
+ * every later stage hashes the previous 512 bit digest, and the chain output
+ * is the first 256 bits of the last one.
+ */
+
+typedef union chain_ctx {
+    sph_blake512_context     blake;
+    sph_bmw512_context       bmw;
+    sph_groestl512_context   groestl;
+    sph_jh512_context        jh;
+    sph_keccak512_context    keccak;
+    sph_skein512_context     skein;
+    sph_luffa512_context     luffa;
+    sph_cubehash512_context  cubehash;
+    sph_shavite512_context   shavite;
+    sph_simd512_context      simd;
+    sph_echo512_context      echo;
+    sph_hamsi512_context     hamsi;
+    sph_fugue512_context     fugue;
+    sph_shabal512_context    shabal;
+    sph_whirlpool_context    whirlpool;
+} chain_ctx;
+
+static const struct {
+    const char* name;
+    void (*init)(void* cc);
+    void (*update)(void* cc, const void* data, size_t len);
+    void (*close)(void* cc, void* dst);
+} primitives[] = {
+    { "blake",     sph_blake512_init,     sph_blake512,     sph_blake512_close },
+    { "bmw",       sph_bmw512_init,       sph_bmw512,       sph_bmw512_close },
+    { "groestl",   sph_groestl512_init,   sph_groestl512,   sph_groestl512_close },
+    { "jh",        sph_jh512_init,        sph_jh512,        sph_jh512_close },
+    { "keccak",    sph_keccak512_init,    sph_keccak512,    sph_keccak512_close },
+    { "skein",     sph_skein512_init,     sph_skein512,     sph_skein512_close },
+    { "luffa",     sph_luffa512_init,     sph_luffa512,     sph_luffa512_close },
+    { "cubehash",  sph_cubehash512_init,  sph_cubehash512,  sph_cubehash512_close },
+    { "shavite",   sph_shavite512_init,   sph_shavite512,   sph_shavite512_close },
+    { "simd",      sph_simd512_init,      sph_simd512,      sph_simd512_close },
+    { "echo",      sph_echo512_init,      sph_echo512,      sph_echo512_close },
+    { "hamsi",     sph_hamsi512_init,     sph_hamsi512,     sph_hamsi512_close },
+    { "fugue",     sph_fugue512_init,     sph_fugue512,     sph_fugue512_close },
+    { "shabal",    sph_shabal512_init,    sph_shabal512,    sph_shabal512_close },
+    { "whirlpool", sph_whirlpool_init,    sph_whirlpool,    sph_whirlpool_close },
+};
+
+#define PRIMITIVE_COUNT (sizeof(primitives) / sizeof(primitives[0]))
+
+struct multihash_chain {
+    size_t count;
+    uint8_t stages[MULTIHASH_CHAIN_MAX_STAGES];
+};
+
+int multihash_chain_primitive_lookup(const char* name)
+{
+    size_t i;
+    for (i = 0; i < PRIMITIVE_COUNT; i++)
+        if (strcmp(primitives[i].name, name) == 0)
+            return (int) i;
+    return MULTIHASH_EINVAL;
+}
+
+multihash_chain* multihash_chain_new(const int* stages, size_t count)
+{
+    multihash_chain* chain;
+    size_t i;
+
+    if (count == 0 || count > MULTIHASH_CHAIN_MAX_STAGES)
+        return NULL;
+    for (i = 0; i < count; i++)
+        if (stages[i] < 0 || (size_t) stages[i] >= PRIMITIVE_COUNT)
+            return NULL;
+
+    if (!(chain = (multihash_chain*) malloc(sizeof(multihash_chain))))
+        return NULL;
+    chain->count = count;
+    for (i = 0; i < count; i++)
+        chain->stages[i] = (uint8_t) stages[i];
+    return chain;
+}
+
+void multihash_chain_free(multihash_chain* chain)
+{
+    free(chain);
+}
+
+static void chain_run(const multihash_chain* chain, const char* input, size_t len, char* output)
+{
+    chain_ctx ctx;
+    uint32_t hash[2][16];
+    size_t i;
+
+    primitives[chain->stages[0]].init(&ctx);
+    primitives[chain->stages[0]].update(&ctx, input, len);
+    primitives[chain->stages[0]].close(&ctx, hash[0]);
+
+    for (i = 1; i < chain->count; i++) {
+        primitives[chain->stages[i]].init(&ctx);
+        primitives[chain->stages[i]].update(&ctx, hash[(i - 1) & 1], 64);
+        primitives[chain->stages[i]].close(&ctx, hash[i & 1]);
+    }
+
+    memcpy(output, hash[(chain->count - 1) & 1], 32);
+}
+
+/* perfcount.c: all chains are profiled together, as MULTIHASH_PERF_CHAIN */
+extern unsigned char multihash_perf_selected[];
+extern int multihash_perf_begin(uint64_t* snapshot);
+extern void multihash_perf_end(int algo, uint64_t count, const uint64_t* snapshot);
+
+int multihash_chain_hash(const multihash_chain* chain, const void* input, size_t len, void* output)
+{
+    uint64_t perf[MULTIHASH_PERF_COUNTERS + 2];
+    int profiled;
+
+    if (!chain)
+        return MULTIHASH_EINVAL;
+    profiled = __atomic_load_n(&multihash_perf_selected[MULTIHASH_PERF_CHAIN], __ATOMIC_RELAXED) &&
+               multihash_perf_begin(perf);
+    chain_run(chain, (const char*) input, len, (char*) output);
+    if (profiled)
+        multihash_perf_end(MULTIHASH_PERF_CHAIN, 1, perf);
+    return MULTIHASH_OK;
+}
+
+int multihash_chain_hash_batch(const multihash_chain* chain, const void* inputs, size_t input_stride,
+                               size_t len, size_t count, void* outputs)
+{
+    const char* in = (const char*) inputs;
+    char* out = (char*) outputs;
+    uint64_t perf[MULTIHASH_PERF_COUNTERS + 2];
+    int profiled;
+    size_t i;
+
+    if (!chain)
+        return MULTIHASH_EINVAL;
+    profiled = __atomic_load_n(&multihash_perf_selected[MULTIHASH_PERF_CHAIN], __ATOMIC_RELAXED) &&
+               multihash_perf_begin(perf);
+    for (i = 0; i < count; i++)
+        chain_run(chain, in + i * input_stride, len, out + i * MULTIHASH_OUTPUT_SIZE);
+    if (profiled)
+        multihash_perf_end(MULTIHASH_PERF_CHAIN, count, perf);
+    return MULTIHASH_OK;
+}
@@ -6,58 +6,201 @@
 #include "sha3/sph_blake.h"
 #include "sha256.h"
 
-void hefty1_hash(const char* input, char* output, uint32_t len)
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#define HEFTY1_PREFIX_BYTES 64
+
+/*
+ * All five hashes run over input || hefty1(input). For block headers the
+ * first 64 bytes only change with the job, so the state of every hash after
+ * that prefix is kept and each nonce resumes from a copy. HEFTY1 and SHA-256
+ * have a full block behind them by then; the sph contexts hold it buffered.
+ */
+typedef struct hefty1_midstate {
+    HEFTY1_CTX              hefty1;
+    SHA256_CTX              sha256;
+    sph_keccak512_context   keccak;
+    sph_groestl512_context  groestl;
+    sph_blake512_context    blake;
+} hefty1_midstate;
+
+static void midstate_init(hefty1_midstate* m, const char* input, uint32_t len)
+{
+    HEFTY1_Init(&m->hefty1);
+    HEFTY1_Update(&m->hefty1, (const void*) input, len);
+
+    SHA256_Init(&m->sha256);
+    SHA256_Update(&m->sha256, (const void*) input, len);
+
+    sph_keccak512_init(&m->keccak);
+    sph_keccak512(&m->keccak, (const void*) input, len);
+
+    sph_groestl512_init(&m->groestl);
+    sph_groestl512(&m->groestl, (const void*) input, len);
+
+    sph_blake512_init(&m->blake);
+    sph_blake512(&m->blake, (const void*) input, len);
+}
+
+#if !defined(__BMI2__)
+/* bit k of a byte (from the top) moved to bit 4k of a word (from the top) */
+static const uint32_t spread4[256] = {
+    0x00000000, 0x00000008, 0x00000080, 0x00000088,
+    0x00000800, 0x00000808, 0x00000880, 0x00000888,
+    0x00008000, 0x00008008, 0x00008080, 0x00008088,
+    0x00008800, 0x00008808, 0x00008880, 0x00008888,
+    0x00080000, 0x00080008, 0x00080080, 0x00080088,
+    0x00080800, 0x00080808, 0x00080880, 0x00080888,
+    0x00088000, 0x00088008, 0x00088080, 0x00088088,
+    0x00088800, 0x00088808, 0x00088880, 0x00088888,
+    0x00800000, 0x00800008, 0x00800080, 0x00800088,
+    0x00800800, 0x00800808, 0x00800880, 0x00800888,
+    0x00808000, 0x00808008, 0x00808080, 0x00808088,
+    0x00808800, 0x00808808, 0x00808880, 0x00808888,
+    0x00880000, 0x00880008, 0x00880080, 0x00880088,
+    0x00880800, 0x00880808, 0x00880880, 0x00880888,
+    0x00888000, 0x00888008, 0x00888080, 0x00888088,
+    0x00888800, 0x00888808, 0x00888880, 0x00888888,
+    0x08000000, 0x08000008, 0x08000080, 0x08000088,
+    0x08000800, 0x08000808, 0x08000880, 0x08000888,
+    0x08008000, 0x08008008, 0x08008080, 0x08008088,
+    0x08008800, 0x08008808, 0x08008880, 0x08008888,
+    0x08080000, 0x08080008, 0x08080080, 0x08080088,
+    0x08080800, 0x08080808, 0x08080880, 0x08080888,
+    0x08088000, 0x08088008, 0x08088080, 0x08088088,
+    0x08088800, 0x08088808, 0x08088880, 0x08088888,
+    0x08800000, 0x08800008, 0x08800080, 0x08800088,
+    0x08800800, 0x08800808, 0x08800880, 0x08800888,
+    0x08808000, 0x08808008, 0x08808080, 0x08808088,
+    0x08808800, 0x08808808, 0x08808880, 0x08808888,
+    0x08880000, 0x08880008, 0x08880080, 0x08880088,
+    0x08880800, 0x08880808, 0x08880880, 0x08880888,
+    0x08888000, 0x08888008, 0x08888080, 0x08888088,
+    0x08888800, 0x08888808, 0x08888880, 0x08888888,
+    0x80000000, 0x80000008, 0x80000080, 0x80000088,
+    0x80000800, 0x80000808, 0x80000880, 0x80000888,
+    0x80008000, 0x80008008, 0x80008080, 0x80008088,
+    0x80008800, 0x80008808, 0x80008880, 0x80008888,
+    0x80080000, 0x80080008, 0x80080080, 0x80080088,
+    0x80080800, 0x80080808, 0x80080880, 0x80080888,
+    0x80088000, 0x80088008, 0x80088080, 0x80088088,
+    0x80088800, 0x80088808, 0x80088880, 0x80088888,
+    0x80800000, 0x80800008, 0x80800080, 0x80800088,
+    0x80800800, 0x80800808, 0x80800880, 0x80800888,
+    0x80808000, 0x80808008, 0x80808080, 0x80808088,
+    0x80808800, 0x80808808, 0x80808880, 0x80808888,
+    0x80880000, 0x80880008, 0x80880080, 0x80880088,
+    0x80880800, 0x80880808, 0x80880880, 0x80880888,
+    0x80888000, 0x80888008, 0x80888080, 0x80888088,
+    0x80888800, 0x80888808, 0x80888880, 0x80888888,
+    0x88000000, 0x88000008, 0x88000080, 0x88000088,
+    0x88000800, 0x88000808, 0x88000880, 0x88000888,
+    0x88008000, 0x88008008, 0x88008080, 0x88008088,
+    0x88008800, 0x88008808, 0x88008880, 0x88008888,
+    0x88080000, 0x88080008, 0x88080080, 0x88080088,
+    0x88080800, 0x88080808, 0x88080880, 0x88080888,
+    0x88088000, 0x88088008, 0x88088080, 0x88088088,
+    0x88088800, 0x88088808, 0x88088880, 0x88088888,
+    0x88800000, 0x88800008, 0x88800080, 0x88800088,
+    0x88800800, 0x88800808, 0x88800880, 0x88800888,
+    0x88808000, 0x88808008, 0x88808080, 0x88808088,
+    0x88808800, 0x88808808, 0x88808880, 0x88808888,
+    0x88880000, 0x88880008, 0x88880080, 0x88880088,
+    0x88880800, 0x88880808, 0x88880880, 0x88880888,
+    0x88888000, 0x88888008, 0x88888080, 0x88888088,
+    0x88888800, 0x88888808, 0x88888880, 0x88888888,
+};
+#endif
+
+/*
+ * Output bit 4i + j is bit i of hash j, counting from the most significant
+ * bit of the first byte, for the first 64 bits of each hash. Every input byte
+ * becomes one 32 bit output word, shifted by its hash's index.
+ */
+static void interleave(const uint8_t* hash[4], char* output)
 {
-    HEFTY1_CTX              ctx_hefty1;
-    SHA256_CTX              ctx_sha256;
-    sph_keccak512_context   ctx_keccak;
-    sph_groestl512_context  ctx_groestl;
-    sph_blake512_context    ctx_blake;
-    
-    char hash32_1[32];
-    char hash32_2[32];
-    char hash64_3[64];
-    char hash64_4[64];
-    char hash64_5[64];
-    
-    HEFTY1_Init(&ctx_hefty1);
-    HEFTY1_Update(&ctx_hefty1, (const void*) input, len);
-    HEFTY1_Final((unsigned char*) &hash32_1, &ctx_hefty1); // 1
-    
-    SHA256_Init(&ctx_sha256);
-    SHA256_Update(&ctx_sha256, (const void*) input, len);
-    SHA256_Update(&ctx_sha256, (unsigned char*) &hash32_1, 32); // 1
-    SHA256_Final((unsigned char*) &hash32_2, &ctx_sha256); // 2
-    
-    sph_keccak512_init(&ctx_keccak);
-    sph_keccak512(&ctx_keccak, (const void*) input, len);
-    sph_keccak512(&ctx_keccak, (unsigned char*) &hash32_1, 32); //1
-    sph_keccak512_close(&ctx_keccak, (void*) &hash64_3); // 3
-    
-    sph_groestl512_init(&ctx_groestl);
-    sph_groestl512(&ctx_groestl, (const void*) input, len);
-    sph_groestl512(&ctx_groestl, (unsigned char*) &hash32_1, 32); // 1
-    sph_groestl512_close(&ctx_groestl, (void*) &hash64_4); // 4
-    
-    sph_blake512_init(&ctx_blake);
-    sph_blake512(&ctx_blake, (const void*) input, len);
-    sph_blake512(&ctx_blake, (unsigned char*) &hash32_1, 32); // 1
-    sph_blake512_close(&ctx_blake, (void*) &hash64_5); // 5
-    
-    memset(output, 0, 32);
-    
-    char* hash[4] = { hash32_2, hash64_3, hash64_4, hash64_5 };
-    
     uint32_t i;
+
+#if defined(__BMI2__)
     uint32_t j;
-    
-    #define OUTPUT_BIT (i * 4 + j)
-    
-    for(i = 0; i < 64; i++) {
-        for(j = 0; j < 4; j++) {
-            if((*(hash[j] + (i / 8)) & (0x80 >> (i % 8))) != 0)
-                *(output + (OUTPUT_BIT / 8)) |= 0x80 >> (OUTPUT_BIT % 8);
-        }
+
+    for (i = 0; i < 8; i++) {
+        uint32_t word = 0;
+        for (j = 0; j < 4; j++)
+            word |= _pdep_u32(hash[j][i], 0x88888888u) >> j;
+        be32enc(output + 4 * i, word);
     }
+#else
+    for (i = 0; i < 8; i++) {
+        uint32_t word = spread4[hash[0][i]] | spread4[hash[1][i]] >> 1 |
+                        spread4[hash[2][i]] >> 2 | spread4[hash[3][i]] >> 3;
+        be32enc(output + 4 * i, word);
+    }
+#endif
 }
 
+static void midstate_finish(const hefty1_midstate* m, const char* tail, uint32_t tail_len, char* output)
+{
+    hefty1_midstate s = *m;
+
+    unsigned char hash32_1[32];
+    unsigned char hash32_2[32];
+    unsigned char hash64_3[64];
+    unsigned char hash64_4[64];
+    unsigned char hash64_5[64];
+
+    HEFTY1_Update(&s.hefty1, (const void*) tail, tail_len);
+    HEFTY1_Final(hash32_1, &s.hefty1); // 1
+
+    SHA256_Update(&s.sha256, (const void*) tail, tail_len);
+    SHA256_Update(&s.sha256, hash32_1, 32); // 1
+    SHA256_Final(hash32_2, &s.sha256); // 2
+
+    sph_keccak512(&s.keccak, (const void*) tail, tail_len);
+    sph_keccak512(&s.keccak, hash32_1, 32); // 1
+    sph_keccak512_close(&s.keccak, hash64_3); // 3
+
+    sph_groestl512(&s.groestl, (const void*) tail, tail_len);
+    sph_groestl512(&s.groestl, hash32_1, 32); // 1
+    sph_groestl512_close(&s.groestl, hash64_4); // 4
+
+    sph_blake512(&s.blake, (const void*) tail, tail_len);
+    sph_blake512(&s.blake, hash32_1, 32); // 1
+    sph_blake512_close(&s.blake, hash64_5); // 5
+
+    const uint8_t* hash[4] = { hash32_2, hash64_3, hash64_4, hash64_5 };
+    interleave(hash, output);
+}
+
+void hefty1_hash(const char* input, char* output, uint32_t len)
+{
+    hefty1_midstate m;
+
+    midstate_init(&m, input, 0);
+    midstate_finish(&m, input, len, output);
+}
+
+void hefty1_hash_batch(const char* inputs, size_t input_stride, uint32_t len, size_t count, char* outputs)
+{
+    hefty1_midstate m;
+    const char* prefix = NULL;
+    size_t i;
+
+    if (len < HEFTY1_PREFIX_BYTES) {
+        for (i = 0; i < count; i++)
+            hefty1_hash(inputs + i * input_stride, outputs + i * 32, len);
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        const char* input = inputs + i * input_stride;
+
+        if (!prefix || memcmp(prefix, input, HEFTY1_PREFIX_BYTES) != 0) {
+            midstate_init(&m, input, HEFTY1_PREFIX_BYTES);
+            prefix = input;
+        }
+        midstate_finish(&m, input + HEFTY1_PREFIX_BYTES, len - HEFTY1_PREFIX_BYTES, outputs + i * 32);
+    }
+}
@@ -5,10 +5,14 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 
 void hefty1_hash(const char* input, char* output, uint32_t len);
 
+/* Records sharing their first 64 bytes (one job's headers) reuse one prefix midstate */
+void hefty1_hash_batch(const char* inputs, size_t input_stride, uint32_t len, size_t count, char* outputs);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1 +1,68 @@
-module.exports = require('bindings')('multihashing.node')
\ No newline at end of file
+var families = require('./families');
+
+/* each export loads its family's native module the first time it is read */
+Object.keys(families.families).forEach(function(family){
+    families.families[family].forEach(function(name){
+        Object.defineProperty(module.exports, name, {
+            enumerable: true,
+            configurable: true,
+            get: function(){
+                var value = families.load(family)[name];
+                Object.defineProperty(module.exports, name, { value: value, enumerable: true, writable: true });
+                return value;
+            }
+        });
+    });
+});
+
+module.exports.hashBatch = function(algo){
+    var family = families.forAlgorithm(algo);
+    return family.hashBatch.apply(family, arguments);
+};
+
+/* a mixed batch may name any algorithm, so it runs on the complete module */
+module.exports.hashTasks = function(tasks, options, callback){
+    var native = families.load('all');
+    if (typeof options === 'function')
+        return native.hashTasks(tasks, options);
+    if (options === undefined || options === null)
+        return native.hashTasks(tasks, callback);
+    return native.hashTasks(tasks, options, callback);
+};
+
+/* a job hashes in the module that carries its algorithm */
+module.exports.stratumJob = function(options){
+    return families.forAlgorithm(options.algorithm).stratumJob(options);
+};
+
+/* kernel variants live in the module that carries the algorithm */
+module.exports.variants = function(algo){
+    return families.forAlgorithm(algo).variants(algo);
+};
+
+module.exports.selectedVariant = function(algo){
+    return families.forAlgorithm(algo).selectedVariant(algo);
+};
+
+module.exports.selectVariant = families.selectVariant;
+
+module.exports.isaLevels = families.isaLevels;
+
+module.exports.crossCheck = families.crossCheck;
+module.exports.crossCheckStats = families.crossCheckStats;
+module.exports.setFastPath = families.setFastPath;
+
+module.exports.profile = families.profile;
+module.exports.profileStats = families.profileStats;
+module.exports.profileReset = families.profileReset;
+
+module.exports.tune = require('./tune').tune;
+module.exports.tuning = function(){
+    return require('./tune').cached();
+};
+
+module.exports.replay = function(trace, options){
+    return require('./replay').replay(trace, options);
+};
+
+module.exports.HashRing = require('./ring');
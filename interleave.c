@@ -0,0 +1,34 @@
+#include "multihash.h"
+
+/*
+ * Round-robin executor for the batch paths of the scratchpad kernels (see
+ * multihash_interleave). A hash is a state machine that stops after issuing
+ * the prefetch for its next dependent scratchpad read; while that line is on
+ * its way, the other hashes in flight each run a stage of their own. The
+ * hashes keep their state in the caller's array, so there are no stacks to
+ * switch and nothing to allocate.
+ */
+
+int multihash_interleave(multihash_step_fn step, void* states, size_t state_size, size_t count)
+{
+    char* live[MULTIHASH_INTERLEAVE_MAX];
+    size_t n, i;
+
+    if (!step || (!states && count) || count > MULTIHASH_INTERLEAVE_MAX)
+        return MULTIHASH_EINVAL;
+
+    for (i = 0; i < count; i++)
+        live[i] = (char*) states + i * state_size;
+
+    for (n = count; n > 0; ) {
+        for (i = 0; i < n; ) {
+            if (step(live[i])) {
+                i++;
+                continue;
+            }
+            /* done: the last one in flight takes its place */
+            live[i] = live[--n];
+        }
+    }
+    return MULTIHASH_OK;
+}
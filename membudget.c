@@ -0,0 +1,240 @@
+#include "multihash.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "probes.h"
+
+/*
+ * Process-wide memory governor for the scratchpads of the memory-hard
+ * algorithms. Waiters are admitted strictly in arrival order (a ticket
+ * queue), so a large scryptjane job is not starved by a stream of small
+ * scrypt ones; a job that fits is still held back while anyone is queued.
+ *
+ * Contexts keep their scratchpads between calls, charged all the while. So
+ * the queue head never waits on memory nobody is using, every context with
+ * something cached is on the governor's cache list, and a head that does not
+ * fit asks the idle ones to free their scratchpads before it sleeps. A
+ * context in a call keeps its memory; it wakes the queue when it returns.
+ */
+
+/* memory__wait: bytes, time queued in ns, status; fired for every call that queued */
+MULTIHASH_PROBE_DEFINE(memory__wait);
+
+typedef struct governor_cache governor_cache;
+
+typedef struct governor_state {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint64_t budget;        /* 0: unlimited */
+    uint64_t in_use;
+    uint64_t peak;
+    uint64_t next_ticket;
+    uint64_t serving;       /* ticket of the queue head */
+    uint64_t waiting;
+    uint64_t admitted;
+    uint64_t queued;
+    uint64_t rejected;
+    governor_cache* caches;
+} governor_state;
+
+/* a context's entry on the cache list; reclaim returns the bytes it freed, 0 while the context is busy */
+struct governor_cache {
+    governor_cache* prev;
+    governor_cache* next;
+    governor_state* governor;
+    uint64_t (*reclaim)(void* owner);
+    void* owner;
+};
+
+static governor_state own_governor = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+static governor_state* governor = &own_governor;
+
+static int fits(uint64_t bytes)
+{
+    return !governor->budget || (governor->in_use <= governor->budget && bytes <= governor->budget - governor->in_use);
+}
+
+/* frees idle contexts' scratchpads until bytes fit; 0 when nothing could be freed */
+static int reclaim(uint64_t bytes)
+{
+    governor_cache* cache;
+    uint64_t freed, total = 0;
+
+    for (cache = governor->caches; cache && !fits(bytes); cache = cache->next) {
+        freed = cache->reclaim(cache->owner);
+        governor->in_use -= freed < governor->in_use ? freed : governor->in_use;
+        total += freed;
+    }
+    return total != 0;
+}
+
+static void charge(uint64_t bytes)
+{
+    governor->in_use += bytes;
+    if (governor->in_use > governor->peak)
+        governor->peak = governor->in_use;
+    governor->admitted++;
+}
+
+void* multihash_memory_governor(void)
+{
+    return governor;
+}
+
+void multihash_memory_use_governor(void* other)
+{
+    governor = other ? (governor_state*) other : &own_governor;
+}
+
+void multihash_memory_set_budget(uint64_t bytes)
+{
+    pthread_mutex_lock(&governor->lock);
+    governor->budget = bytes;
+    pthread_cond_broadcast(&governor->cond);
+    pthread_mutex_unlock(&governor->lock);
+}
+
+void multihash_memory_get_stats(multihash_memory_stats* stats)
+{
+    pthread_mutex_lock(&governor->lock);
+    stats->budget = governor->budget;
+    stats->in_use = governor->in_use;
+    stats->peak = governor->peak;
+    stats->waiting = governor->waiting;
+    stats->admitted = governor->admitted;
+    stats->queued = governor->queued;
+    stats->rejected = governor->rejected;
+    pthread_mutex_unlock(&governor->lock);
+}
+
+void multihash_memory_reset_peak(void)
+{
+    pthread_mutex_lock(&governor->lock);
+    governor->peak = governor->in_use;
+    pthread_mutex_unlock(&governor->lock);
+}
+
+int multihash_memory_acquire(uint64_t bytes, int wait)
+{
+    uint64_t ticket, queued_at, waited;
+    int rc;
+
+    pthread_mutex_lock(&governor->lock);
+
+    if (governor->budget && bytes > governor->budget) {
+        if (wait)
+            governor->rejected++;
+        pthread_mutex_unlock(&governor->lock);
+        return MULTIHASH_ENOMEM;
+    }
+
+    if (!governor->waiting && fits(bytes)) {
+        charge(bytes);
+        pthread_mutex_unlock(&governor->lock);
+        return MULTIHASH_OK;
+    }
+
+    if (!wait) {
+        pthread_mutex_unlock(&governor->lock);
+        return MULTIHASH_ENOMEM;
+    }
+
+    ticket = governor->next_ticket++;
+    __atomic_add_fetch(&governor->waiting, 1, __ATOMIC_SEQ_CST);
+    governor->queued++;
+    queued_at = multihash_probe_ns();
+
+    /* the budget may shrink while we wait, so re-check the hard limit too */
+    while (ticket != governor->serving || !fits(bytes)) {
+        if (ticket == governor->serving) {
+            if (governor->budget && bytes > governor->budget)
+                break;
+            if (reclaim(bytes))
+                continue;
+        }
+        pthread_cond_wait(&governor->cond, &governor->lock);
+    }
+
+    __atomic_sub_fetch(&governor->waiting, 1, __ATOMIC_SEQ_CST);
+    governor->serving++;
+    pthread_cond_broadcast(&governor->cond);
+
+    if (governor->budget && bytes > governor->budget) {
+        governor->rejected++;
+        rc = MULTIHASH_ENOMEM;
+    } else {
+        charge(bytes);
+        rc = MULTIHASH_OK;
+    }
+    pthread_mutex_unlock(&governor->lock);
+
+    waited = multihash_probe_ns() - queued_at;
+    MULTIHASH_PROBE3(memory__wait, bytes, waited, rc);
+    return rc;
+}
+
+void multihash_memory_release(uint64_t bytes)
+{
+    if (!bytes)
+        return;
+    pthread_mutex_lock(&governor->lock);
+    governor->in_use -= bytes < governor->in_use ? bytes : governor->in_use;
+    pthread_cond_broadcast(&governor->cond);
+    pthread_mutex_unlock(&governor->lock);
+}
+
+/*
+ * The cache list, for multihash.c. A context registers once it caches a
+ * scratchpad and calls idle whenever it returns from a call with one.
+ */
+void* multihash_memory_cache_register(uint64_t (*reclaim_fn)(void* owner), void* owner)
+{
+    governor_cache* cache = (governor_cache*) calloc(1, sizeof(governor_cache));
+
+    if (!cache)
+        return NULL;
+    cache->governor = governor;
+    cache->reclaim = reclaim_fn;
+    cache->owner = owner;
+
+    pthread_mutex_lock(&cache->governor->lock);
+    cache->next = cache->governor->caches;
+    if (cache->next)
+        cache->next->prev = cache;
+    cache->governor->caches = cache;
+    pthread_mutex_unlock(&cache->governor->lock);
+    return cache;
+}
+
+void multihash_memory_cache_unregister(void* entry)
+{
+    governor_cache* cache = (governor_cache*) entry;
+
+    if (!cache)
+        return;
+    pthread_mutex_lock(&cache->governor->lock);
+    if (cache->prev)
+        cache->prev->next = cache->next;
+    else
+        cache->governor->caches = cache->next;
+    if (cache->next)
+        cache->next->prev = cache->prev;
+    pthread_mutex_unlock(&cache->governor->lock);
+    free(cache);
+}
+
+/* pairs with the queue head's reclaim: either it saw the context idle, or this sees it waiting */
+void multihash_memory_cache_idle(void* entry)
+{
+    governor_cache* cache = (governor_cache*) entry;
+
+    if (!__atomic_load_n(&cache->governor->waiting, __ATOMIC_SEQ_CST))
+        return;
+    pthread_mutex_lock(&cache->governor->lock);
+    pthread_cond_broadcast(&cache->governor->cond);
+    pthread_mutex_unlock(&cache->governor->lock);
+}
@@ -0,0 +1,775 @@
+#include "multihash.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bcrypt.h"
+#include "keccak.h"
+#include "quark.h"
+#include "scryptjane.h"
+#include "scryptn.h"
+#include "skein.h"
+#include "x11.h"
+#include "groestl.h"
+#include "blake.h"
+#include "fugue.h"
+#include "qubit.h"
+#include "hefty1.h"
+#include "shavite3.h"
+#include "cryptonight.h"
+#include "x13.h"
+#include "nist5.h"
+#include "sha1.h"
+#include "x15.h"
+#include "fresh.h"
+#include "sph_sophia.h"
+#include "boolberry.h"
+#include "probes.h"
+
+/*
+ * The per-family Node modules link only some algorithms next to this file
+ * and build it with MULTIHASH_WEAK_ALGOS: references to the others then
+ * resolve to NULL instead of failing the link, and those algorithms report
+ * MULTIHASH_EINVAL.
+ */
+#ifdef MULTIHASH_WEAK_ALGOS
+#pragma weak quark_hash
+#pragma weak x11_hash
+#pragma weak keccak_hash
+#pragma weak skein_hash
+#pragma weak groestl_hash
+#pragma weak groestlmyriad_hash
+#pragma weak blake_hash
+#pragma weak fugue_hash
+#pragma weak qubit_hash
+#pragma weak hefty1_hash
+#pragma weak hefty1_hash_batch
+#pragma weak shavite3_hash
+#pragma weak x13_hash
+#pragma weak nist5_hash
+#pragma weak x15_hash
+#pragma weak fresh_hash
+#pragma weak sph_sophia512_init
+#pragma weak sph_sophia512
+#pragma weak sph_sophia512_close
+#pragma weak scrypt_N_R_1_256_sp
+#pragma weak scryptjane_hash
+#pragma weak scryptjane_hash_reference
+#pragma weak scryptjane_mix_count
+#pragma weak scryptjane_mix_name
+#pragma weak scryptjane_select_mix
+#pragma weak scryptjane_selected_mix
+#pragma weak scrypt_memory_size
+#pragma weak cryptonight_fast_hash
+#pragma weak cryptonight_alloc_ctx
+#pragma weak cryptonight_free_ctx
+#pragma weak cryptonight_ctx_size
+#pragma weak cryptonight_hash_ctx
+#pragma weak cryptonight_hash_ctx_reference
+#pragma weak cryptonight_hash_interleaved
+#pragma weak cryptonight_variant_count
+#pragma weak cryptonight_variant_name
+#pragma weak cryptonight_select_variant
+#pragma weak cryptonight_selected_variant
+#pragma weak boolberry_hash
+#pragma weak bcrypt_hash
+#pragma weak sha1_hash
+#endif
+
+MULTIHASH_PROBE_DEFINE(hash__start);
+MULTIHASH_PROBE_DEFINE(hash__done);
+MULTIHASH_PROBE_DEFINE(batch__start);
+MULTIHASH_PROBE_DEFINE(batch__done);
+
+/* crosscheck.c */
+extern void multihash_crosscheck_sample(int algo, const multihash_params* params,
+                                        const void* input, size_t len, const void* output);
+
+/* perfcount.c */
+extern unsigned char multihash_perf_selected[];
+extern int multihash_perf_begin(uint64_t* snapshot);
+extern void multihash_perf_end(int algo, uint64_t count, const uint64_t* snapshot);
+
+#define PROFILED(algo, snapshot) \
+    (__atomic_load_n(&multihash_perf_selected[algo], __ATOMIC_RELAXED) && multihash_perf_begin(snapshot))
+
+/* membudget.c */
+extern void* multihash_memory_cache_register(uint64_t (*reclaim)(void* owner), void* owner);
+extern void multihash_memory_cache_unregister(void* cache);
+extern void multihash_memory_cache_idle(void* cache);
+
+/* flight.c */
+extern int multihash_flight_begin(void);
+extern void multihash_flight_end(int algo, const multihash_params* params, int status);
+
+/* the algorithms the flight recorder watches */
+#define RECORDED(algo) \
+    (((algo) == MULTIHASH_SCRYPT || (algo) == MULTIHASH_SCRYPTN || (algo) == MULTIHASH_SCRYPTJANE || \
+      (algo) == MULTIHASH_CRYPTONIGHT) && multihash_flight_begin())
+
+/*
+ * A context's scratchpads are only touched by its owner while it is BUSY, and
+ * by a waiter of the memory governor reclaiming them while it is RECLAIMING.
+ */
+#define CTX_IDLE        0
+#define CTX_BUSY        1
+#define CTX_RECLAIMING  2
+
+struct multihash_ctx {
+    struct cryptonight_ctx* cn_ctx;
+    char* scrypt_scratchpad;
+    uint64_t scrypt_scratchpad_size;
+    int state;
+    void* cache;        /* entry on the governor's cache list, once something was cached */
+    int nowait;         /* scratchpads that do not fit fail instead of queueing */
+};
+
+static void sophia_hash(const char* input, char* output, uint32_t len)
+{
+    uint32_t hashA[16], hashB[16];
+
+    sph_sophia512_context ctx_sophia[2];
+
+    sph_sophia512_init(&ctx_sophia[0]);
+    sph_sophia512 (&ctx_sophia[0], input, len);
+    sph_sophia512_close(&ctx_sophia[0], hashA);
+
+    sph_sophia512_init(&ctx_sophia[1]);
+    sph_sophia512 (&ctx_sophia[1], hashA, 64);
+    sph_sophia512_close(&ctx_sophia[1], hashB);
+
+    memcpy(output, hashB, 32);
+}
+
+typedef void (*multihash_fn)(const char* input, char* output, uint32_t len);
+
+/* Indexed by enum multihash_algo; fn is NULL for algorithms that need parameters or a context */
+static const struct {
+    const char* name;
+    multihash_fn fn;
+} algos[MULTIHASH_ALGO_COUNT] = {
+    { "quark",           quark_hash },
+    { "x11",             x11_hash },
+    { "scrypt",          NULL },
+    { "scryptn",         NULL },
+    { "scryptjane",      NULL },
+    { "keccak",          keccak_hash },
+    { "bcrypt",          NULL },
+    { "skein",           skein_hash },
+    { "groestl",         groestl_hash },
+    { "groestlmyriad",   groestlmyriad_hash },
+    { "blake",           blake_hash },
+    { "fugue",           fugue_hash },
+    { "qubit",           qubit_hash },
+    { "hefty1",          hefty1_hash },
+    { "shavite3",        shavite3_hash },
+    { "cryptonight",     NULL },
+    { "cryptonightfast", cryptonight_fast_hash },
+    { "x13",             x13_hash },
+    { "boolberry",       NULL },
+    { "nist5",           nist5_hash },
+    { "sha1",            sha1_hash },
+    { "x15",             x15_hash },
+    { "fresh",           fresh_hash },
+    { "sophia",          sophia_hash },
+};
+
+const char* multihash_algo_name(int algo)
+{
+    if (algo < 0 || algo >= MULTIHASH_ALGO_COUNT)
+        return NULL;
+    return algos[algo].name;
+}
+
+int multihash_algo_lookup(const char* name)
+{
+    int i;
+    for (i = 0; i < MULTIHASH_ALGO_COUNT; i++)
+        if (strcmp(algos[i].name, name) == 0)
+            return i;
+    return MULTIHASH_EINVAL;
+}
+
+int multihash_algo_available(int algo)
+{
+    if (algo < 0 || algo >= MULTIHASH_ALGO_COUNT)
+        return 0;
+
+#ifdef MULTIHASH_WEAK_ALGOS
+    switch (algo) {
+    case MULTIHASH_SCRYPT:
+    case MULTIHASH_SCRYPTN:
+        return scrypt_N_R_1_256_sp != NULL;
+    case MULTIHASH_SCRYPTJANE:
+        return scryptjane_hash != NULL;
+    case MULTIHASH_BCRYPT:
+        return bcrypt_hash != NULL;
+    case MULTIHASH_CRYPTONIGHT:
+        return cryptonight_hash_ctx != NULL;
+    case MULTIHASH_BOOLBERRY:
+        return boolberry_hash != NULL;
+    case MULTIHASH_SOPHIA:
+        return sph_sophia512_init != NULL;
+    }
+    return algos[algo].fn != NULL;
+#else
+    return 1;
+#endif
+}
+
+int multihash_variant_count(int algo)
+{
+    if (!multihash_algo_available(algo))
+        return 0;
+
+    switch (algo) {
+    case MULTIHASH_SCRYPTJANE:
+        return scryptjane_mix_count();
+    case MULTIHASH_CRYPTONIGHT:
+        return cryptonight_variant_count();
+    }
+    return 0;
+}
+
+const char* multihash_variant_name(int algo, int variant)
+{
+    if (variant < 0 || variant >= multihash_variant_count(algo))
+        return NULL;
+
+    switch (algo) {
+    case MULTIHASH_SCRYPTJANE:
+        return scryptjane_mix_name(variant);
+    case MULTIHASH_CRYPTONIGHT:
+        return cryptonight_variant_name(variant);
+    }
+    return NULL;
+}
+
+int multihash_variant_select(int algo, int variant)
+{
+    if (variant != -1 && !multihash_variant_name(algo, variant))
+        return MULTIHASH_EINVAL;
+
+    switch (algo) {
+    case MULTIHASH_SCRYPTJANE:
+        if (!multihash_algo_available(algo))
+            break;
+        scryptjane_select_mix(variant);
+        return MULTIHASH_OK;
+    case MULTIHASH_CRYPTONIGHT:
+        if (!multihash_algo_available(algo))
+            break;
+        cryptonight_select_variant(variant);
+        return MULTIHASH_OK;
+    }
+    return MULTIHASH_EINVAL;
+}
+
+int multihash_variant_selected(int algo)
+{
+    if (!multihash_variant_count(algo))
+        return MULTIHASH_EINVAL;
+
+    switch (algo) {
+    case MULTIHASH_SCRYPTJANE:
+        return scryptjane_selected_mix();
+    case MULTIHASH_CRYPTONIGHT:
+        return cryptonight_selected_variant();
+    }
+    return MULTIHASH_EINVAL;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+
+int multihash_isa_level(void)
+{
+    unsigned eax, ebx, ecx, edx, ext_ecx, leaf7_ebx;
+    unsigned lo, hi;
+    const unsigned v2 = bit_SSE3 | bit_SSSE3 | bit_CMPXCHG16B | bit_SSE4_1 | bit_SSE4_2 | bit_POPCNT;
+    const unsigned v3 = bit_FMA | bit_MOVBE | bit_OSXSAVE | bit_AVX | bit_F16C;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !__get_cpuid(0x80000001, &eax, &ebx, &ext_ecx, &edx))
+        return 1;
+    if ((ecx & v2) != v2 || !(ext_ecx & bit_LAHF_LM))
+        return 1;
+
+    if ((ecx & v3) != v3 || !(ext_ecx & bit_LZCNT) ||
+        !__get_cpuid_count(7, 0, &eax, &leaf7_ebx, &ecx, &edx))
+        return 2;
+    if ((leaf7_ebx & (bit_AVX2 | bit_BMI | bit_BMI2)) != (bit_AVX2 | bit_BMI | bit_BMI2))
+        return 2;
+    /* the OS saves the ymm registers */
+    __asm__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+    return (lo & 6) == 6 ? 3 : 2;
+}
+#else
+int multihash_isa_level(void)
+{
+    return 0;
+}
+#endif
+
+int multihash_isa_built(void)
+{
+#if defined(__x86_64__) && defined(__AVX2__) && defined(__BMI2__) && defined(__FMA__)
+    return 3;
+#elif defined(__x86_64__) && defined(__SSE4_2__) && defined(__POPCNT__)
+    return 2;
+#elif defined(__x86_64__)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+multihash_ctx* multihash_ctx_new(void)
+{
+    return (multihash_ctx*) calloc(1, sizeof(multihash_ctx));
+}
+
+static void ctx_enter(multihash_ctx* ctx)
+{
+    int idle = CTX_IDLE;
+
+    /* a reclaim in progress only frees, so it is over quickly */
+    while (!__atomic_compare_exchange_n(&ctx->state, &idle, CTX_BUSY, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        idle = CTX_IDLE;
+        sched_yield();
+    }
+}
+
+static void ctx_leave(multihash_ctx* ctx)
+{
+    int cached = ctx->cn_ctx || ctx->scrypt_scratchpad;
+
+    __atomic_store_n(&ctx->state, CTX_IDLE, __ATOMIC_SEQ_CST);
+    if (cached)
+        multihash_memory_cache_idle(ctx->cache);
+}
+
+/* frees what ctx caches without releasing it from the budget; returns the bytes */
+static uint64_t drop_scratchpads(multihash_ctx* ctx)
+{
+    uint64_t freed = ctx->scrypt_scratchpad_size;
+
+    if (ctx->cn_ctx) {
+        cryptonight_free_ctx(ctx->cn_ctx);
+        ctx->cn_ctx = NULL;
+        freed += cryptonight_ctx_size();
+    }
+    free(ctx->scrypt_scratchpad);
+    ctx->scrypt_scratchpad = NULL;
+    ctx->scrypt_scratchpad_size = 0;
+    return freed;
+}
+
+/* for the governor, called with its lock held */
+static uint64_t reclaim_ctx(void* owner)
+{
+    multihash_ctx* ctx = (multihash_ctx*) owner;
+    int idle = CTX_IDLE;
+    uint64_t freed;
+
+    if (!__atomic_compare_exchange_n(&ctx->state, &idle, CTX_RECLAIMING, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return 0;
+    freed = drop_scratchpads(ctx);
+    __atomic_store_n(&ctx->state, CTX_IDLE, __ATOMIC_RELEASE);
+    return freed;
+}
+
+/* scratchpads may only be cached once the governor can take them back */
+static int ctx_can_cache(multihash_ctx* ctx)
+{
+    if (!ctx->cache)
+        ctx->cache = multihash_memory_cache_register(reclaim_ctx, ctx);
+    return ctx->cache != NULL;
+}
+
+static void drop_scrypt_scratchpad(multihash_ctx* ctx)
+{
+    free(ctx->scrypt_scratchpad);
+    ctx->scrypt_scratchpad = NULL;
+    multihash_memory_release(ctx->scrypt_scratchpad_size);
+    ctx->scrypt_scratchpad_size = 0;
+}
+
+void multihash_ctx_set_wait(multihash_ctx* ctx, int wait)
+{
+    ctx->nowait = !wait;
+}
+
+void multihash_ctx_trim(multihash_ctx* ctx)
+{
+    if (!ctx)
+        return;
+    ctx_enter(ctx);
+    multihash_memory_release(drop_scratchpads(ctx));
+    __atomic_store_n(&ctx->state, CTX_IDLE, __ATOMIC_RELEASE);
+}
+
+void multihash_ctx_free(multihash_ctx* ctx)
+{
+    if (!ctx)
+        return;
+    multihash_memory_cache_unregister(ctx->cache);
+    multihash_ctx_trim(ctx);
+    free(ctx);
+}
+
+/*
+ * Admits a scratchpad against the memory budget. ctx, when given, is the
+ * caller's busy context: it gives up what it caches before it queues, since
+ * no waiter can reclaim it, so a thread never waits on memory it holds itself.
+ * wait is 0 for the callers of a context set not to wait.
+ */
+static int admit(multihash_ctx* ctx, uint64_t bytes, int wait)
+{
+    if (multihash_memory_acquire(bytes, 0) == MULTIHASH_OK)
+        return MULTIHASH_OK;
+    if (ctx)
+        multihash_memory_release(drop_scratchpads(ctx));
+    return multihash_memory_acquire(bytes, wait);
+}
+
+static int ctx_waits(const multihash_ctx* ctx)
+{
+    return !ctx || !ctx->nowait;
+}
+
+/* same layout scrypt_N_R_1_256_sp expects, including 64 bytes of alignment slack */
+static uint64_t scrypt_scratchpad_size(uint32_t N, uint32_t r)
+{
+    return 128 * (uint64_t) N * r + 128 * (uint64_t) r + 256 * (uint64_t) r + 64 + 64;
+}
+
+uint64_t multihash_scratchpad_size(int algo, const multihash_params* params)
+{
+    if (!multihash_algo_available(algo))
+        return 0;
+
+    switch (algo) {
+    case MULTIHASH_SCRYPT:
+        return params ? scrypt_scratchpad_size(params->N, params->r) : 0;
+    case MULTIHASH_SCRYPTN:
+        return params && params->nfactor <= 31 ? scrypt_scratchpad_size(1u << params->nfactor, 1) : 0;
+    case MULTIHASH_SCRYPTJANE:
+        return params && params->nfactor <= 30 ? scrypt_memory_size((unsigned char) params->nfactor, 0, 0) : 0;
+    case MULTIHASH_CRYPTONIGHT:
+        return cryptonight_ctx_size();
+    }
+    return 0;
+}
+
+static int hash_scrypt(multihash_ctx* ctx, const char* input, char* output, uint32_t N, uint32_t r, uint32_t len)
+{
+    uint64_t size = scrypt_scratchpad_size(N, r);
+    int wait = ctx_waits(ctx);
+    char* scratchpad;
+
+    if (N == 0 || r == 0 || size > (size_t) -1)
+        return MULTIHASH_EINVAL;
+
+    if (!ctx || !ctx_can_cache(ctx)) {
+        if (admit(NULL, size, wait) != MULTIHASH_OK)
+            return MULTIHASH_ENOMEM;
+        if (!(scratchpad = (char*) malloc((size_t) size))) {
+            multihash_memory_release(size);
+            return MULTIHASH_ENOMEM;
+        }
+        scrypt_N_R_1_256_sp(input, output, scratchpad, N, r, len);
+        free(scratchpad);
+        multihash_memory_release(size);
+        return MULTIHASH_OK;
+    }
+
+    ctx_enter(ctx);
+    if (ctx->scrypt_scratchpad_size < size) {
+        drop_scrypt_scratchpad(ctx);
+        if (admit(ctx, size, wait) != MULTIHASH_OK) {
+            ctx_leave(ctx);
+            return MULTIHASH_ENOMEM;
+        }
+        if (!(ctx->scrypt_scratchpad = (char*) malloc((size_t) size))) {
+            multihash_memory_release(size);
+            ctx_leave(ctx);
+            return MULTIHASH_ENOMEM;
+        }
+        ctx->scrypt_scratchpad_size = size;
+    }
+
+    scrypt_N_R_1_256_sp(input, output, ctx->scrypt_scratchpad, N, r, len);
+    ctx_leave(ctx);
+    return MULTIHASH_OK;
+}
+
+static int hash_scryptjane(multihash_ctx* ctx, const char* input, char* output, unsigned char nfactor, size_t len, int fast)
+{
+    uint64_t size = scrypt_memory_size(nfactor, 0, 0);
+    int rc;
+
+    /* nothing is cached here; what ctx holds, the governor can reclaim while we wait */
+    if (admit(NULL, size, ctx_waits(ctx)) != MULTIHASH_OK)
+        return MULTIHASH_ENOMEM;
+    if (fast)
+        rc = scryptjane_hash(input, len, (uint32_t*) output, nfactor);
+    else
+        rc = scryptjane_hash_reference(input, len, (uint32_t*) output, nfactor);
+    multihash_memory_release(size);
+
+    return rc == 0 ? MULTIHASH_OK : rc == -1 ? MULTIHASH_EINVAL : MULTIHASH_ENOMEM;
+}
+
+static int hash_cryptonight(multihash_ctx* ctx, const char* input, char* output, uint32_t len, int fast)
+{
+    void (*hash)(const char*, char*, uint32_t, struct cryptonight_ctx*) =
+        fast ? cryptonight_hash_ctx : cryptonight_hash_ctx_reference;
+    struct cryptonight_ctx* cn_ctx;
+    size_t size = cryptonight_ctx_size();
+    int wait = ctx_waits(ctx);
+
+    if (ctx && !ctx_can_cache(ctx))
+        ctx = NULL;
+
+    if (ctx) {
+        ctx_enter(ctx);
+        if (ctx->cn_ctx) {
+            hash(input, output, len, ctx->cn_ctx);
+            ctx_leave(ctx);
+            return MULTIHASH_OK;
+        }
+    }
+
+    if (admit(ctx, size, wait) != MULTIHASH_OK) {
+        if (ctx)
+            ctx_leave(ctx);
+        return MULTIHASH_ENOMEM;
+    }
+    if (!(cn_ctx = cryptonight_alloc_ctx())) {
+        multihash_memory_release(size);
+        if (ctx)
+            ctx_leave(ctx);
+        return MULTIHASH_ENOMEM;
+    }
+    hash(input, output, len, cn_ctx);
+
+    if (ctx) {
+        ctx->cn_ctx = cn_ctx;
+        ctx_leave(ctx);
+    } else {
+        cryptonight_free_ctx(cn_ctx);
+        multihash_memory_release(size);
+    }
+    return MULTIHASH_OK;
+}
+
+/* algorithms whose single-hash path is not the reference code */
+static int has_fast_path(int algo)
+{
+    return algo == MULTIHASH_SCRYPTJANE || algo == MULTIHASH_CRYPTONIGHT;
+}
+
+/*
+ * fast is 0 to run the reference code of algorithms that have a faster path
+ * (see multihash_crosscheck_configure), which multihash_hash samples against.
+ */
+static int hash_one(multihash_ctx* ctx, int algo, const multihash_params* params,
+                    const char* in, size_t len, char* out, int fast)
+{
+    if (algos[algo].fn) {
+        algos[algo].fn(in, out, (uint32_t) len);
+        return MULTIHASH_OK;
+    }
+
+    switch (algo) {
+    case MULTIHASH_SCRYPT:
+        if (!params)
+            return MULTIHASH_EINVAL;
+        return hash_scrypt(ctx, in, out, params->N, params->r, (uint32_t) len);
+    case MULTIHASH_SCRYPTN:
+        if (!params || params->nfactor > 31)
+            return MULTIHASH_EINVAL;
+        return hash_scrypt(ctx, in, out, 1u << params->nfactor, 1, (uint32_t) len);
+    case MULTIHASH_SCRYPTJANE:
+        if (!params || params->nfactor > 30)
+            return MULTIHASH_EINVAL;
+        return hash_scryptjane(ctx, in, out, (unsigned char) params->nfactor, len, fast);
+    case MULTIHASH_BCRYPT:
+        bcrypt_hash(in, out);
+        return MULTIHASH_OK;
+    case MULTIHASH_CRYPTONIGHT:
+        return hash_cryptonight(ctx, in, out, (uint32_t) len, fast);
+    case MULTIHASH_BOOLBERRY:
+        if (!params || !params->scratchpad || params->scratchpad_len < 32)
+            return MULTIHASH_EINVAL;
+        boolberry_hash(in, (uint32_t) len, params->scratchpad, params->scratchpad_len, out, params->height);
+        return MULTIHASH_OK;
+    }
+
+    return MULTIHASH_EINVAL;
+}
+
+int multihash_hash(multihash_ctx* ctx, int algo, const multihash_params* params,
+                   const void* input, size_t len, void* output)
+{
+    uint64_t start = 0, service;
+    uint64_t perf[MULTIHASH_PERF_COUNTERS + 2];
+    int fast, rc, profiled, recorded;
+
+    if (!multihash_algo_available(algo) || len > UINT32_MAX)
+        return MULTIHASH_EINVAL;
+
+    /* hash__start: algo, len; hash__done: algo, len, status, service time in ns */
+    MULTIHASH_PROBE2(hash__start, algo, len);
+    if (MULTIHASH_PROBE_ENABLED(hash__done))
+        start = multihash_probe_ns();
+
+    profiled = PROFILED(algo, perf);
+    recorded = RECORDED(algo);
+    fast = multihash_fast_path_enabled(algo);
+    rc = hash_one(ctx, algo, params, (const char*) input, len, (char*) output, fast);
+    if (recorded)
+        multihash_flight_end(algo, params, rc);
+    if (profiled)
+        multihash_perf_end(algo, 1, perf);
+    if (rc == MULTIHASH_OK && fast && has_fast_path(algo))
+        multihash_crosscheck_sample(algo, params, input, len, output);
+
+    service = start ? multihash_probe_ns() - start : 0;
+    MULTIHASH_PROBE4(hash__done, algo, len, rc, service);
+    return rc;
+}
+
+int multihash_hash_reference(int algo, const multihash_params* params,
+                             const void* input, size_t len, void* output)
+{
+    if (!multihash_algo_available(algo) || len > UINT32_MAX)
+        return MULTIHASH_EINVAL;
+
+    return hash_one(NULL, algo, params, (const char*) input, len, (char*) output, 0);
+}
+
+/*
+ * A cryptonight batch with its main loops interleaved, in scratchpads of its
+ * own. They are extra memory: without room in the budget right away this
+ * returns MULTIHASH_ENOMEM and the batch goes one hash at a time instead.
+ */
+static int hash_cryptonight_interleaved(int algo, const multihash_params* params, const char* in,
+                                        size_t input_stride, size_t len, size_t count, char* out)
+{
+    size_t lanes = count < MULTIHASH_INTERLEAVE_MAX ? count : MULTIHASH_INTERLEAVE_MAX;
+    uint64_t size = (uint64_t) cryptonight_ctx_size() * lanes;
+    char* ctxs;
+    size_t i;
+
+    if (multihash_memory_acquire(size, 0) != MULTIHASH_OK)
+        return MULTIHASH_ENOMEM;
+    if (!(ctxs = (char*) malloc((size_t) size))) {
+        multihash_memory_release(size);
+        return MULTIHASH_ENOMEM;
+    }
+
+    cryptonight_hash_interleaved(in, input_stride, (uint32_t) len, count, out, (struct cryptonight_ctx*) ctxs);
+    free(ctxs);
+    multihash_memory_release(size);
+
+    for (i = 0; i < count; i++)
+        multihash_crosscheck_sample(algo, params, in + i * input_stride, len, out + i * MULTIHASH_OUTPUT_SIZE);
+    return MULTIHASH_OK;
+}
+
+static int hash_batch(multihash_ctx* ctx, int algo, const multihash_params* params,
+                      const char* in, size_t input_stride, size_t len, size_t count, char* out)
+{
+    size_t i;
+    int rc;
+
+    /* consecutive headers of one job share the prefix midstates */
+    if (algo == MULTIHASH_HEFTY1 && multihash_fast_path_enabled(algo)) {
+        hefty1_hash_batch(in, input_stride, (uint32_t) len, count, out);
+        for (i = 0; i < count; i++)
+            multihash_crosscheck_sample(algo, params, in + i * input_stride, len, out + i * MULTIHASH_OUTPUT_SIZE);
+        return MULTIHASH_OK;
+    }
+
+    if (algo == MULTIHASH_CRYPTONIGHT && count > 1 && multihash_fast_path_enabled(algo) &&
+        hash_cryptonight_interleaved(algo, params, in, input_stride, len, count, out) == MULTIHASH_OK)
+        return MULTIHASH_OK;
+
+    if (algos[algo].fn) {
+        for (i = 0; i < count; i++)
+            algos[algo].fn(in + i * input_stride, out + i * MULTIHASH_OUTPUT_SIZE, (uint32_t) len);
+        return MULTIHASH_OK;
+    }
+
+    for (i = 0; i < count; i++) {
+        rc = multihash_hash(ctx, algo, params, in + i * input_stride, len, out + i * MULTIHASH_OUTPUT_SIZE);
+        if (rc != MULTIHASH_OK)
+            return rc;
+    }
+    return MULTIHASH_OK;
+}
+
+int multihash_hash_batch(multihash_ctx* ctx, int algo, const multihash_params* params,
+                         const void* inputs, size_t input_stride, size_t len, size_t count,
+                         void* outputs)
+{
+    uint64_t start = 0, service;
+    uint64_t perf[MULTIHASH_PERF_COUNTERS + 2];
+    int rc, profiled;
+
+    if (!multihash_algo_available(algo) || len > UINT32_MAX)
+        return MULTIHASH_EINVAL;
+
+    /* batch__start: algo, count, len; batch__done: algo, count, status, service time in ns */
+    MULTIHASH_PROBE3(batch__start, algo, count, len);
+    if (MULTIHASH_PROBE_ENABLED(batch__done))
+        start = multihash_probe_ns();
+
+    profiled = PROFILED(algo, perf);
+    rc = hash_batch(ctx, algo, params, (const char*) inputs, input_stride, len, count, (char*) outputs);
+    if (profiled)
+        multihash_perf_end(algo, count, perf);
+
+    service = start ? multihash_probe_ns() - start : 0;
+    MULTIHASH_PROBE4(batch__done, algo, count, rc, service);
+    return rc;
+}
+
+int multihash_hash_batch_filtered(multihash_ctx* ctx, int algo, const multihash_params* params,
+                                  multihash_share_filter* filter, const void* inputs,
+                                  size_t input_stride, size_t len, size_t count,
+                                  void* outputs, uint8_t* status)
+{
+    const char* in = (const char*) inputs;
+    char* out = (char*) outputs;
+    size_t i, hashed = 0;
+    int rc, profiled;
+
+    uint64_t start = 0, service;
+    uint64_t perf[MULTIHASH_PERF_COUNTERS + 2];
+
+    if (!filter || !multihash_algo_available(algo) || len > UINT32_MAX)
+        return MULTIHASH_EINVAL;
+
+    MULTIHASH_PROBE3(batch__start, algo, count, len);
+    if (MULTIHASH_PROBE_ENABLED(batch__done))
+        start = multihash_probe_ns();
+
+    profiled = PROFILED(algo, perf);
+    rc = MULTIHASH_OK;
+    for (i = 0; i < count && rc == MULTIHASH_OK; i++) {
+        status[i] = multihash_share_filter_insert(filter, in + i * input_stride, len) != 0;
+        if (status[i]) {
+            rc = multihash_hash(ctx, algo, params, in + i * input_stride, len, out + i * MULTIHASH_OUTPUT_SIZE);
+            hashed++;
+        }
+    }
+    if (profiled)
+        multihash_perf_end(algo, hashed, perf);
+
+    service = start ? multihash_probe_ns() - start : 0;
+    MULTIHASH_PROBE4(batch__done, algo, count, rc, service);
+    return rc;
+}
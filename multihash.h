@@ -0,0 +1,575 @@
+#ifndef MULTIHASH_H
+#define MULTIHASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+	libmultihash: the algorithms behind the multihashing Node addon, as a plain C library.
+
+	Every algorithm produces a 32 byte digest. Algorithms are addressed by a stable
+	numeric id (never renumbered, new ids are only appended) or by the same name the
+	Node module exports them under.
+
+	The individual *_hash functions (x11_hash, quark_hash, ...) are exported as well,
+	see their headers.
+*/
+
+#define MULTIHASH_VERSION_MAJOR 0
+#define MULTIHASH_VERSION_MINOR 1
+
+#define MULTIHASH_OUTPUT_SIZE 32
+
+enum multihash_algo {
+	MULTIHASH_QUARK = 0,
+	MULTIHASH_X11,
+	MULTIHASH_SCRYPT,
+	MULTIHASH_SCRYPTN,
+	MULTIHASH_SCRYPTJANE,
+	MULTIHASH_KECCAK,
+	MULTIHASH_BCRYPT,
+	MULTIHASH_SKEIN,
+	MULTIHASH_GROESTL,
+	MULTIHASH_GROESTLMYRIAD,
+	MULTIHASH_BLAKE,
+	MULTIHASH_FUGUE,
+	MULTIHASH_QUBIT,
+	MULTIHASH_HEFTY1,
+	MULTIHASH_SHAVITE3,
+	MULTIHASH_CRYPTONIGHT,
+	MULTIHASH_CRYPTONIGHT_FAST,
+	MULTIHASH_X13,
+	MULTIHASH_BOOLBERRY,
+	MULTIHASH_NIST5,
+	MULTIHASH_SHA1,
+	MULTIHASH_X15,
+	MULTIHASH_FRESH,
+	MULTIHASH_SOPHIA,
+	MULTIHASH_ALGO_COUNT
+};
+
+/* Return codes, 0 is success */
+#define MULTIHASH_OK       0
+#define MULTIHASH_EINVAL  -1 /* unknown algorithm or bad parameters */
+#define MULTIHASH_ENOMEM  -2 /* scratchpad allocation failed or larger than the memory budget */
+#define MULTIHASH_EDUPLICATE -3 /* the share filter has seen this share before */
+
+/*
+	Per-algorithm parameters, ignored by algorithms that take none.
+
+	scrypt:      N, r
+	scryptn:     nfactor (N = 1 << nfactor, r = 1)
+	scryptjane:  nfactor (as returned by GetNfactorJane)
+	boolberry:   scratchpad, scratchpad_len, height
+*/
+typedef struct multihash_params {
+	uint32_t N;
+	uint32_t r;
+	uint32_t nfactor;
+	const char *scratchpad;
+	uint64_t scratchpad_len;
+	uint64_t height;
+} multihash_params;
+
+const char *multihash_algo_name(int algo);
+int multihash_algo_lookup(const char *name);
+int multihash_algo_available(int algo); /* 0 for algorithms this build left out */
+
+/*
+	Kernel variants: alternative implementations of one algorithm that produce identical
+	digests but run at different speeds depending on the cpu (e.g. the avx, ssse3, sse2
+	and portable scryptjane mixes). Algorithms with a single implementation have no
+	variants. By default the fastest variant the cpu supports on paper runs; select pins
+	another one process-wide (what the autotuner measured, see tune.js) and -1 returns
+	to the default. name is NULL for variants this cpu cannot run, and select refuses
+	them with MULTIHASH_EINVAL.
+*/
+int multihash_variant_count(int algo);
+const char *multihash_variant_name(int algo, int variant);
+int multihash_variant_select(int algo, int variant);
+int multihash_variant_selected(int algo);
+
+/*
+	x86-64 microarchitecture levels: 1 is the baseline, 2 x86-64-v2 (sse4.2, popcnt),
+	3 x86-64-v3 (avx2, bmi2, fma). multihash_isa_level is the highest level the cpu and
+	the OS support, multihash_isa_built the level this copy of the library was compiled
+	for; code built for a level must not run below it. Both are 0 on other architectures.
+*/
+int multihash_isa_level(void);
+int multihash_isa_built(void);
+
+/*
+	A context owns the scratchpads of the memory-hard algorithms (the 2 MiB cryptonight
+	state, the scrypt V array) and keeps them between calls. A context must only be used
+	by one thread at a time; use one per thread. Passing NULL where a context is expected
+	allocates and frees scratch memory on every call instead.
+
+	Cached scratchpads count against the memory budget (see below) until the context is
+	freed or trimmed, or until a call waiting for memory reclaims them: between calls,
+	a context's scratchpads may be freed by another thread, and its next call
+	allocates them again.
+*/
+typedef struct multihash_ctx multihash_ctx;
+
+multihash_ctx *multihash_ctx_new(void);
+void multihash_ctx_free(multihash_ctx *ctx);
+void multihash_ctx_trim(multihash_ctx *ctx);
+
+/*
+	wait 0: calls on ctx whose scratchpad does not fit the memory budget right away fail
+	with MULTIHASH_ENOMEM instead of queueing, for threads that must not block (an event
+	loop). Contexts wait by default.
+*/
+void multihash_ctx_set_wait(multihash_ctx *ctx, int wait);
+
+/*
+	Memory budget, shared by every thread and context in the process. Before a memory-hard
+	algorithm (scrypt, scryptn, scryptjane, cryptonight) allocates its scratchpad, the
+	scratchpad is admitted against the budget; while it does not fit, the call waits its
+	turn in a FIFO queue, after dropping the scratchpads its own context caches. The
+	head of the queue frees the scratchpads of contexts that are not in a call before
+	it sleeps, so memory cached by idle threads never holds it up. A scratchpad larger
+	than the whole budget fails at once with MULTIHASH_ENOMEM. The default budget of 0
+	means unlimited, but usage is tracked either way.
+
+	multihash_scratchpad_size is what a call with these parameters will be charged, 0
+	for algorithms that allocate nothing (boolberry hashes over the caller's scratchpad).
+	acquire/release let applications charge memory of their own against the same budget.
+*/
+typedef struct multihash_memory_stats {
+	uint64_t budget;
+	uint64_t in_use;
+	uint64_t peak;
+	uint64_t waiting;     /* callers queued right now */
+	uint64_t admitted;    /* totals since start */
+	uint64_t queued;
+	uint64_t rejected;    /* waiting calls refused for being larger than the budget */
+} multihash_memory_stats;
+
+/*
+	Copies of the library linked into separate modules (the per-family Node modules)
+	each start with a budget of their own. Passing multihash_memory_governor() of one
+	copy to multihash_memory_use_governor() of the others, before they allocate
+	anything, makes them share a single budget.
+*/
+void *multihash_memory_governor(void);
+void multihash_memory_use_governor(void *governor);
+
+void multihash_memory_set_budget(uint64_t bytes);
+void multihash_memory_get_stats(multihash_memory_stats *stats);
+void multihash_memory_reset_peak(void);
+int multihash_memory_acquire(uint64_t bytes, int wait);
+void multihash_memory_release(uint64_t bytes);
+uint64_t multihash_scratchpad_size(int algo, const multihash_params *params);
+
+int multihash_hash(multihash_ctx *ctx, int algo, const multihash_params *params,
+                   const void *input, size_t len, void *output);
+
+/*
+	Hashes count inputs of len bytes each, read input_stride bytes apart, writing
+	count consecutive 32 byte digests to outputs. Synchronous, on the calling thread.
+	Cryptonight batches run up to MULTIHASH_INTERLEAVE_MAX hashes at a time interleaved
+	(see multihash_interleave) when the memory budget has room for their scratchpads,
+	one at a time otherwise.
+*/
+int multihash_hash_batch(multihash_ctx *ctx, int algo, const multihash_params *params,
+                         const void *inputs, size_t input_stride, size_t len, size_t count,
+                         void *outputs);
+
+/*
+	Hashes with the scalar reference code: the portable kernel whatever variant is
+	selected, and none of the batch shortcuts. Scratchpads are allocated per call
+	(and charged against the memory budget).
+*/
+int multihash_hash_reference(int algo, const multihash_params *params,
+                             const void *input, size_t len, void *output);
+
+/*
+	Sampling cross-check of the fast paths (the SIMD scryptjane kernels, the AES-NI
+	cryptonight kernel, the hefty1 batch midstates, ...). About one in `one_in` hashes a fast path produces, with
+	inputs up to MULTIHASH_CROSSCHECK_INPUT_MAX bytes, is recomputed with
+	multihash_hash_reference on a background thread; 0 turns sampling off (the
+	default). With disable_on_mismatch, the first mismatch switches that algorithm
+	to the reference code for the rest of the process, until
+	multihash_fast_path_enable turns it back on. The hashing threads never wait on
+	the check; samples arriving while the queue is full are dropped and counted.
+	flush waits until every queued sample has been checked.
+*/
+#define MULTIHASH_CROSSCHECK_INPUT_MAX 256
+
+typedef struct multihash_crosscheck_stats {
+	uint64_t sampled;
+	uint64_t checked;
+	uint64_t mismatches;
+	uint64_t dropped;
+	int fast_path;        /* 0 once disabled */
+} multihash_crosscheck_stats;
+
+void multihash_crosscheck_configure(uint32_t one_in, int disable_on_mismatch);
+void multihash_crosscheck_flush(void);
+void multihash_crosscheck_get_stats(int algo, multihash_crosscheck_stats *stats);
+int multihash_fast_path_enabled(int algo);
+void multihash_fast_path_enable(int algo, int enable);
+
+/*
+	Hardware performance counters per algorithm, from perf_event_open on Linux. Once
+	an algorithm is selected with multihash_perf_profile, every multihash_hash and
+	multihash_hash_batch call for it reads the calling thread's counters before and
+	after, and the differences add up into per-algorithm totals. MULTIHASH_PERF_CHAIN
+	stands for all runtime hash chains (hash a chain of one primitive to profile it
+	alone). Counters are user space only and opened per thread on its first profiled
+	call. Those the kernel, the cpu or a container's seccomp policy refuse are left
+	out: multihash_perf_available returns the counters that opened on any thread so
+	far (bit 1 << MULTIHASH_PERF_*), and stats.counted stays 0 while none did. When
+	the pmu multiplexes, counts are scaled to the time the counters ran.
+*/
+enum multihash_perf_counter {
+	MULTIHASH_PERF_CYCLES = 0,
+	MULTIHASH_PERF_INSTRUCTIONS,
+	MULTIHASH_PERF_L1D_MISSES,        /* L1 data cache read misses */
+	MULTIHASH_PERF_LLC_REFERENCES,    /* last level cache accesses, roughly the L2 misses */
+	MULTIHASH_PERF_LLC_MISSES,
+	MULTIHASH_PERF_DTLB_MISSES,       /* data TLB read misses */
+	MULTIHASH_PERF_COUNTERS
+};
+
+#define MULTIHASH_PERF_CHAIN MULTIHASH_ALGO_COUNT
+
+typedef struct multihash_perf_stats {
+	uint64_t calls;
+	uint64_t hashes;
+	uint64_t counted;     /* calls the counters were read for */
+	uint64_t counters[MULTIHASH_PERF_COUNTERS];
+} multihash_perf_stats;
+
+const char *multihash_perf_counter_name(int counter);
+int multihash_perf_profile(int algo, int enable);
+int multihash_perf_profiling(int algo);
+unsigned multihash_perf_available(void);
+int multihash_perf_error(void);   /* errno of the last counter that failed to open, 0 if none */
+void multihash_perf_get_stats(int algo, multihash_perf_stats *stats);
+void multihash_perf_reset(void);
+
+/*
+	Flight recorder for tail latency, on unless configured off: the slowest scrypt,
+	scryptn, scryptjane and cryptonight calls of the last window_ms (capacity of them,
+	32 in the last minute by default), each with its parameters, the time spent in
+	every phase and the calling thread's page faults and context switches over the
+	call (getrusage). A call costs a few clock reads and one getrusage unless it is
+	slow enough to be kept. dump copies the records out slowest first.
+
+	Phases: alloc is admission against the memory budget and scratchpad allocation
+	(the scrypt-jane V array, the cryptonight AES context); init is PBKDF2 or keccak
+	and filling the scratchpad; main is the memory-hard loop; final is what follows
+	it. Voluntary switches point at waits (the budget queue, major faults, locks),
+	involuntary ones at preemption. A main loop slow without either is the cpu itself,
+	e.g. a throttled core (cpu is where the call finished).
+
+	As with the memory governor, separate copies of the library can share one table:
+	pass multihash_flight_recorder() of one to multihash_flight_use_recorder() of the
+	others.
+*/
+enum multihash_flight_phase {
+	MULTIHASH_PHASE_ALLOC = 0,
+	MULTIHASH_PHASE_INIT,
+	MULTIHASH_PHASE_MAIN,
+	MULTIHASH_PHASE_FINAL,
+	MULTIHASH_PHASE_COUNT
+};
+
+#define MULTIHASH_FLIGHT_MAX 1024
+
+typedef struct multihash_flight_record {
+	int algo;
+	int status;
+	uint32_t N;
+	uint32_t r;
+	uint32_t nfactor;
+	int cpu;                          /* -1 where unknown */
+	uint64_t height;
+	uint64_t start_ns;                /* CLOCK_REALTIME */
+	uint64_t total_ns;
+	uint64_t phase_ns[MULTIHASH_PHASE_COUNT];
+	uint64_t minor_faults;
+	uint64_t major_faults;
+	uint64_t voluntary_switches;
+	uint64_t involuntary_switches;
+} multihash_flight_record;
+
+int multihash_flight_configure(size_t capacity, uint64_t window_ms);   /* capacity 0 turns it off */
+size_t multihash_flight_dump(multihash_flight_record *records, size_t max);
+void multihash_flight_reset(void);
+void *multihash_flight_recorder(void);
+void multihash_flight_use_recorder(void *recorder);
+void multihash_flight_mark(int phase);   /* for the kernels: phase starts now */
+
+/*
+	For the kernels' batch paths: runs count (at most MULTIHASH_INTERLEAVE_MAX)
+	independent hashes of one kind as coroutines on the calling thread. states holds
+	them, state_size bytes apart. step advances one hash by a stage, ending with a
+	prefetch of the scratchpad line its next stage reads, and returns 0 once that hash
+	is done. Each stage is followed by a stage of another hash in flight, so their
+	cache misses overlap instead of queueing up one after the other.
+*/
+#define MULTIHASH_INTERLEAVE_MAX 4
+
+typedef int (*multihash_step_fn)(void *state);
+
+int multihash_interleave(multihash_step_fn step, void *states, size_t state_size, size_t count);
+
+/*
+	Duplicate share filter, one per job: a lock-free set of share keys (e.g. job id,
+	extranonce, nonce and ntime, or simply the block header) that any number of threads
+	may insert into concurrently. bloom_bits > 0 adds a Bloom filter of that many bits
+	in front of the set. Clear or free it when the job expires; clear must not race
+	with inserts. The set stores 64 bit fingerprints, so a false duplicate has a
+	probability of about count / 2^64 per share.
+
+	insert returns 1 for a new key, 0 for a duplicate, MULTIHASH_ENOMEM once capacity
+	keys are stored.
+*/
+typedef struct multihash_share_filter multihash_share_filter;
+
+multihash_share_filter *multihash_share_filter_new(size_t capacity, size_t bloom_bits);
+void multihash_share_filter_free(multihash_share_filter *filter);
+void multihash_share_filter_clear(multihash_share_filter *filter);
+size_t multihash_share_filter_count(const multihash_share_filter *filter);
+int multihash_share_filter_insert(multihash_share_filter *filter, const void *key, size_t len);
+int multihash_share_filter_contains(const multihash_share_filter *filter, const void *key, size_t len);
+
+/*
+	Like multihash_hash_batch, but every input is first inserted into filter (keyed on
+	the input bytes) and duplicates are skipped before any hashing. status[i] is set to
+	1 for hashed inputs and 0 for duplicates, whose output is left untouched. Once the
+	filter is full, inputs are hashed without being recorded (the check fails open).
+*/
+int multihash_hash_batch_filtered(multihash_ctx *ctx, int algo, const multihash_params *params,
+                                  multihash_share_filter *filter, const void *inputs,
+                                  size_t input_stride, size_t len, size_t count,
+                                  void *outputs, uint8_t *status);
+
+/*
+	Stratum jobs for Bitcoin-framed coins: the static parts of one mining.notify. A share
+	is rebuilt as coinbase1 + extranonce1 + extranonce2 + coinbase2, its sha256d folded
+	with the merkle branches (root = sha256d(root + branch)), and the 80 byte header
+	version, prevhash, root, ntime, nbits, nonce hashed with the job's algorithm.
+	Branches and prevhash are 32 bytes each in the byte order they have in the header;
+	version, ntime, nbits and nonce are numbers, written little endian. extranonce1 may
+	be left out of the template and passed per share instead (NULL uses the job's);
+	extranonce2_len 0 accepts any length up to MULTIHASH_JOB_EXTRANONCE_MAX.
+
+	A job is immutable and may be shared between threads. header (80 bytes) may be NULL
+	in multihash_job_hash.
+
+	block_target is the network target of the job (32 bytes, little endian as in
+	multihash_meets_target); NULL takes the one nbits encodes. multihash_job_is_block
+	tells a block candidate from a plain share, 0 for jobs without a valid target.
+*/
+#define MULTIHASH_JOB_EXTRANONCE_MAX 32
+
+typedef struct multihash_job multihash_job;
+
+typedef struct multihash_job_template {
+	int algo;
+	multihash_params params;
+	const void *coinbase1;
+	size_t coinbase1_len;
+	const void *extranonce1;
+	size_t extranonce1_len;
+	size_t extranonce2_len;
+	const void *coinbase2;
+	size_t coinbase2_len;
+	const void *merkle_branches;
+	size_t merkle_count;
+	uint32_t version;
+	const void *prevhash;
+	uint32_t nbits;
+	const void *block_target;
+} multihash_job_template;
+
+multihash_job *multihash_job_new(const multihash_job_template *tmpl);
+void multihash_job_free(multihash_job *job);
+int multihash_job_header(const multihash_job *job, const void *extranonce1, size_t extranonce1_len,
+                         const void *extranonce2, size_t extranonce2_len,
+                         uint32_t ntime, uint32_t nonce, void *header);
+int multihash_job_hash(multihash_ctx *ctx, const multihash_job *job, const void *extranonce1, size_t extranonce1_len,
+                       const void *extranonce2, size_t extranonce2_len, uint32_t ntime, uint32_t nonce,
+                       void *header, void *output);
+int multihash_job_is_block(const multihash_job *job, const void *hash);
+
+/*
+	Share difficulty. Digests and targets are 256 bit little endian integers, as the
+	hash functions output them. The difficulty of a digest is diff1 / digest, computed
+	in double precision (diff1 is the difficulty 1 target, e.g. 0xffff * 2^208 for
+	bitcoin-style coins). A digest meets a target when digest <= target.
+*/
+double multihash_le256_to_double(const void *value);
+double multihash_hash_to_difficulty(const void *hash, double diff1);
+void multihash_hash_to_difficulty_batch(const void *hashes, size_t count, double diff1, double *difficulties);
+int multihash_meets_target(const void *hash, const void *target);
+void multihash_meets_target_batch(const void *hashes, size_t count, const void *target, uint8_t *results);
+
+/* the 256 bit target of a compact nbits; MULTIHASH_EINVAL (and a zero target) when negative or overflowing */
+int multihash_nbits_to_target(uint32_t nbits, void *target);
+
+/*
+	Submission/completion rings over caller-provided shared memory, e.g. a JS
+	SharedArrayBuffer (see ring.js). Producers write share records into the submission
+	ring, multihash_ring_start's worker threads hash them and post results to the
+	completion ring, which consumers poll. Both rings are lock-free bounded MPMC queues;
+	nothing is copied into or out of V8 and no per-share allocation happens. A worker
+	that finds the ring empty for about 50 ms trims its context.
+
+	Layout, all fields little endian, slots a power of two:
+	  header      MULTIHASH_RING_HEADER_SIZE bytes: magic u32, version u32, slots u32,
+	              flags u32 at 0, then one 64 byte line each for the submission
+	              enqueue/dequeue and the completion enqueue/dequeue positions (u32)
+	  submission  slots * 192: seq u32, id u32, algo u8, flags u8 (1: has target), len u16,
+	              param0 u32 (N for scrypt, nfactor for scryptn/scryptjane), param1 u32 (r),
+	              4 reserved, submitted u64 at 24, target[32] at 32, input[128] at 64
+
+	While header flag 1 is set (a tracer is attached to the ring__dequeue probe, see
+	probes.h) producers write the CLOCK_MONOTONIC time in ns to submitted, from which
+	the workers report queue wait; otherwise they may leave it alone.
+	  completion  slots * 64: seq u32, id u32, status i32 (MULTIHASH_OK or an error),
+	              meets_target u32, hash[32] at 16
+
+	submit returns 1 when queued, 0 when the ring is full; poll returns 1 with a
+	completion, 0 when there is none. Workers sleep briefly when idle; wake makes them
+	look again at once.
+
+	start_filtered also inserts every input into filter (see multihash_share_filter)
+	before hashing it; a duplicate is not hashed and completes with MULTIHASH_EDUPLICATE.
+	Once the filter is full, inputs are hashed without being recorded. The filter must
+	outlive the workers, and may only be cleared while no submission is in flight.
+*/
+#define MULTIHASH_RING_MAGIC          0x4752484d /* "MHRG" */
+#define MULTIHASH_RING_VERSION        1
+#define MULTIHASH_RING_HEADER_SIZE    320
+#define MULTIHASH_RING_SUBMIT_SIZE    192
+#define MULTIHASH_RING_COMPLETE_SIZE  64
+#define MULTIHASH_RING_INPUT_MAX      128
+
+typedef struct multihash_ring_completion {
+	uint32_t id;
+	int32_t status;
+	uint32_t meets_target;
+	uint8_t hash[MULTIHASH_OUTPUT_SIZE];
+} multihash_ring_completion;
+
+typedef struct multihash_ring_workers multihash_ring_workers;
+
+size_t multihash_ring_size(uint32_t slots);
+int multihash_ring_init(void *mem, size_t size, uint32_t slots);
+int multihash_ring_submit(void *mem, uint32_t id, int algo, const multihash_params *params,
+                          const void *input, size_t len, const void *target);
+int multihash_ring_poll(void *mem, multihash_ring_completion *completion);
+
+multihash_ring_workers *multihash_ring_start(void *mem, unsigned threads);
+multihash_ring_workers *multihash_ring_start_filtered(void *mem, unsigned threads, multihash_share_filter *filter);
+void multihash_ring_wake(multihash_ring_workers *workers);
+void multihash_ring_stop(multihash_ring_workers *workers);
+
+/*
+	Mixed batches: tasks of any algorithm and parameters, hashed by a pool of worker
+	threads that balance them by work stealing. Tasks fall into a light class (the sph
+	chains, sha1, ...) and a heavy one (the memory-hard algorithms, bcrypt, boolberry);
+	all light tasks are started before any heavy one, and idle workers take work from
+	the others until the batch is done.
+
+	A scheduler runs threads worker threads. submit queues a batch and returns at once;
+	complete is called on a worker thread once every task has its status (what
+	multihash_hash returned) and output, or before submit returns for an empty batch,
+	and not at all when submit fails. Batches are started in submission order: the
+	workers move on to the next one as soon as every task of the current one is taken,
+	so one batch's last heavy tasks overlap with the start of the next. run submits a
+	batch and waits for it. done, when set, is called on the worker thread as soon as
+	its task is hashed, while the rest of the batch is still running. Freeing a
+	scheduler finishes the batches it has queued. A worker left without work for 50 ms
+	trims its contexts. Modules that each link these sources may share one scheduler:
+	a batch is hashed by the multihash_hash of the module that submitted it.
+*/
+typedef struct multihash_task {
+	int algo;
+	multihash_params params;
+	const void *input;
+	size_t len;
+	void *output;               /* MULTIHASH_OUTPUT_SIZE bytes */
+	int status;
+	void (*done)(struct multihash_task *task);
+	void *arg;                  /* for done */
+} multihash_task;
+
+typedef struct multihash_scheduler multihash_scheduler;
+
+typedef void (*multihash_batch_fn)(void *arg, int status);
+
+multihash_scheduler *multihash_scheduler_new(unsigned threads);
+void multihash_scheduler_free(multihash_scheduler *scheduler);
+unsigned multihash_scheduler_threads(const multihash_scheduler *scheduler);
+int multihash_scheduler_submit(multihash_scheduler *scheduler, multihash_task *tasks, size_t count,
+                               multihash_batch_fn complete, void *arg);
+int multihash_scheduler_run(multihash_scheduler *scheduler, multihash_task *tasks, size_t count);
+
+/*
+	Shares of one stratum job as a scheduler batch: count headers (80 bytes each) and
+	hashes (32 bytes each) are written back to back, and statuses gets what hashing
+	each one returned. A share that meets the job's block target is handed to on_block
+	from the worker thread that hashed it, without waiting for the rest of the batch.
+	Fails with MULTIHASH_EINVAL, before hashing anything, when a share does not fit the
+	job (see multihash_job_header).
+
+	submit_batch builds the headers on the calling thread, queues the batch and returns;
+	shares may be freed then, while job, headers, hashes and statuses must stay until
+	complete is called with the same arg (see multihash_scheduler_submit). A batch gets
+	no priority for its block candidates: on_block for a share of a later batch comes
+	only after every task of the batches queued before it has been started.
+*/
+typedef struct multihash_job_share {
+	const void *extranonce1;    /* NULL for the job's */
+	size_t extranonce1_len;
+	const void *extranonce2;
+	size_t extranonce2_len;
+	uint32_t ntime;
+	uint32_t nonce;
+} multihash_job_share;
+
+typedef void (*multihash_block_fn)(void *arg, size_t index, const void *header, const void *hash);
+
+int multihash_job_hash_batch(multihash_scheduler *scheduler, const multihash_job *job,
+                             const multihash_job_share *shares, size_t count,
+                             void *headers, void *hashes, int *statuses,
+                             multihash_block_fn on_block, void *arg);
+int multihash_job_submit_batch(multihash_scheduler *scheduler, const multihash_job *job,
+                               const multihash_job_share *shares, size_t count,
+                               void *headers, void *hashes, int *statuses,
+                               multihash_block_fn on_block, multihash_batch_fn complete, void *arg);
+
+/*
+	Hash chains composed at runtime from the sph 512 bit primitives (blake, bmw, groestl,
+	jh, keccak, skein, luffa, cubehash, shavite, simd, echo, hamsi, fugue, shabal,
+	whirlpool), x11 style: stage one hashes the input, each further stage the previous
+	64 byte digest, and the first 32 bytes of the last digest are the output.
+	A chain is immutable once built and may be shared between threads.
+*/
+#define MULTIHASH_CHAIN_MAX_STAGES 64
+
+typedef struct multihash_chain multihash_chain;
+
+int multihash_chain_primitive_lookup(const char *name);
+multihash_chain *multihash_chain_new(const int *primitives, size_t count);
+void multihash_chain_free(multihash_chain *chain);
+
+int multihash_chain_hash(const multihash_chain *chain, const void *input, size_t len, void *output);
+int multihash_chain_hash_batch(const multihash_chain *chain, const void *inputs, size_t input_stride,
+                               size_t len, size_t count, void *outputs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
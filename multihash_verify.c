@@ -0,0 +1,454 @@
+/*
+	multihash-verify: re-verify recorded shares against libmultihash.
+
+	usage: multihash-verify [-t threads] [-f bin|hex] [-o mismatches] [-s scratchpad] file
+
+	The input file is mmap'd and split into batches of records that worker threads
+	claim one at a time, so memory use does not grow with the size of the file.
+	Mismatches are written as "index algo computed claimed" lines (index is the
+	record number, or the line number for hex input), throughput and
+	per-algorithm totals go to stderr. Exit status is 0 when every record verified,
+	1 on mismatches or malformed records, 2 on usage or I/O errors.
+
+	Binary records (all integers little endian):
+
+		uint8   algo        multihash_algo id, see multihash.h
+		uint8   reserved
+		uint16  input_len
+		uint32  param0      scrypt N, scryptn/scryptjane nfactor, boolberry height (low)
+		uint32  param1      scrypt r, boolberry height (high)
+		uint32  reserved
+		uint8   input[input_len]
+		uint8   claimed[32]
+
+	Hex records, one per line, blank lines and lines starting with # ignored:
+
+		algo[:param0[:param1]] input_hex claimed_hex
+
+	The boolberry scratchpad is shared by all records and passed with -s.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "multihash.h"
+
+#define RECORD_HEADER_SIZE  16
+#define MAX_INPUT_LEN       65535
+#define BATCH_RECORDS       256
+
+enum { FORMAT_AUTO, FORMAT_BIN, FORMAT_HEX };
+
+typedef struct record {
+    int algo;
+    multihash_params params;
+    uint32_t len;
+    int failed;
+    uint64_t index;
+    const uint8_t *input;
+    uint8_t claimed[MULTIHASH_OUTPUT_SIZE];
+} record;
+
+typedef struct verifier {
+    const uint8_t *data;
+    size_t size;
+    int format;
+    const char *scratchpad;
+    uint64_t scratchpad_len;
+    FILE *mismatches;
+
+    pthread_mutex_t lock;       /* guards cursor, next_index and the counters below */
+    size_t cursor;
+    uint64_t next_index;
+    uint64_t verified;
+    uint64_t mismatched;
+    uint64_t malformed;
+    uint64_t per_algo[MULTIHASH_ALGO_COUNT];
+} verifier;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t le16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static uint32_t le32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24); }
+
+static int hexval(int c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int unhex(const char *s, size_t len, uint8_t *out)
+{
+    size_t i;
+    int hi, lo;
+
+    if (len & 1)
+        return -1;
+    for (i = 0; i < len / 2; i++) {
+        if ((hi = hexval(s[2 * i])) < 0 || (lo = hexval(s[2 * i + 1])) < 0)
+            return -1;
+        out[i] = (uint8_t) (hi << 4 | lo);
+    }
+    return (int) (len / 2);
+}
+
+static void set_params(verifier *v, record *r, uint32_t param0, uint32_t param1)
+{
+    memset(&r->params, 0, sizeof(r->params));
+    switch (r->algo) {
+    case MULTIHASH_SCRYPT:
+        r->params.N = param0;
+        r->params.r = param1;
+        break;
+    case MULTIHASH_SCRYPTN:
+    case MULTIHASH_SCRYPTJANE:
+        r->params.nfactor = param0;
+        break;
+    case MULTIHASH_BOOLBERRY:
+        r->params.height = param0 | (uint64_t) param1 << 32;
+        r->params.scratchpad = v->scratchpad;
+        r->params.scratchpad_len = v->scratchpad_len;
+        break;
+    }
+}
+
+/*
+	Claims the next batch of up to BATCH_RECORDS records. Only record boundaries are
+	found here, under the lock; decoding and hashing happen in the worker.
+*/
+static int next_batch(verifier *v, size_t *start, size_t *end, uint64_t *first_index)
+{
+    size_t pos, n = 0;
+
+    pthread_mutex_lock(&v->lock);
+    pos = *start = v->cursor;
+    *first_index = v->next_index;
+
+    while (pos < v->size && n < BATCH_RECORDS) {
+        if (v->format == FORMAT_BIN) {
+            if (v->size - pos < RECORD_HEADER_SIZE) {
+                pos = v->size;
+            } else {
+                pos += RECORD_HEADER_SIZE + le16(v->data + pos + 2) + MULTIHASH_OUTPUT_SIZE;
+                if (pos > v->size)
+                    pos = v->size;
+            }
+        } else {
+            const uint8_t *nl = memchr(v->data + pos, '\n', v->size - pos);
+            pos = nl ? (size_t) (nl - v->data) + 1 : v->size;
+        }
+        n++;
+    }
+
+    *end = v->cursor = pos;
+    v->next_index += n;
+    pthread_mutex_unlock(&v->lock);
+
+    return n > 0;
+}
+
+/* Decodes one record at *pos, copying its input into arena. Returns 0 for skipped lines, -1 if malformed. */
+static int decode_record(verifier *v, size_t *pos, size_t end, record *r, uint8_t *arena)
+{
+    const uint8_t *p = v->data + *pos;
+
+    if (v->format == FORMAT_BIN) {
+        uint32_t len;
+
+        if (end - *pos < RECORD_HEADER_SIZE) {
+            *pos = end;
+            return -1;
+        }
+        len = le16(p + 2);
+        if (end - *pos < RECORD_HEADER_SIZE + len + MULTIHASH_OUTPUT_SIZE) {
+            *pos = end;
+            return -1;
+        }
+        *pos += RECORD_HEADER_SIZE + len + MULTIHASH_OUTPUT_SIZE;
+
+        r->algo = p[0];
+        r->len = len;
+        memcpy(arena, p + RECORD_HEADER_SIZE, len);
+        memcpy(r->claimed, p + RECORD_HEADER_SIZE + len, MULTIHASH_OUTPUT_SIZE);
+        if (multihash_algo_name(r->algo) == NULL)
+            return -1;
+        set_params(v, r, le32(p + 4), le32(p + 8));
+        return 1;
+    } else {
+        const char *line = (const char *) p, *eol;
+        const char *fields[3];
+        size_t lens[3];
+        char name[32];
+        unsigned long param0 = 0, param1 = 0;
+        char *colon;
+        int nfields = 0, n;
+        size_t i = 0, linelen;
+
+        eol = memchr(line, '\n', end - *pos);
+        linelen = eol ? (size_t) (eol - line) : end - *pos;
+        *pos += linelen + (eol ? 1 : 0);
+
+        while (nfields < 3) {
+            while (i < linelen && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r'))
+                i++;
+            if (i == linelen)
+                break;
+            fields[nfields] = line + i;
+            while (i < linelen && line[i] != ' ' && line[i] != '\t' && line[i] != '\r')
+                i++;
+            lens[nfields] = line + i - fields[nfields];
+            nfields++;
+        }
+        if (nfields == 0 || fields[0][0] == '#')
+            return 0;
+        if (nfields != 3 || lens[0] >= sizeof(name) || lens[2] != 2 * MULTIHASH_OUTPUT_SIZE || lens[1] > 2 * MAX_INPUT_LEN)
+            return -1;
+
+        memcpy(name, fields[0], lens[0]);
+        name[lens[0]] = 0;
+        if ((colon = strchr(name, ':')) != NULL) {
+            *colon++ = 0;
+            param0 = strtoul(colon, &colon, 10);
+            if (*colon == ':')
+                param1 = strtoul(colon + 1, NULL, 10);
+        }
+        if ((r->algo = multihash_algo_lookup(name)) < 0)
+            return -1;
+        if ((n = unhex(fields[1], lens[1], arena)) < 0 || unhex(fields[2], lens[2], r->claimed) < 0)
+            return -1;
+        r->len = (uint32_t) n;
+        set_params(v, r, (uint32_t) param0, (uint32_t) param1);
+        return 1;
+    }
+}
+
+static int same_run(const record *a, const record *b)
+{
+    return a->algo == b->algo && a->len == b->len &&
+           memcmp(&a->params, &b->params, sizeof(a->params)) == 0 &&
+           b->input == a->input + a->len;
+}
+
+static void report_mismatch(verifier *v, const record *r, const uint8_t *computed)
+{
+    char hex[2][2 * MULTIHASH_OUTPUT_SIZE + 1];
+    int i;
+
+    for (i = 0; i < MULTIHASH_OUTPUT_SIZE; i++) {
+        sprintf(hex[0] + 2 * i, "%02x", computed[i]);
+        sprintf(hex[1] + 2 * i, "%02x", r->claimed[i]);
+    }
+    fprintf(v->mismatches, "%llu %s %s %s\n", (unsigned long long) r->index,
+            multihash_algo_name(r->algo), hex[0], hex[1]);
+}
+
+static void *worker(void *arg)
+{
+    verifier *v = (verifier *) arg;
+    multihash_ctx *ctx = multihash_ctx_new();
+    record *records = (record *) malloc(BATCH_RECORDS * sizeof(record));
+    uint8_t *arena = (uint8_t *) malloc((size_t) BATCH_RECORDS * MAX_INPUT_LEN);
+    uint8_t *digests = (uint8_t *) malloc(BATCH_RECORDS * MULTIHASH_OUTPUT_SIZE);
+    uint64_t per_algo[MULTIHASH_ALGO_COUNT];
+    size_t start, end;
+    uint64_t index;
+
+    if (!ctx || !records || !arena || !digests) {
+        fprintf(stderr, "multihash-verify: out of memory\n");
+        exit(2);
+    }
+
+    while (next_batch(v, &start, &end, &index)) {
+        uint64_t verified = 0, mismatched = 0, malformed = 0;
+        size_t count = 0, used = 0, i, j;
+
+        memset(per_algo, 0, sizeof(per_algo));
+
+        while (start < end) {
+            record *r = &records[count];
+            int rc = decode_record(v, &start, end, r, arena + used);
+
+            if (rc < 0) {
+                fprintf(stderr, "multihash-verify: record %llu is malformed\n", (unsigned long long) index);
+                malformed++;
+            }
+            if (rc > 0) {
+                r->index = index;
+                r->failed = 0;
+                r->input = arena + used;
+                used += r->len;
+                count++;
+            }
+            index++;
+        }
+
+        /* consecutive records with identical algorithm, parameters and length go through one batch call */
+        for (i = 0; i < count; i = j) {
+            for (j = i + 1; j < count && same_run(&records[j - 1], &records[j]); j++)
+                ;
+            if (multihash_hash_batch(ctx, records[i].algo, &records[i].params, records[i].input,
+                                     records[i].len, records[i].len, j - i,
+                                     digests + i * MULTIHASH_OUTPUT_SIZE) != MULTIHASH_OK) {
+                malformed += j - i;
+                for (; i < j; i++) {
+                    records[i].failed = 1;
+                    fprintf(stderr, "multihash-verify: record %llu has invalid parameters\n",
+                            (unsigned long long) records[i].index);
+                }
+            }
+        }
+
+        pthread_mutex_lock(&v->lock);
+        for (i = 0; i < count; i++) {
+            const uint8_t *computed = digests + i * MULTIHASH_OUTPUT_SIZE;
+            if (records[i].failed)
+                continue;
+            per_algo[records[i].algo]++;
+            if (memcmp(computed, records[i].claimed, MULTIHASH_OUTPUT_SIZE) == 0) {
+                verified++;
+            } else {
+                mismatched++;
+                report_mismatch(v, &records[i], computed);
+            }
+        }
+        v->verified += verified;
+        v->mismatched += mismatched;
+        v->malformed += malformed;
+        for (i = 0; i < MULTIHASH_ALGO_COUNT; i++)
+            v->per_algo[i] += per_algo[i];
+        pthread_mutex_unlock(&v->lock);
+    }
+
+    free(digests);
+    free(arena);
+    free(records);
+    multihash_ctx_free(ctx);
+    return NULL;
+}
+
+static const uint8_t *map_file(const char *path, size_t *size)
+{
+    struct stat st;
+    void *p;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &st) < 0) {
+        fprintf(stderr, "multihash-verify: %s: %s\n", path, strerror(errno));
+        exit(2);
+    }
+    *size = (size_t) st.st_size;
+    if (*size == 0) {
+        close(fd);
+        return (const uint8_t *) "";
+    }
+    p = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "multihash-verify: mmap %s: %s\n", path, strerror(errno));
+        exit(2);
+    }
+    madvise(p, *size, MADV_SEQUENTIAL);
+    return (const uint8_t *) p;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: multihash-verify [-t threads] [-f bin|hex] [-o mismatches] [-s scratchpad] file\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    verifier v;
+    pthread_t *threads;
+    long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *mismatches_path = NULL;
+    double started, elapsed;
+    uint64_t total;
+    int opt, i;
+
+    memset(&v, 0, sizeof(v));
+    v.format = FORMAT_AUTO;
+
+    while ((opt = getopt(argc, argv, "t:f:o:s:h")) != -1) {
+        switch (opt) {
+        case 't':
+            nthreads = strtol(optarg, NULL, 10);
+            break;
+        case 'f':
+            if (strcmp(optarg, "bin") == 0)
+                v.format = FORMAT_BIN;
+            else if (strcmp(optarg, "hex") == 0)
+                v.format = FORMAT_HEX;
+            else
+                usage();
+            break;
+        case 'o':
+            mismatches_path = optarg;
+            break;
+        case 's': {
+            size_t len;
+            v.scratchpad = (const char *) map_file(optarg, &len);
+            v.scratchpad_len = len;
+            break;
+        }
+        default:
+            usage();
+        }
+    }
+    if (optind != argc - 1 || nthreads < 1)
+        usage();
+
+    v.data = map_file(argv[optind], &v.size);
+    if (v.format == FORMAT_AUTO)
+        v.format = (v.size > 0 && (v.data[0] == '#' || (v.data[0] >= 'a' && v.data[0] <= 'z'))) ? FORMAT_HEX : FORMAT_BIN;
+
+    v.mismatches = stdout;
+    if (mismatches_path && !(v.mismatches = fopen(mismatches_path, "w"))) {
+        fprintf(stderr, "multihash-verify: %s: %s\n", mismatches_path, strerror(errno));
+        return 2;
+    }
+    pthread_mutex_init(&v.lock, NULL);
+
+    threads = (pthread_t *) malloc(nthreads * sizeof(pthread_t));
+    started = now();
+    for (i = 0; i < nthreads; i++)
+        if (pthread_create(&threads[i], NULL, worker, &v) != 0) {
+            fprintf(stderr, "multihash-verify: could not start thread %d\n", i);
+            return 2;
+        }
+    for (i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    elapsed = now() - started;
+
+    total = v.verified + v.mismatched;
+    fprintf(stderr, "%llu records, %llu verified, %llu mismatched, %llu malformed in %.3f s (%.0f hashes/s, %.1f MB/s, %ld threads)\n",
+            (unsigned long long) (total + v.malformed), (unsigned long long) v.verified,
+            (unsigned long long) v.mismatched, (unsigned long long) v.malformed, elapsed,
+            elapsed > 0 ? total / elapsed : 0.0, elapsed > 0 ? v.size / elapsed / 1e6 : 0.0, nthreads);
+    for (i = 0; i < MULTIHASH_ALGO_COUNT; i++)
+        if (v.per_algo[i])
+            fprintf(stderr, "  %-16s %llu\n", multihash_algo_name(i), (unsigned long long) v.per_algo[i]);
+
+    if (v.mismatches != stdout)
+        fclose(v.mismatches);
+    free(threads);
+
+    return (v.mismatched || v.malformed) ? 1 : 0;
+}
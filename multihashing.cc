@@ -1,9 +1,12 @@
-#include <node.h>
-#include <node_buffer.h>
-#include <v8.h>
+#include <node_api.h>
+#include <uv.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <string>
+#include <thread>
+
 extern "C" {
     #include "bcrypt.h"
     #include "keccak.h"
@@ -24,620 +27,3458 @@ extern "C" {
     #include "sha1.h"
     #include "x15.h"
     #include "fresh.h"
-    #include "sph_sophia.h"
+    #include "multihash.h"
 }
 
 #include "boolberry.h"
 
-using namespace node;
-using namespace v8;
+/* the per-algorithm hash exports and their argument helpers; the core module has none */
+#if defined(MULTIHASHING_SPH) || defined(MULTIHASHING_SCRYPT) || defined(MULTIHASHING_CRYPTONOTE) || defined(MULTIHASHING_MISC)
+#define MULTIHASHING_HASH_EXPORTS
+#endif
+
+/*
+ * Everything the module keeps between calls lives here, one instance per
+ * napi_env. The main thread and every worker_thread that loads the addon
+ * get their own copy, so no handle or scratchpad is shared across isolates.
+ */
+struct multihashing_instance {
+    multihash_ctx* ctx;
+    napi_ref chain_constructor;
+    napi_ref filter_constructor;
+    napi_ref ring_constructor;
+    napi_ref job_constructor;
+    multihash_scheduler* scheduler;     /* for hashTasks and submitBatch, started on first use */
+    multihash_scheduler** scheduler_slot;   /* &scheduler, or the core module's after useScheduler */
+};
+
+static void instance_finalize(napi_env env, void* data, void* hint) {
+    multihashing_instance* instance = (multihashing_instance*) data;
+
+    if (instance->chain_constructor)
+        napi_delete_reference(env, instance->chain_constructor);
+    if (instance->filter_constructor)
+        napi_delete_reference(env, instance->filter_constructor);
+    if (instance->ring_constructor)
+        napi_delete_reference(env, instance->ring_constructor);
+    if (instance->job_constructor)
+        napi_delete_reference(env, instance->job_constructor);
+    multihash_scheduler_free(instance->scheduler);
+    multihash_ctx_free(instance->ctx);
+    free(instance);
+}
 
-Handle<Value> except(const char* msg) {
-    return ThrowException(Exception::Error(String::New(msg)));
+static multihashing_instance* get_instance(napi_env env) {
+    void* data = NULL;
+    napi_get_instance_data(env, &data);
+    return (multihashing_instance*) data;
 }
 
-Handle<Value> quark(const Arguments& args) {
-    HandleScope scope;
+napi_value except(napi_env env, const char* msg) {
+    napi_throw_error(env, NULL, msg);
+    return NULL;
+}
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+/* the scheduler hashTasks and submitBatch queue on, one thread per cpu; NULL when it cannot start */
+static multihash_scheduler* get_scheduler(napi_env env) {
+    multihash_scheduler** slot = get_instance(env)->scheduler_slot;
 
-    Local<Object> target = args[0]->ToObject();
+    if (!*slot) {
+        unsigned threads = std::thread::hardware_concurrency();
+        *slot = multihash_scheduler_new(threads ? threads : 1);
+    }
+    return *slot;
+}
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+/*
+ * napi_unwrap for one kind of object. Every wrapped class tags its instances,
+ * so another wrapped object (or a plain one) gives NULL rather than a pointer
+ * of the wrong type. The tags are the same in every module build, so objects
+ * still pass between the family modules.
+ */
+static void* unwrap_tagged(napi_env env, napi_value value, const napi_type_tag* tag) {
+    napi_valuetype type;
+    bool tagged = false;
+    void* data = NULL;
+
+    if (napi_typeof(env, value, &type) != napi_ok || type != napi_object ||
+        napi_check_object_type_tag(env, value, tag, &tagged) != napi_ok || !tagged ||
+        napi_unwrap(env, value, &data) != napi_ok)
+        return NULL;
+    return data;
+}
 
-    char * input = Buffer::Data(target);
-    char output[32];
+/*
+ * The process-wide pieces the core module hands to the others are externals,
+ * tagged the same way so a module takes only the kind of pointer it asked for.
+ */
+static napi_value new_tagged_external(napi_env env, void* data, const napi_type_tag* tag) {
+    napi_value external;
+
+    if (napi_create_external(env, data, NULL, NULL, &external) != napi_ok ||
+        napi_type_tag_object(env, external, tag) != napi_ok)
+        return NULL;
+    return external;
+}
+
+static void* get_tagged_external(napi_env env, napi_value value, const napi_type_tag* tag) {
+    napi_valuetype type;
+    bool tagged = false;
+    void* data = NULL;
+
+    if (napi_typeof(env, value, &type) != napi_ok || type != napi_external ||
+        napi_check_object_type_tag(env, value, tag, &tagged) != napi_ok || !tagged ||
+        napi_get_value_external(env, value, &data) != napi_ok)
+        return NULL;
+    return data;
+}
+
+static size_t element_size(napi_typedarray_type type) {
+    switch (type) {
+    case napi_int16_array:
+    case napi_uint16_array:
+        return 2;
+    case napi_int32_array:
+    case napi_uint32_array:
+    case napi_float32_array:
+        return 4;
+    case napi_float64_array:
+    case napi_bigint64_array:
+    case napi_biguint64_array:
+        return 8;
+    default:
+        return 1;
+    }
+}
+
+/* any ArrayBufferView: a Buffer, another typed array or a DataView, as the bytes it covers */
+static bool get_buffer(napi_env env, napi_value value, char** data, size_t* length) {
+    bool is_view = false;
+    napi_typedarray_type type;
+
+    if (napi_is_typedarray(env, value, &is_view) == napi_ok && is_view) {
+        if (napi_get_typedarray_info(env, value, &type, length, (void**) data, NULL, NULL) != napi_ok)
+            return false;
+        *length *= element_size(type);
+        return true;
+    }
+
+    if (napi_is_dataview(env, value, &is_view) == napi_ok && is_view)
+        return napi_get_dataview_info(env, value, length, (void**) data, NULL, NULL) == napi_ok;
+
+    return false;
+}
+
+#ifdef MULTIHASHING_HASH_EXPORTS
+static bool is_view(napi_env env, napi_value value) {
+    bool is_typedarray = false, is_dataview = false;
+
+    napi_is_typedarray(env, value, &is_typedarray);
+    if (!is_typedarray)
+        napi_is_dataview(env, value, &is_dataview);
+    return is_typedarray || is_dataview;
+}
+#endif
+
+static bool get_number(napi_env env, napi_value value, double* result) {
+    napi_value number;
+
+    if (napi_coerce_to_number(env, value, &number) != napi_ok)
+        return false;
+
+    return napi_get_value_double(env, number, result) == napi_ok;
+}
+
+static napi_value new_buffer(napi_env env, const char* data, size_t length) {
+    napi_value buff;
+    napi_create_buffer_copy(env, length, data, NULL, &buff);
+    return buff;
+}
+
+static bool get_diff1(napi_env env, napi_value value, double* diff1) {
+    char * data;
+    size_t length;
+
+    if (get_buffer(env, value, &data, &length)) {
+        if (length != 32)
+            return false;
+        *diff1 = multihash_le256_to_double(data);
+        return true;
+    }
 
-    uint32_t input_len = Buffer::Length(target);
+    napi_valuetype type;
+    napi_typeof(env, value, &type);
+    return type == napi_number && napi_get_value_double(env, value, diff1) == napi_ok;
+}
+
+#ifdef MULTIHASHING_HASH_EXPORTS
+/*
+ * Every hash export accepts an optional trailing options object,
+ * { diff1: Number or 32 byte little endian Buffer, hash: Boolean }. It is
+ * removed from args here so the exports see their usual argument list.
+ */
+static void get_hash_args(napi_env env, napi_callback_info info, size_t* argc, napi_value* args, napi_value* self, napi_value* options) {
+    size_t capacity = *argc;
+    napi_valuetype type;
+    bool is_array = false;
+
+    napi_get_cb_info(env, info, argc, args, self, NULL);
+    *options = NULL;
+
+    if (*argc < 2 || *argc > capacity)
+        return;
+
+    napi_typeof(env, args[*argc - 1], &type);
+    if (type != napi_object)
+        return;
+    napi_is_array(env, args[*argc - 1], &is_array);
+    if (is_array || is_view(env, args[*argc - 1]))
+        return;
+
+    *options = args[--*argc];
+}
+
+/*
+ * The input of a hash export: args[0] as a whole, or (buffer, offset, length)
+ * to hash a sub-range of a larger read without slicing it. required is the
+ * export's argument count without the range; two numbers right after the
+ * buffer and that many more arguments make a range, which is then removed
+ * from args so the export sees its usual argument list.
+ */
+static bool get_input(napi_env env, napi_value* args, size_t* argc, size_t required, char** data, size_t* length) {
+    napi_valuetype offset_type, length_type;
+    double offset, range;
+
+    if (!get_buffer(env, args[0], data, length))
+        return false;
+
+    if (*argc < required + 2 ||
+        napi_typeof(env, args[1], &offset_type) != napi_ok || offset_type != napi_number ||
+        napi_typeof(env, args[2], &length_type) != napi_ok || length_type != napi_number)
+        return true;
+
+    napi_get_value_double(env, args[1], &offset);
+    napi_get_value_double(env, args[2], &range);
+    if (!(offset >= 0 && range >= 0 && offset + range <= *length) ||
+        offset != (size_t) offset || range != (size_t) range)
+        return false;
+
+    *data += (size_t) offset;
+    *length = (size_t) range;
+    memmove(args + 1, args + 3, (*argc - 3) * sizeof(napi_value));
+    *argc -= 2;
+    return true;
+}
+#endif
+
+static bool get_uint_property(napi_env env, napi_value object, const char* name, double* result) {
+    bool has = false;
+    napi_value value;
+
+    if (napi_has_named_property(env, object, name, &has) != napi_ok || !has)
+        return true;
+
+    napi_get_named_property(env, object, name, &value);
+    return get_number(env, value, result) && *result >= 0;
+}
+
+/*
+ * The records of a batch within buffer: options.offset and options.length (bytes)
+ * narrow it down, one record starts every options.stride bytes (recordLength by
+ * default, more to skip framing between records) and options.count caps how many
+ * are hashed. Without count, the range must end with a whole record.
+ */
+static bool get_records(napi_env env, napi_value options, char** data, size_t* length,
+                        size_t record_len, size_t* stride, size_t* count) {
+    double offset = 0, range = -1, step = record_len, limit = -1;
+
+    if (options && (!get_uint_property(env, options, "offset", &offset) || !get_uint_property(env, options, "length", &range) ||
+                    !get_uint_property(env, options, "stride", &step) || !get_uint_property(env, options, "count", &limit)))
+        return false;
+
+    if (range < 0)
+        range = offset <= *length ? *length - offset : 0;
+    if (record_len == 0 || step < record_len || offset + range > *length ||
+        offset != (size_t) offset || range != (size_t) range || step != (size_t) step)
+        return false;
+
+    *data += (size_t) offset;
+    *length = (size_t) range;
+    *stride = (size_t) step;
+
+    if (limit >= 0) {
+        *count = (size_t) limit;
+        return limit == *count && (*count == 0 || (*count - 1) * *stride + record_len <= *length);
+    }
+    if (*length == 0) {
+        *count = 0;
+        return true;
+    }
+    *count = (*length - record_len) / *stride + 1;
+    return *length >= record_len && (*length - record_len) % *stride == 0;
+}
+
+static const char* scratchpad_error(int rc) {
+    if (rc == MULTIHASH_ENOMEM)
+        return "Scratchpad does not fit in the memory budget or could not be allocated.";
+    return "Invalid algorithm parameters.";
+}
+
+#ifdef MULTIHASHING_HASH_EXPORTS
+/*
+ * With { diff1 } the share difficulty is computed natively next to the hash:
+ * the result is { hash, difficulty }, or just the difficulty with hash: false.
+ */
+static napi_value hash_result(napi_env env, const char* output, napi_value options) {
+    bool has_diff1 = false;
 
-    quark_hash(input, output, input_len);
+    if (options)
+        napi_has_named_property(env, options, "diff1", &has_diff1);
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    if (!has_diff1)
+        return new_buffer(env, output, 32);
+
+    napi_value value, difficulty;
+    double diff1;
+
+    napi_get_named_property(env, options, "diff1", &value);
+    if (!get_diff1(env, value, &diff1))
+        return except(env, "diff1 should be a number or a 32 byte buffer.");
+
+    napi_create_double(env, multihash_hash_to_difficulty(output, diff1), &difficulty);
+
+    bool has_hash = false, want_hash = true;
+
+    napi_has_named_property(env, options, "hash", &has_hash);
+    if (has_hash) {
+        napi_get_named_property(env, options, "hash", &value);
+        napi_coerce_to_bool(env, value, &value);
+        napi_get_value_bool(env, value, &want_hash);
+    }
+
+    if (!want_hash)
+        return difficulty;
+
+    napi_value result;
+    napi_create_object(env, &result);
+    napi_set_named_property(env, result, "hash", new_buffer(env, output, 32));
+    napi_set_named_property(env, result, "difficulty", difficulty);
+    return result;
 }
+#endif
 
-Handle<Value> x11(const Arguments& args) {
-    HandleScope scope;
+#ifdef MULTIHASHING_SPH
+napi_value quark(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
 
-    Local<Object> target = args[0]->ToObject();
+    char * input;
+    size_t input_len;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    char * input = Buffer::Data(target);
     char output[32];
 
-    uint32_t input_len = Buffer::Length(target);
+    multihash_hash(NULL, MULTIHASH_QUARK, NULL, input, input_len, output);
+
+    return hash_result(env, output, options);
+}
+
+napi_value x11(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
+
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
+
+    char * input;
+    size_t input_len;
+
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
+
+    char output[32];
 
-    x11_hash(input, output, input_len);
+    multihash_hash(NULL, MULTIHASH_X11, NULL, input, input_len, output);
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    return hash_result(env, output, options);
 }
+#endif
 
-Handle<Value> scrypt(const Arguments& args) {
-   HandleScope scope;
+#ifdef MULTIHASHING_SCRYPT
+napi_value scrypt(napi_env env, napi_callback_info info) {
+   size_t argc = 6;
+   napi_value args[6];
+   napi_value options;
+   get_hash_args(env, info, &argc, args, NULL, &options);
 
-   if (args.Length() < 3)
-       return except("You must provide buffer to hash, N value, and R value");
+   if (argc < 3)
+       return except(env, "You must provide buffer to hash, N value, and R value");
 
-   Local<Object> target = args[0]->ToObject();
+   char * input;
+   size_t input_len;
 
-   if(!Buffer::HasInstance(target))
-       return except("Argument should be a buffer object.");
+   if(!get_input(env, args, &argc, 3, &input, &input_len))
+       return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-   Local<Number> numn = args[1]->ToNumber();
-   unsigned int nValue = numn->Value();
-   Local<Number> numr = args[2]->ToNumber();
-   unsigned int rValue = numr->Value();
+   double numn, numr;
+
+   if(!get_number(env, args[1], &numn) || !get_number(env, args[2], &numr))
+       return NULL;
+
+   multihash_params params = {};
+   params.N = numn;
+   params.r = numr;
 
-   char * input = Buffer::Data(target);
    char output[32];
 
-   uint32_t input_len = Buffer::Length(target);
+   int rc = multihash_hash(get_instance(env)->ctx, MULTIHASH_SCRYPT, &params, input, input_len, output);
 
-   scrypt_N_R_1_256(input, output, nValue, rValue, input_len);
+   if (rc != MULTIHASH_OK)
+       return except(env, scratchpad_error(rc));
 
-   Buffer* buff = Buffer::New(output, 32);
-   return scope.Close(buff->handle_);
+   return hash_result(env, output, options);
 }
 
 
 
-Handle<Value> scryptn(const Arguments& args) {
-   HandleScope scope;
+napi_value scryptn(napi_env env, napi_callback_info info) {
+   size_t argc = 5;
+   napi_value args[5];
+   napi_value options;
+   get_hash_args(env, info, &argc, args, NULL, &options);
 
-   if (args.Length() < 2)
-       return except("You must provide buffer to hash and N factor.");
+   if (argc < 2)
+       return except(env, "You must provide buffer to hash and N factor.");
 
-   Local<Object> target = args[0]->ToObject();
+   char * input;
+   size_t input_len;
 
-   if(!Buffer::HasInstance(target))
-       return except("Argument should be a buffer object.");
+   if(!get_input(env, args, &argc, 2, &input, &input_len))
+       return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-   Local<Number> num = args[1]->ToNumber();
-   unsigned int nFactor = num->Value();
+   double num;
 
-   char * input = Buffer::Data(target);
-   char output[32];
+   if(!get_number(env, args[1], &num))
+       return NULL;
 
-   uint32_t input_len = Buffer::Length(target);
+   multihash_params params = {};
+   params.nfactor = num;
 
-   //unsigned int N = 1 << (getNfactor(input) + 1);
-   unsigned int N = 1 << nFactor;
+   char output[32];
 
-   scrypt_N_R_1_256(input, output, N, 1, input_len); //hardcode for now to R=1 for now
+   //unsigned int N = 1 << (getNfactor(input) + 1);
+   int rc = multihash_hash(get_instance(env)->ctx, MULTIHASH_SCRYPTN, &params, input, input_len, output); //hardcode for now to R=1 for now
 
+   if (rc != MULTIHASH_OK)
+       return except(env, scratchpad_error(rc));
 
-   Buffer* buff = Buffer::New(output, 32);
-   return scope.Close(buff->handle_);
+   return hash_result(env, output, options);
 }
 
-Handle<Value> scryptjane(const Arguments& args) {
-    HandleScope scope;
+napi_value scryptjane(napi_env env, napi_callback_info info) {
+    size_t argc = 8;
+    napi_value args[8];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
 
-    if (args.Length() < 5)
-        return except("You must provide two argument: buffer, timestamp as number, and nChainStarTime as number, nMin, and nMax");
+    if (argc < 5)
+        return except(env, "You must provide two argument: buffer, timestamp as number, and nChainStarTime as number, nMin, and nMax");
 
-    Local<Object> target = args[0]->ToObject();
+    char * input;
+    size_t input_len;
 
-    if(!Buffer::HasInstance(target))
-        return except("First should be a buffer object.");
+    if(!get_input(env, args, &argc, 5, &input, &input_len))
+        return except(env, "First should be a buffer, or a buffer, offset and length.");
 
-    Local<Number> num = args[1]->ToNumber();
-    int timestamp = num->Value();
+    double num, num2, num3, num4;
 
-    Local<Number> num2 = args[2]->ToNumber();
-    int nChainStartTime = num2->Value();
+    if(!get_number(env, args[1], &num) || !get_number(env, args[2], &num2) ||
+       !get_number(env, args[3], &num3) || !get_number(env, args[4], &num4))
+        return NULL;
 
-    Local<Number> num3 = args[3]->ToNumber();
-    int nMin = num3->Value();
+    int timestamp = num;
+    int nChainStartTime = num2;
+    int nMin = num3;
+    int nMax = num4;
 
-    Local<Number> num4 = args[4]->ToNumber();
-    int nMax = num4->Value();
+    multihash_params params = {};
+    params.nfactor = GetNfactorJane(timestamp, nChainStartTime, nMin, nMax);
 
-    char * input = Buffer::Data(target);
     char output[32];
 
-    uint32_t input_len = Buffer::Length(target);
+    int rc = multihash_hash(get_instance(env)->ctx, MULTIHASH_SCRYPTJANE, &params, input, input_len, output);
 
-    scryptjane_hash(input, input_len, (uint32_t *)output, GetNfactorJane(timestamp, nChainStartTime, nMin, nMax));
+    if (rc != MULTIHASH_OK)
+        return except(env, scratchpad_error(rc));
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    return hash_result(env, output, options);
 }
+#endif
 
-Handle<Value> keccak(const Arguments& args) {
-    HandleScope scope;
+#ifdef MULTIHASHING_SPH
+napi_value keccak(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
 
-    Local<Object> target = args[0]->ToObject();
+    char * input;
+    size_t dSize;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if(!get_input(env, args, &argc, 1, &input, &dSize))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    char * input = Buffer::Data(target);
     char output[32];
 
-    unsigned int dSize = Buffer::Length(target);
+    multihash_hash(NULL, MULTIHASH_KECCAK, NULL, input, dSize, output);
 
-    keccak_hash(input, output, dSize);
-
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    return hash_result(env, output, options);
 }
+#endif
 
 
-Handle<Value> bcrypt(const Arguments& args) {
-    HandleScope scope;
+#ifdef MULTIHASHING_MISC
+napi_value bcrypt(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
 
-    Local<Object> target = args[0]->ToObject();
+    char * input;
+    size_t input_len;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    char * input = Buffer::Data(target);
     char output[32];
 
-    bcrypt_hash(input, output);
+    multihash_hash(NULL, MULTIHASH_BCRYPT, NULL, input, input_len, output);
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    return hash_result(env, output, options);
 }
+#endif
 
-Handle<Value> skein(const Arguments& args) {
-    HandleScope scope;
+#ifdef MULTIHASHING_SPH
+napi_value skein(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
 
-    Local<Object> target = args[0]->ToObject();
+    char * input;
+    size_t input_len;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    char * input = Buffer::Data(target);
     char output[32];
 
-    uint32_t input_len = Buffer::Length(target);
+    multihash_hash(NULL, MULTIHASH_SKEIN, NULL, input, input_len, output);
+
+    return hash_result(env, output, options);
+}
+
+
+napi_value groestl(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
+
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
+
+    char * input;
+    size_t input_len;
+
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
+
+    char output[32];
 
-    skein_hash(input, output, input_len);
+    multihash_hash(NULL, MULTIHASH_GROESTL, NULL, input, input_len, output);
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    return hash_result(env, output, options);
 }
 
 
-Handle<Value> groestl(const Arguments& args) {
-    HandleScope scope;
+napi_value groestlmyriad(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
 
-    Local<Object> target = args[0]->ToObject();
+    char * input;
+    size_t input_len;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    char * input = Buffer::Data(target);
     char output[32];
 
-    uint32_t input_len = Buffer::Length(target);
+    multihash_hash(NULL, MULTIHASH_GROESTLMYRIAD, NULL, input, input_len, output);
 
-    groestl_hash(input, output, input_len);
+    return hash_result(env, output, options);
+}
+
+
+napi_value blake(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
+
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
+
+    char * input;
+    size_t input_len;
+
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
+
+    char output[32];
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    multihash_hash(NULL, MULTIHASH_BLAKE, NULL, input, input_len, output);
+
+    return hash_result(env, output, options);
 }
 
 
-Handle<Value> groestlmyriad(const Arguments& args) {
-    HandleScope scope;
+napi_value fugue(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
 
-    Local<Object> target = args[0]->ToObject();
+    char * input;
+    size_t input_len;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    char * input = Buffer::Data(target);
     char output[32];
 
-    uint32_t input_len = Buffer::Length(target);
+    multihash_hash(NULL, MULTIHASH_FUGUE, NULL, input, input_len, output);
+
+    return hash_result(env, output, options);
+}
+
+
+napi_value qubit(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
+
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
+
+    char * input;
+    size_t input_len;
+
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    groestlmyriad_hash(input, output, input_len);
+    char output[32];
+
+    multihash_hash(NULL, MULTIHASH_QUBIT, NULL, input, input_len, output);
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    return hash_result(env, output, options);
 }
 
 
-Handle<Value> blake(const Arguments& args) {
-    HandleScope scope;
+napi_value hefty1(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
 
-    Local<Object> target = args[0]->ToObject();
+    char * input;
+    size_t input_len;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    char * input = Buffer::Data(target);
     char output[32];
 
-    uint32_t input_len = Buffer::Length(target);
+    multihash_hash(NULL, MULTIHASH_HEFTY1, NULL, input, input_len, output);
+
+    return hash_result(env, output, options);
+}
+
+
+napi_value shavite3(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
+
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
+
+    char * input;
+    size_t input_len;
 
-    blake_hash(input, output, input_len);
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    char output[32];
+
+    multihash_hash(NULL, MULTIHASH_SHAVITE3, NULL, input, input_len, output);
+
+    return hash_result(env, output, options);
 }
+#endif
+
+#ifdef MULTIHASHING_CRYPTONOTE
+napi_value cryptonight(napi_env env, napi_callback_info info) {
+    size_t argc = 5;
+    napi_value args[5];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
+
+    bool fast = false;
+
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
+
+    char * input;
+    size_t input_len;
 
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-Handle<Value> fugue(const Arguments& args) {
-    HandleScope scope;
+    if (argc >= 2) {
+        napi_valuetype type;
+        napi_typeof(env, args[1], &type);
+        if(type != napi_boolean)
+            return except(env, "Argument 2 should be a boolean");
+        napi_get_value_bool(env, args[1], &fast);
+    }
+
+    char output[32];
+
+    if(fast)
+        multihash_hash(NULL, MULTIHASH_CRYPTONIGHT_FAST, NULL, input, input_len, output);
+    else if(multihash_hash(get_instance(env)->ctx, MULTIHASH_CRYPTONIGHT, NULL, input, input_len, output) != MULTIHASH_OK)
+        return except(env, scratchpad_error(MULTIHASH_ENOMEM));
+
+    return hash_result(env, output, options);
+}
+#endif
+
+#ifdef MULTIHASHING_SPH
+napi_value x13(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
 
-    Local<Object> target = args[0]->ToObject();
+    char * input;
+    size_t input_len;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    char * input = Buffer::Data(target);
     char output[32];
 
-    uint32_t input_len = Buffer::Length(target);
+    multihash_hash(NULL, MULTIHASH_X13, NULL, input, input_len, output);
+
+    return hash_result(env, output, options);
+}
+#endif
+
+#ifdef MULTIHASHING_CRYPTONOTE
+napi_value boolberry(napi_env env, napi_callback_info info) {
+    size_t argc = 6;
+    napi_value args[6];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
+
+    if (argc < 2)
+        return except(env, "You must provide two arguments.");
+
+    char * input;
+    char * scratchpad;
+    size_t input_len;
+    size_t spad_len;
+    uint32_t height = 1;
+
+    if(!get_input(env, args, &argc, 2, &input, &input_len))
+        return except(env, "Argument 1 should be a buffer, or a buffer, offset and length.");
+
+    if(!get_buffer(env, args[1], &scratchpad, &spad_len))
+        return except(env, "Argument 2 should be a buffer object.");
+
+    if(argc >= 3) {
+        double num;
+        napi_valuetype type;
+        napi_typeof(env, args[2], &type);
+        if(type != napi_number || napi_get_value_double(env, args[2], &num) != napi_ok ||
+           num < 0 || num > UINT32_MAX || num != (uint32_t) num)
+            return except(env, "Argument 3 should be an unsigned integer.");
+        height = num;
+    }
+
+    multihash_params params;
+    memset(&params, 0, sizeof(params));
+    params.scratchpad = scratchpad;
+    params.scratchpad_len = spad_len;
+    params.height = height;
 
-    fugue_hash(input, output, input_len);
+    char output[32];
+
+    if(multihash_hash(NULL, MULTIHASH_BOOLBERRY, &params, input, input_len, output) != MULTIHASH_OK)
+        return except(env, "Argument 2 should be a scratchpad of at least 32 bytes.");
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    return hash_result(env, output, options);
 }
+#endif
+
+#ifdef MULTIHASHING_SPH
+napi_value nist5(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
+
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
+
+    char * input;
+    size_t input_len;
+
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
+
+    char output[32];
 
+    multihash_hash(NULL, MULTIHASH_NIST5, NULL, input, input_len, output);
 
-Handle<Value> qubit(const Arguments& args) {
-    HandleScope scope;
+    return hash_result(env, output, options);
+}
+#endif
+
+#ifdef MULTIHASHING_MISC
+napi_value sha1(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
 
-    Local<Object> target = args[0]->ToObject();
+    char * input;
+    size_t input_len;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    char * input = Buffer::Data(target);
     char output[32];
 
-    uint32_t input_len = Buffer::Length(target);
+    multihash_hash(NULL, MULTIHASH_SHA1, NULL, input, input_len, output);
+
+    return hash_result(env, output, options);
+}
+#endif
+
+#ifdef MULTIHASHING_SPH
+napi_value x15(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
+
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
+
+    char * input;
+    size_t input_len;
+
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    qubit_hash(input, output, input_len);
+    char output[32];
+
+    multihash_hash(NULL, MULTIHASH_X15, NULL, input, input_len, output);
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    return hash_result(env, output, options);
 }
 
+napi_value fresh(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
+
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
+
+    char * input;
+    size_t input_len;
+
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
+
+    char output[32];
+
+    multihash_hash(NULL, MULTIHASH_FRESH, NULL, input, input_len, output);
 
-Handle<Value> hefty1(const Arguments& args) {
-    HandleScope scope;
+    return hash_result(env, output, options);
+}
+
+napi_value sophia(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value options;
+    get_hash_args(env, info, &argc, args, NULL, &options);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
 
-    Local<Object> target = args[0]->ToObject();
+    char * input;
+    size_t input_len;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    char * input = Buffer::Data(target);
     char output[32];
 
-    uint32_t input_len = Buffer::Length(target);
+    multihash_hash(NULL, MULTIHASH_SOPHIA, NULL, input, input_len, output);
+
+    return hash_result(env, output, options);
+}
+#endif
+
+/* hashToDifficulty(hash, diff1) */
+napi_value hashToDifficulty(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    if (argc < 2)
+        return except(env, "You must provide a hash and diff1.");
+
+    char * hash;
+    size_t hash_len;
+    double diff1;
+
+    if(!get_buffer(env, args[0], &hash, &hash_len) || hash_len != 32)
+        return except(env, "Argument 1 should be a 32 byte buffer.");
 
-    hefty1_hash(input, output, input_len);
+    if(!get_diff1(env, args[1], &diff1))
+        return except(env, "diff1 should be a number or a 32 byte buffer.");
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    napi_value difficulty;
+    napi_create_double(env, multihash_hash_to_difficulty(hash, diff1), &difficulty);
+    return difficulty;
 }
 
+/* hashToDifficultyBatch(hashes, diff1): hashes is n concatenated digests, returns a Float64Array of n */
+napi_value hashToDifficultyBatch(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
 
-Handle<Value> shavite3(const Arguments& args) {
-    HandleScope scope;
+    if (argc < 2)
+        return except(env, "You must provide hashes and diff1.");
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    char * hashes;
+    size_t hashes_len;
+    double diff1;
 
-    Local<Object> target = args[0]->ToObject();
+    if(!get_buffer(env, args[0], &hashes, &hashes_len) || hashes_len % 32 != 0)
+        return except(env, "Argument 1 should be a buffer of 32 byte hashes.");
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if(!get_diff1(env, args[1], &diff1))
+        return except(env, "diff1 should be a number or a 32 byte buffer.");
 
-    char * input = Buffer::Data(target);
-    char output[32];
+    size_t count = hashes_len / 32;
+    void* data;
+    napi_value arraybuffer, result;
+
+    if (napi_create_arraybuffer(env, count * sizeof(double), &data, &arraybuffer) != napi_ok ||
+        napi_create_typedarray(env, napi_float64_array, count, arraybuffer, 0, &result) != napi_ok)
+        return NULL;
+
+    multihash_hash_to_difficulty_batch(hashes, count, diff1, (double*) data);
+    return result;
+}
 
-    uint32_t input_len = Buffer::Length(target);
+/* meetsTarget(hash, target): both 32 byte little endian, true when hash <= target */
+napi_value meetsTarget(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
 
-    shavite3_hash(input, output, input_len);
+    if (argc < 2)
+        return except(env, "You must provide a hash and a target.");
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    char * hash;
+    char * target;
+    size_t hash_len, target_len;
+
+    if(!get_buffer(env, args[0], &hash, &hash_len) || hash_len != 32)
+        return except(env, "Argument 1 should be a 32 byte buffer.");
+
+    if(!get_buffer(env, args[1], &target, &target_len) || target_len != 32)
+        return except(env, "Argument 2 should be a 32 byte buffer.");
+
+    napi_value result;
+    napi_get_boolean(env, multihash_meets_target(hash, target), &result);
+    return result;
 }
 
-Handle<Value> cryptonight(const Arguments& args) {
-    HandleScope scope;
+/* meetsTargetBatch(hashes, target): returns a Uint8Array with 1 for every hash <= target */
+napi_value meetsTargetBatch(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
 
-    bool fast = false;
+    if (argc < 2)
+        return except(env, "You must provide hashes and a target.");
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    char * hashes;
+    char * target;
+    size_t hashes_len, target_len;
 
-    if (args.Length() >= 2) {
-        if(!args[1]->IsBoolean())
-            return except("Argument 2 should be a boolean");
-        fast = args[1]->ToBoolean()->BooleanValue();
-    }
+    if(!get_buffer(env, args[0], &hashes, &hashes_len) || hashes_len % 32 != 0)
+        return except(env, "Argument 1 should be a buffer of 32 byte hashes.");
 
-    Local<Object> target = args[0]->ToObject();
+    if(!get_buffer(env, args[1], &target, &target_len) || target_len != 32)
+        return except(env, "Argument 2 should be a 32 byte buffer.");
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    size_t count = hashes_len / 32;
+    void* data;
+    napi_value arraybuffer, result;
 
-    char * input = Buffer::Data(target);
-    char output[32];
+    if (napi_create_arraybuffer(env, count, &data, &arraybuffer) != napi_ok ||
+        napi_create_typedarray(env, napi_uint8_array, count, arraybuffer, 0, &result) != napi_ok)
+        return NULL;
 
-    uint32_t input_len = Buffer::Length(target);
+    multihash_meets_target_batch(hashes, count, target, (uint8_t*) data);
+    return result;
+}
 
-    if(fast)
-        cryptonight_fast_hash(input, output, input_len);
-    else
-        cryptonight_hash(input, output, input_len);
+#ifdef MULTIHASHING_SPH
+static const napi_type_tag chain_type_tag = { 0x6d68736863686e31ULL, 0x94c2e05a7d1b3f68ULL };
+
+static void chain_finalize(napi_env env, void* data, void* hint) {
+    multihash_chain_free((multihash_chain*) data);
+}
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+static multihash_chain* unwrap_chain(napi_env env, napi_value self) {
+    return (multihash_chain*) unwrap_tagged(env, self, &chain_type_tag);
 }
 
-Handle<Value> x13(const Arguments& args) {
-    HandleScope scope;
+/* new HashChain(names), only reachable through chain() */
+static napi_value chain_constructor(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_value self;
+    napi_get_cb_info(env, info, &argc, args, &self, NULL);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    bool is_array = false;
+    uint32_t count = 0;
 
-    Local<Object> target = args[0]->ToObject();
+    if (argc < 1 || napi_is_array(env, args[0], &is_array) != napi_ok || !is_array)
+        return except(env, "You must provide an array of primitive names.");
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    napi_get_array_length(env, args[0], &count);
 
-    char * input = Buffer::Data(target);
-    char output[32];
+    if (count == 0 || count > MULTIHASH_CHAIN_MAX_STAGES)
+        return except(env, "A chain needs between 1 and 64 primitives.");
 
-    uint32_t input_len = Buffer::Length(target);
+    int stages[MULTIHASH_CHAIN_MAX_STAGES];
 
-    x13_hash(input, output, input_len);
+    for (uint32_t i = 0; i < count; i++) {
+        napi_value element;
+        char name[32];
+        size_t name_len;
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+        napi_get_element(env, args[0], i, &element);
+        if (napi_get_value_string_utf8(env, element, name, sizeof(name), &name_len) != napi_ok)
+            return except(env, "Primitive names should be strings.");
+        if ((stages[i] = multihash_chain_primitive_lookup(name)) < 0) {
+            napi_throw_error(env, NULL, (std::string("Unknown chain primitive: ") + name).c_str());
+            return NULL;
+        }
+    }
+
+    multihash_chain* chain = multihash_chain_new(stages, count);
+
+    if (!chain)
+        return except(env, "Could not allocate chain.");
+
+    if (napi_type_tag_object(env, self, &chain_type_tag) != napi_ok ||
+        napi_wrap(env, self, chain, chain_finalize, NULL, NULL) != napi_ok) {
+        multihash_chain_free(chain);
+        return except(env, "Could not allocate chain.");
+    }
+
+    return self;
 }
 
-Handle<Value> boolberry(const Arguments& args) {
-    HandleScope scope;
+/* chain.hash(buffer) */
+static napi_value chain_hash(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value self, options;
+    get_hash_args(env, info, &argc, args, &self, &options);
 
-    if (args.Length() < 2)
-        return except("You must provide two arguments.");
+    multihash_chain* chain = unwrap_chain(env, self);
 
-    Local<Object> target = args[0]->ToObject();
-    Local<Object> target_spad = args[1]->ToObject();
-    uint32_t height = 1;
+    if (!chain)
+        return except(env, "hash must be called on a chain.");
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument 1 should be a buffer object.");
+    if (argc < 1)
+        return except(env, "You must provide one argument.");
 
-    if(!Buffer::HasInstance(target_spad))
-        return except("Argument 2 should be a buffer object.");
+    char * input;
+    size_t input_len;
 
-    if(args.Length() >= 3)
-        if(args[2]->IsUint32())
-            height = args[2]->ToUint32()->Uint32Value();
-        else
-            return except("Argument 3 should be an unsigned integer.");
+    if(!get_input(env, args, &argc, 1, &input, &input_len))
+        return except(env, "Argument should be a buffer, or a buffer, offset and length.");
 
-    char * input = Buffer::Data(target);
-    char * scratchpad = Buffer::Data(target_spad);
     char output[32];
 
-    uint32_t input_len = Buffer::Length(target);
-    uint64_t spad_len = Buffer::Length(target_spad);
+    multihash_chain_hash(chain, input, input_len, output);
+
+    return hash_result(env, output, options);
+}
+
+/*
+ * chain.hashBatch(buffer, recordLength[, options]): hashes every recordLength bytes, returns
+ * the digests concatenated. options { offset, length, stride, count } as for hashBatch.
+ */
+static napi_value chain_hash_batch(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3];
+    napi_value self;
+    napi_get_cb_info(env, info, &argc, args, &self, NULL);
+
+    multihash_chain* chain = unwrap_chain(env, self);
+
+    if (!chain)
+        return except(env, "hashBatch must be called on a chain.");
+
+    if (argc < 2)
+        return except(env, "You must provide a buffer and a record length.");
+
+    char * input;
+    size_t input_len;
+    double num;
+
+    if(!get_buffer(env, args[0], &input, &input_len))
+        return except(env, "Argument 1 should be a buffer object.");
 
-    boolberry_hash(input, input_len, scratchpad, spad_len, output, height);
+    if(!get_number(env, args[1], &num))
+        return NULL;
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    size_t record_len = num, stride, count;
+
+    if (!get_records(env, argc >= 3 ? args[2] : NULL, &input, &input_len, record_len, &stride, &count))
+        return except(env, "The records do not fit the buffer, or offset, length, stride or count are invalid.");
+
+    void* output;
+    napi_value buff;
+
+    if (napi_create_buffer(env, count * 32, &output, &buff) != napi_ok)
+        return NULL;
+
+    multihash_chain_hash_batch(chain, input, stride, record_len, count, output);
+
+    return buff;
 }
 
-Handle<Value> nist5(const Arguments& args) {
-    HandleScope scope;
+/* chain(['blake', 'bmw', ...]) compiles a chain once; hashing through it never crosses back into JS */
+napi_value chain(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    if (argc < 1)
+        return except(env, "You must provide an array of primitive names.");
 
-    Local<Object> target = args[0]->ToObject();
+    napi_value constructor, result;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if (napi_get_reference_value(env, get_instance(env)->chain_constructor, &constructor) != napi_ok)
+        return NULL;
 
-    char * input = Buffer::Data(target);
-    char output[32];
+    if (napi_new_instance(env, constructor, 1, args, &result) != napi_ok)
+        return NULL;
+
+    return result;
+}
+#endif
 
-    uint32_t input_len = Buffer::Length(target);
+static const napi_type_tag filter_type_tag = { 0x6d68736866696c74ULL, 0x2b1e7f35c9a4d061ULL };
 
-    nist5_hash(input, output, input_len);
+static void filter_finalize(napi_env env, void* data, void* hint) {
+    multihash_share_filter_free((multihash_share_filter*) data);
+}
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+static multihash_share_filter* unwrap_filter(napi_env env, napi_value value) {
+    return (multihash_share_filter*) unwrap_tagged(env, value, &filter_type_tag);
 }
 
-Handle<Value> sha1(const Arguments& args) {
-    HandleScope scope;
+/* options.filter, when there is one; false when it is not a share filter */
+static bool get_filter_option(napi_env env, napi_value options, multihash_share_filter** filter) {
+    bool has = false;
+    napi_value value;
+
+    *filter = NULL;
+    if (!options || napi_has_named_property(env, options, "filter", &has) != napi_ok || !has)
+        return true;
+    napi_get_named_property(env, options, "filter", &value);
+    return (*filter = unwrap_filter(env, value)) != NULL;
+}
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+/* new ShareFilter(capacity, bloomBits), only reachable through shareFilter() */
+static napi_value filter_constructor(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_value self;
+    napi_get_cb_info(env, info, &argc, args, &self, NULL);
 
-    Local<Object> target = args[0]->ToObject();
+    double capacity = 0, bloom_bits = 0;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if (argc < 1 || !get_number(env, args[0], &capacity) || capacity < 1)
+        return except(env, "You must provide the filter capacity.");
 
-    char * input = Buffer::Data(target);
-    char output[32];
+    if (argc >= 2 && !get_number(env, args[1], &bloom_bits))
+        return NULL;
 
-    uint32_t input_len = Buffer::Length(target);
+    multihash_share_filter* filter = multihash_share_filter_new(capacity, bloom_bits > 0 ? bloom_bits : 0);
 
-    sha1_hash(input, output, input_len);
+    if (!filter)
+        return except(env, "Could not allocate share filter.");
+
+    if (napi_type_tag_object(env, self, &filter_type_tag) != napi_ok ||
+        napi_wrap(env, self, filter, filter_finalize, NULL, NULL) != napi_ok) {
+        multihash_share_filter_free(filter);
+        return except(env, "Could not allocate share filter.");
+    }
+
+    return self;
+}
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+/*
+ * Flattens the key parts (Buffers, strings or numbers) into one byte string,
+ * each part length-prefixed so ("ab", "c") and ("a", "bc") stay distinct.
+ */
+static bool build_share_key(napi_env env, napi_value* parts, size_t count, std::string& key) {
+    for (size_t i = 0; i < count; i++) {
+        char * data;
+        size_t length;
+        napi_valuetype type;
+        std::string str;
+        double num;
+
+        if (get_buffer(env, parts[i], &data, &length)) {
+            str.assign(data, length);
+        } else if (napi_typeof(env, parts[i], &type) == napi_ok && type == napi_string) {
+            napi_get_value_string_utf8(env, parts[i], NULL, 0, &length);
+            str.resize(length + 1);
+            napi_get_value_string_utf8(env, parts[i], &str[0], length + 1, &length);
+            str.resize(length);
+        } else if (type == napi_number) {
+            napi_get_value_double(env, parts[i], &num);
+            str.assign((const char*) &num, sizeof(num));
+        } else {
+            return false;
+        }
+
+        uint32_t prefix = str.size();
+        key.append((const char*) &prefix, sizeof(prefix));
+        key.append(str);
+    }
+    return true;
 }
 
-Handle<Value> x15(const Arguments& args) {
-    HandleScope scope;
+#define SHARE_KEY_MAX_PARTS 8
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+static napi_value filter_lookup(napi_env env, napi_callback_info info, bool insert) {
+    size_t argc = SHARE_KEY_MAX_PARTS;
+    napi_value args[SHARE_KEY_MAX_PARTS];
+    napi_value self;
+    napi_get_cb_info(env, info, &argc, args, &self, NULL);
 
-    Local<Object> target = args[0]->ToObject();
+    multihash_share_filter* filter = unwrap_filter(env, self);
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if (!filter)
+        return except(env, "Must be called on a share filter.");
 
-    char * input = Buffer::Data(target);
-    char output[32];
+    if (argc < 1 || argc > SHARE_KEY_MAX_PARTS)
+        return except(env, "You must provide between 1 and 8 key parts (jobId, extranonce, nonce, ntime...).");
+
+    std::string key;
+
+    if (!build_share_key(env, args, argc, key))
+        return except(env, "Key parts should be buffers, strings or numbers.");
 
-    uint32_t input_len = Buffer::Length(target);
+    bool result;
 
-    x15_hash(input, output, input_len);
+    if (insert)
+        result = multihash_share_filter_insert(filter, key.data(), key.size()) != 0;
+    else
+        result = multihash_share_filter_contains(filter, key.data(), key.size()) != 0;
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    napi_value value;
+    napi_get_boolean(env, result, &value);
+    return value;
 }
 
-Handle<Value> fresh(const Arguments& args) {
-    HandleScope scope;
+/* filter.check(jobId, extranonce, nonce, ntime): true the first time, false for a duplicate */
+static napi_value filter_check(napi_env env, napi_callback_info info) {
+    return filter_lookup(env, info, true);
+}
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+/* filter.has(jobId, extranonce, nonce, ntime): lookup without inserting */
+static napi_value filter_has(napi_env env, napi_callback_info info) {
+    return filter_lookup(env, info, false);
+}
 
-    Local<Object> target = args[0]->ToObject();
+/* filter.clear(), once the job expires */
+static napi_value filter_clear(napi_env env, napi_callback_info info) {
+    napi_value self;
+    napi_get_cb_info(env, info, NULL, NULL, &self, NULL);
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    multihash_share_filter* filter = unwrap_filter(env, self);
 
-    char * input = Buffer::Data(target);
-    char output[32];
+    if (!filter)
+        return except(env, "Must be called on a share filter.");
 
-    uint32_t input_len = Buffer::Length(target);
+    multihash_share_filter_clear(filter);
+    return NULL;
+}
+
+static napi_value filter_size(napi_env env, napi_callback_info info) {
+    napi_value self, value;
+    napi_get_cb_info(env, info, NULL, NULL, &self, NULL);
 
-    fresh_hash(input, output, input_len);
+    multihash_share_filter* filter = unwrap_filter(env, self);
 
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
+    if (!filter)
+        return except(env, "Must be called on a share filter.");
+
+    napi_create_double(env, multihash_share_filter_count(filter), &value);
+    return value;
 }
 
-static void sophia_hash(const char *input, int length, char *output) {
-    uint32_t hashA[16], hashB[16];
+/* shareFilter(capacity[, bloomBits]) creates the duplicate filter for one job */
+napi_value shareFilter(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    napi_value constructor, result;
 
-    sph_sophia512_context ctx_sophia[2];
+    if (napi_get_reference_value(env, get_instance(env)->filter_constructor, &constructor) != napi_ok)
+        return NULL;
 
-    sph_sophia512_init(&ctx_sophia[0]);
-    sph_sophia512 (&ctx_sophia[0], input, length);
-    sph_sophia512_close(&ctx_sophia[0], hashA);
+    if (napi_new_instance(env, constructor, argc, args, &result) != napi_ok)
+        return NULL;
 
-    sph_sophia512_init(&ctx_sophia[1]);
-    sph_sophia512 (&ctx_sophia[1], hashA, 64);
-    sph_sophia512_close(&ctx_sophia[1], hashB);
+    return result;
+}
+
+static bool get_algo(napi_env env, napi_value value, int* algo) {
+    napi_valuetype type;
+    char name[32];
+    size_t length;
+    double num;
+
+    napi_typeof(env, value, &type);
+
+    if (type == napi_string) {
+        napi_get_value_string_utf8(env, value, name, sizeof(name), &length);
+        *algo = multihash_algo_lookup(name);
+    } else if (type == napi_number) {
+        napi_get_value_double(env, value, &num);
+        *algo = num >= 0 && num < MULTIHASH_ALGO_COUNT ? (int) num : -1;
+    } else {
+        return false;
+    }
 
-    memcpy(output, hashB, 32);
+    return *algo >= 0;
 }
 
-Handle<Value> sophia(const Arguments& args) {
-    HandleScope scope;
+/* { N, r, nfactor, height, scratchpad } as used by scrypt, scryptn, scryptjane and boolberry */
+static bool get_params(napi_env env, napi_value options, multihash_params* params) {
+    double N = 0, r = 0, nfactor = 0, height = 0;
+    bool has = false;
 
-    if (args.Length() < 1)
-        return except("You must provide one argument.");
+    memset(params, 0, sizeof(*params));
 
-    Local<Object> target = args[0]->ToObject();
+    if (!options)
+        return true;
 
-    if(!Buffer::HasInstance(target))
-        return except("Argument should be a buffer object.");
+    if (!get_uint_property(env, options, "N", &N) || !get_uint_property(env, options, "r", &r) ||
+        !get_uint_property(env, options, "nfactor", &nfactor) || !get_uint_property(env, options, "height", &height))
+        return false;
 
-    char * input = Buffer::Data(target);
-    char output[32];
+    params->N = N;
+    params->r = r;
+    params->nfactor = nfactor;
+    params->height = height;
+
+    napi_has_named_property(env, options, "scratchpad", &has);
+    if (has) {
+        napi_value value;
+        char * scratchpad;
+        size_t length;
+
+        napi_get_named_property(env, options, "scratchpad", &value);
+        if (!get_buffer(env, value, &scratchpad, &length))
+            return false;
+        params->scratchpad = scratchpad;
+        params->scratchpad_len = length;
+    }
+
+    return true;
+}
+
+/*
+ * hashBatch(algo, buffer, recordLength[, options]): hashes every recordLength
+ * bytes of buffer with the named algorithm and returns the digests concatenated.
+ * options.offset, length, stride and count pick the records out of a larger
+ * buffer, see get_records.
+ * With options.filter (a shareFilter) every record is checked against the filter
+ * first and duplicates are not hashed; the result is then
+ * { hashes, hashed: Uint8Array } where hashed[i] is 0 for duplicates.
+ */
+napi_value hashBatch(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    if (argc < 3)
+        return except(env, "You must provide an algorithm, a buffer and a record length.");
+
+    int algo;
+    char * input;
+    size_t input_len;
+    double num;
+    multihash_params params;
+    multihash_share_filter* filter = NULL;
+    napi_value options = NULL;
+    napi_valuetype options_type = napi_undefined;
+
+    /* undefined or null options are left out */
+    if (argc >= 4)
+        napi_typeof(env, args[3], &options_type);
+    if (options_type == napi_object)
+        options = args[3];
+    else if (options_type != napi_undefined && options_type != napi_null)
+        return except(env, "Argument 4 should be an options object.");
+
+    if (!get_algo(env, args[0], &algo))
+        return except(env, "Unknown algorithm.");
+
+    if (!get_buffer(env, args[1], &input, &input_len))
+        return except(env, "Argument 2 should be a buffer object.");
+
+    if (!get_number(env, args[2], &num))
+        return NULL;
+
+    size_t record_len = num, stride, count;
+
+    if (!get_records(env, options, &input, &input_len, record_len, &stride, &count))
+        return except(env, "The records do not fit the buffer, or offset, length, stride or count are invalid.");
+
+    if (!get_params(env, options, &params))
+        return except(env, "Invalid algorithm parameters.");
+
+    if (!get_filter_option(env, options, &filter))
+        return except(env, "options.filter should be a share filter.");
+
+    void* output;
+    napi_value hashes;
+
+    if (napi_create_buffer(env, count * 32, &output, &hashes) != napi_ok)
+        return NULL;
+
+    multihash_ctx* ctx = get_instance(env)->ctx;
+
+    if (!filter) {
+        int rc = multihash_hash_batch(ctx, algo, &params, input, stride, record_len, count, output);
+        if (rc != MULTIHASH_OK)
+            return except(env, scratchpad_error(rc));
+        return hashes;
+    }
+
+    void* status;
+    napi_value arraybuffer, hashed, result;
+
+    if (napi_create_arraybuffer(env, count, &status, &arraybuffer) != napi_ok ||
+        napi_create_typedarray(env, napi_uint8_array, count, arraybuffer, 0, &hashed) != napi_ok)
+        return NULL;
+
+    memset(output, 0, count * 32);
+
+    int rc = multihash_hash_batch_filtered(ctx, algo, &params, filter, input, stride, record_len,
+                                           count, output, (uint8_t*) status);
+    if (rc != MULTIHASH_OK)
+        return except(env, scratchpad_error(rc));
+
+    napi_create_object(env, &result);
+    napi_set_named_property(env, result, "hashes", hashes);
+    napi_set_named_property(env, result, "hashed", hashed);
+    return result;
+}
+
+#if defined(MULTIHASHING_SPH) || defined(MULTIHASHING_CRYPTONOTE)
+/*
+ * Allocation-free entry points for the sub-microsecond algorithms:
+ * keccakInto(input[, inputOffset, inputLength], output[, offset]) writes the
+ * 32 byte digest of input into output at offset. Both are ArrayBufferViews
+ * (Buffers included). There is no options parsing and no result Buffer, so a
+ * call costs a handful of N-API calls on top of the hash itself.
+ */
+static napi_value hash_into(napi_env env, napi_callback_info info, int algo) {
+    size_t argc = 5;
+    napi_value args[5];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    char *input, *output;
+    size_t input_len, output_len;
+    uint32_t offset = 0;
+
+    if (argc < 2 || !get_input(env, args, &argc, 2, &input, &input_len) || !get_buffer(env, args[1], &output, &output_len))
+        return except(env, "You must provide an input (or input, offset and length) and an output view.");
+
+    if (argc >= 3 && napi_get_value_uint32(env, args[2], &offset) != napi_ok)
+        return except(env, "Offset should be a number.");
+
+    if (offset > output_len || output_len - offset < 32)
+        return except(env, "Output should have 32 bytes of room at offset.");
+
+    multihash_hash(NULL, algo, NULL, input, input_len, output + offset);
+    return NULL;
+}
+
+#define HASH_INTO(name, algo) \
+    napi_value name(napi_env env, napi_callback_info info) { return hash_into(env, info, algo); }
+
+#ifdef MULTIHASHING_SPH
+HASH_INTO(keccakInto, MULTIHASH_KECCAK)
+HASH_INTO(blakeInto, MULTIHASH_BLAKE)
+HASH_INTO(skeinInto, MULTIHASH_SKEIN)
+HASH_INTO(groestlInto, MULTIHASH_GROESTL)
+#endif
+#ifdef MULTIHASHING_CRYPTONOTE
+HASH_INTO(cryptonightFastInto, MULTIHASH_CRYPTONIGHT_FAST)
+#endif
+#endif
+
+/*
+ * Stratum jobs: stratumJob(options) keeps the static parts of a mining.notify
+ * natively (see multihash_job in multihash.h), and a share is rebuilt and hashed
+ * in one call from its extranonce2, ntime and nonce. submit runs on the libuv
+ * thread pool; hash is the synchronous twin. submitBatch spreads many shares over
+ * the scheduler and reports a block candidate as soon as it is hashed.
+ */
+struct job_handle {
+    multihash_job* job;
+    bool has_diff1;
+    double diff1;
+    uint64_t serial;            /* with the address, tells jobs apart in a share filter */
+    char* extranonce1;          /* the job's, for share filter keys */
+    size_t extranonce1_len;
+};
+
+static uint64_t job_serial;
+
+struct job_share {
+    unsigned char extranonce1[MULTIHASH_JOB_EXTRANONCE_MAX];
+    size_t extranonce1_len;
+    bool has_extranonce1;
+    unsigned char extranonce2[MULTIHASH_JOB_EXTRANONCE_MAX];
+    size_t extranonce2_len;
+    uint32_t ntime;
+    uint32_t nonce;
+};
+
+struct job_work {
+    napi_async_work work;
+    napi_ref self;
+    napi_ref callback;
+    napi_deferred deferred;
+    job_handle* handle;
+    job_share share;
+    bool duplicate;             /* the filter had it: settles without hashing */
+    int rc;
+    unsigned char header[80];
+    unsigned char hash[32];
+};
+
+static const napi_type_tag job_type_tag = { 0x6d6873686a6f6231ULL, 0x5f0ad3c1e8b24796ULL };
+
+static void job_finalize(napi_env env, void* data, void* hint) {
+    job_handle* handle = (job_handle*) data;
+    multihash_job_free(handle->job);
+    free(handle->extranonce1);
+    free(handle);
+}
+
+static job_handle* unwrap_job(napi_env env, napi_value value) {
+    return (job_handle*) unwrap_tagged(env, value, &job_type_tag);
+}
+
+/* a Buffer (or view) option, copied by multihash_job_new */
+static bool get_bytes_property(napi_env env, napi_value object, const char* name, bool required, char** data, size_t* length) {
+    bool has = false;
+    napi_value value;
+
+    *data = NULL;
+    *length = 0;
+    if (napi_has_named_property(env, object, name, &has) != napi_ok || !has)
+        return !required;
+    napi_get_named_property(env, object, name, &value);
+    return get_buffer(env, value, data, length);
+}
+
+/* merkleBranches: an array of 32 byte buffers, or one buffer of them back to back */
+static bool get_branches(napi_env env, napi_value object, std::string& branches) {
+    bool has = false, is_array = false;
+    napi_value value;
+    char* data;
+    size_t length;
+    uint32_t count = 0;
+
+    if (napi_has_named_property(env, object, "merkleBranches", &has) != napi_ok || !has)
+        return true;
+    napi_get_named_property(env, object, "merkleBranches", &value);
+
+    if (get_buffer(env, value, &data, &length)) {
+        branches.assign(data, length);
+        return length % 32 == 0;
+    }
+
+    if (napi_is_array(env, value, &is_array) != napi_ok || !is_array)
+        return false;
+    napi_get_array_length(env, value, &count);
+    for (uint32_t i = 0; i < count; i++) {
+        napi_value element;
+        napi_get_element(env, value, i, &element);
+        if (!get_buffer(env, element, &data, &length) || length != 32)
+            return false;
+        branches.append(data, length);
+    }
+    return true;
+}
+
+/*
+ * new StratumJob({ algorithm, coinbase1, coinbase2, extranonce1, extranonce2Size,
+ * merkleBranches, version, prevHash, nbits, blockTarget, diff1, N, r, nfactor }),
+ * only reachable through stratumJob(). blockTarget overrides the target nbits encodes.
+ */
+static napi_value job_constructor(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_value self;
+    napi_get_cb_info(env, info, &argc, args, &self, NULL);
+
+    napi_valuetype type = napi_undefined;
+    multihash_job_template tmpl;
+    std::string branches;
+    napi_value value;
+    char *coinbase1, *coinbase2, *extranonce1, *prevhash, *block_target;
+    size_t prevhash_len, block_target_len;
+    double version = 0, nbits = 0, extranonce2_size = 0;
+    bool has = false;
+
+    if (argc >= 1)
+        napi_typeof(env, args[0], &type);
+    if (type != napi_object)
+        return except(env, "You must provide the job options.");
+
+    memset(&tmpl, 0, sizeof(tmpl));
+
+    if (napi_get_named_property(env, args[0], "algorithm", &value) != napi_ok || !get_algo(env, value, &tmpl.algo))
+        return except(env, "options.algorithm should be an algorithm name.");
+
+    if (!get_params(env, args[0], &tmpl.params))
+        return except(env, "Invalid algorithm parameters.");
+
+    if (!get_bytes_property(env, args[0], "coinbase1", true, &coinbase1, &tmpl.coinbase1_len) ||
+        !get_bytes_property(env, args[0], "coinbase2", true, &coinbase2, &tmpl.coinbase2_len) ||
+        !get_bytes_property(env, args[0], "extranonce1", false, &extranonce1, &tmpl.extranonce1_len))
+        return except(env, "coinbase1 and coinbase2 (and extranonce1, if given) should be buffers.");
+
+    if (!get_bytes_property(env, args[0], "prevHash", true, &prevhash, &prevhash_len) || prevhash_len != 32)
+        return except(env, "prevHash should be a 32 byte buffer in header byte order.");
+
+    if (!get_bytes_property(env, args[0], "blockTarget", false, &block_target, &block_target_len) ||
+        (block_target && block_target_len != 32))
+        return except(env, "blockTarget should be a 32 byte buffer (little endian).");
+
+    if (!get_branches(env, args[0], branches))
+        return except(env, "merkleBranches should be 32 byte buffers.");
+
+    if (!get_uint_property(env, args[0], "version", &version) || version > UINT32_MAX ||
+        !get_uint_property(env, args[0], "nbits", &nbits) || nbits > UINT32_MAX ||
+        !get_uint_property(env, args[0], "extranonce2Size", &extranonce2_size) ||
+        extranonce2_size > MULTIHASH_JOB_EXTRANONCE_MAX)
+        return except(env, "version and nbits should be 32 bit unsigned integers, extranonce2Size at most 32.");
+
+    tmpl.coinbase1 = coinbase1;
+    tmpl.coinbase2 = coinbase2;
+    tmpl.extranonce1 = extranonce1;
+    tmpl.extranonce2_len = extranonce2_size;
+    tmpl.merkle_branches = branches.data();
+    tmpl.merkle_count = branches.size() / 32;
+    tmpl.version = version;
+    tmpl.prevhash = prevhash;
+    tmpl.nbits = nbits;
+    tmpl.block_target = block_target;
+
+    job_handle* handle = (job_handle*) calloc(1, sizeof(job_handle));
+
+    if (!handle)
+        return except(env, "Could not allocate job.");
+
+    napi_has_named_property(env, args[0], "diff1", &has);
+    if (has) {
+        napi_get_named_property(env, args[0], "diff1", &value);
+        if (!get_diff1(env, value, &handle->diff1)) {
+            free(handle);
+            return except(env, "diff1 should be a number or a 32 byte buffer.");
+        }
+        handle->has_diff1 = true;
+    }
+
+    if (!(handle->job = multihash_job_new(&tmpl))) {
+        free(handle);
+        return except(env, "This algorithm cannot hash stratum jobs in this module.");
+    }
+
+    handle->serial = __atomic_add_fetch(&job_serial, 1, __ATOMIC_RELAXED);
+    if (extranonce1) {
+        if (!(handle->extranonce1 = (char*) malloc(tmpl.extranonce1_len ? tmpl.extranonce1_len : 1))) {
+            job_finalize(env, handle, NULL);
+            return except(env, "Could not allocate job.");
+        }
+        memcpy(handle->extranonce1, extranonce1, tmpl.extranonce1_len);
+        handle->extranonce1_len = tmpl.extranonce1_len;
+    }
 
-    uint32_t input_len = Buffer::Length(target);
-
-    sophia_hash(input, input_len, output);
-
-    Buffer* buff = Buffer::New(output, 32);
-    return scope.Close(buff->handle_);
-}
-
-void init(Handle<Object> exports) {
-    exports->Set(String::NewSymbol("quark"), FunctionTemplate::New(quark)->GetFunction());
-    exports->Set(String::NewSymbol("x11"), FunctionTemplate::New(x11)->GetFunction());
-    exports->Set(String::NewSymbol("scrypt"), FunctionTemplate::New(scrypt)->GetFunction());
-    exports->Set(String::NewSymbol("scryptn"), FunctionTemplate::New(scryptn)->GetFunction());
-    exports->Set(String::NewSymbol("scryptjane"), FunctionTemplate::New(scryptjane)->GetFunction());
-    exports->Set(String::NewSymbol("keccak"), FunctionTemplate::New(keccak)->GetFunction());
-    exports->Set(String::NewSymbol("bcrypt"), FunctionTemplate::New(bcrypt)->GetFunction());
-    exports->Set(String::NewSymbol("skein"), FunctionTemplate::New(skein)->GetFunction());
-    exports->Set(String::NewSymbol("groestl"), FunctionTemplate::New(groestl)->GetFunction());
-    exports->Set(String::NewSymbol("groestlmyriad"), FunctionTemplate::New(groestlmyriad)->GetFunction());
-    exports->Set(String::NewSymbol("blake"), FunctionTemplate::New(blake)->GetFunction());
-    exports->Set(String::NewSymbol("fugue"), FunctionTemplate::New(fugue)->GetFunction());
-    exports->Set(String::NewSymbol("qubit"), FunctionTemplate::New(qubit)->GetFunction());
-    exports->Set(String::NewSymbol("hefty1"), FunctionTemplate::New(hefty1)->GetFunction());
-    exports->Set(String::NewSymbol("shavite3"), FunctionTemplate::New(shavite3)->GetFunction());
-    exports->Set(String::NewSymbol("cryptonight"), FunctionTemplate::New(cryptonight)->GetFunction());
-    exports->Set(String::NewSymbol("x13"), FunctionTemplate::New(x13)->GetFunction());
-    exports->Set(String::NewSymbol("boolberry"), FunctionTemplate::New(boolberry)->GetFunction());
-    exports->Set(String::NewSymbol("nist5"), FunctionTemplate::New(nist5)->GetFunction());
-    exports->Set(String::NewSymbol("sha1"), FunctionTemplate::New(sha1)->GetFunction());
-    exports->Set(String::NewSymbol("x15"), FunctionTemplate::New(x15)->GetFunction());
-    exports->Set(String::NewSymbol("fresh"), FunctionTemplate::New(fresh)->GetFunction());
-    exports->Set(String::NewSymbol("sophia"), FunctionTemplate::New(sophia)->GetFunction());
-}
-
-NODE_MODULE(multihashing, init)
+    if (napi_type_tag_object(env, self, &job_type_tag) != napi_ok ||
+        napi_wrap(env, self, handle, job_finalize, NULL, NULL) != napi_ok) {
+        job_finalize(env, handle, NULL);
+        return except(env, "Could not allocate job.");
+    }
+
+    return self;
+}
+
+/* (extranonce2, ntime, nonce[, extranonce1]), copied so the share outlives the call */
+static bool get_share(napi_env env, napi_value* args, size_t argc, job_share* share) {
+    char* data;
+    size_t length;
+
+    if (argc < 3 || !get_buffer(env, args[0], &data, &length) || length > MULTIHASH_JOB_EXTRANONCE_MAX ||
+        napi_get_value_uint32(env, args[1], &share->ntime) != napi_ok ||
+        napi_get_value_uint32(env, args[2], &share->nonce) != napi_ok)
+        return false;
+    memcpy(share->extranonce2, data, length);
+    share->extranonce2_len = length;
+
+    share->has_extranonce1 = false;
+    if (argc >= 4) {
+        if (!get_buffer(env, args[3], &data, &length) || length > MULTIHASH_JOB_EXTRANONCE_MAX)
+            return false;
+        memcpy(share->extranonce1, data, length);
+        share->extranonce1_len = length;
+        share->has_extranonce1 = true;
+    }
+    return true;
+}
+
+/*
+ * A share's filter key: the job, extranonce1 (the job's when the share has
+ * none), extranonce2, ntime and nonce, each length-prefixed like filter.check's.
+ */
+static void job_share_key(const job_handle* handle, const job_share* share, std::string& key) {
+    const char* extranonce1 = share->has_extranonce1 ? (const char*) share->extranonce1 : handle->extranonce1;
+    uint32_t lengths[2] = {
+        (uint32_t) (share->has_extranonce1 ? share->extranonce1_len : handle->extranonce1_len),
+        (uint32_t) share->extranonce2_len,
+    };
+
+    key.assign((const char*) &handle, sizeof(handle));
+    key.append((const char*) &handle->serial, sizeof(handle->serial));
+    key.append((const char*) &lengths[0], sizeof(lengths[0]));
+    key.append(extranonce1 ? extranonce1 : "", lengths[0]);
+    key.append((const char*) &lengths[1], sizeof(lengths[1]));
+    key.append((const char*) share->extranonce2, lengths[1]);
+    key.append((const char*) &share->ntime, sizeof(share->ntime));
+    key.append((const char*) &share->nonce, sizeof(share->nonce));
+}
+
+/* false for a share the filter has seen; a full filter lets shares through */
+static bool job_share_new(multihash_share_filter* filter, const job_handle* handle, const job_share* share) {
+    std::string key;
+
+    if (!filter)
+        return true;
+    job_share_key(handle, share, key);
+    return multihash_share_filter_insert(filter, key.data(), key.size()) != 0;
+}
+
+static int job_run(job_handle* handle, const job_share* share, unsigned char* header, unsigned char* hash) {
+    return multihash_job_hash(NULL, handle->job,
+                              share->has_extranonce1 ? share->extranonce1 : NULL, share->extranonce1_len,
+                              share->extranonce2, share->extranonce2_len, share->ntime, share->nonce,
+                              header, hash);
+}
+
+static const char* job_error(int rc) {
+    if (rc == MULTIHASH_EINVAL)
+        return "extranonce2 has the wrong size, or the job has no extranonce1.";
+    return scratchpad_error(rc);
+}
+
+/* { hash, header, difficulty, block } */
+static napi_value job_result(napi_env env, job_handle* handle, const unsigned char* header, const unsigned char* hash) {
+    napi_value result, difficulty, block;
+
+    napi_create_object(env, &result);
+    napi_set_named_property(env, result, "hash", new_buffer(env, (const char*) hash, 32));
+    napi_set_named_property(env, result, "header", new_buffer(env, (const char*) header, 80));
+    napi_get_boolean(env, multihash_job_is_block(handle->job, hash), &block);
+    napi_set_named_property(env, result, "block", block);
+    if (handle->has_diff1) {
+        napi_create_double(env, multihash_hash_to_difficulty(hash, handle->diff1), &difficulty);
+        napi_set_named_property(env, result, "difficulty", difficulty);
+    }
+    return result;
+}
+
+/* job.hash(extranonce2, ntime, nonce[, extranonce1]) */
+static napi_value job_hash(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value self;
+    napi_get_cb_info(env, info, &argc, args, &self, NULL);
+
+    job_handle* handle = unwrap_job(env, self);
+    job_share share;
+    unsigned char header[80], hash[32];
+
+    if (!handle)
+        return except(env, "hash must be called on a stratum job.");
+    if (!get_share(env, args, argc, &share))
+        return except(env, "You must provide extranonce2 (a buffer), ntime and nonce (numbers).");
+
+    int rc = job_run(handle, &share, header, hash);
+    if (rc != MULTIHASH_OK)
+        return except(env, job_error(rc));
+    return job_result(env, handle, header, hash);
+}
+
+static void job_execute(napi_env env, void* data) {
+    job_work* work = (job_work*) data;
+    if (!work->duplicate)
+        work->rc = job_run(work->handle, &work->share, work->header, work->hash);
+}
+
+static void job_complete(napi_env env, napi_status status, void* data) {
+    job_work* work = (job_work*) data;
+    napi_value error = NULL, result = NULL, message;
+
+    if (status != napi_ok || work->rc != MULTIHASH_OK) {
+        napi_create_string_utf8(env, status != napi_ok ? "Share was cancelled." : job_error(work->rc),
+                                NAPI_AUTO_LENGTH, &message);
+        napi_create_error(env, NULL, message, &error);
+    } else if (work->duplicate) {
+        napi_value duplicate;
+        napi_create_object(env, &result);
+        napi_get_boolean(env, true, &duplicate);
+        napi_set_named_property(env, result, "duplicate", duplicate);
+    } else {
+        result = job_result(env, work->handle, work->header, work->hash);
+    }
+
+    if (work->callback) {
+        napi_value callback, global, argv[2];
+        napi_get_reference_value(env, work->callback, &callback);
+        napi_get_global(env, &global);
+        if (error)
+            argv[0] = error;
+        else
+            napi_get_null(env, &argv[0]);
+        if (result)
+            argv[1] = result;
+        else
+            napi_get_undefined(env, &argv[1]);
+        napi_call_function(env, global, callback, 2, argv, NULL);
+        napi_delete_reference(env, work->callback);
+    } else if (error) {
+        napi_reject_deferred(env, work->deferred, error);
+    } else {
+        napi_resolve_deferred(env, work->deferred, result);
+    }
+
+    napi_delete_reference(env, work->self);
+    napi_delete_async_work(env, work->work);
+    free(work);
+}
+
+/*
+ * job.submit(extranonce2, ntime, nonce[, extranonce1][, options][, callback]):
+ * callback(err, { hash, header, difficulty, block }), or a Promise of the result
+ * without a callback. With options.filter (a shareFilter) a share the filter has
+ * seen is not hashed and the result is { duplicate: true }.
+ */
+static napi_value job_submit(napi_env env, napi_callback_info info) {
+    size_t argc = 5;
+    napi_value args[5];
+    napi_value self, promise = NULL, name;
+    napi_get_cb_info(env, info, &argc, args, &self, NULL);
+
+    job_handle* handle = unwrap_job(env, self);
+    napi_valuetype type = napi_undefined, options_type = napi_undefined;
+    multihash_share_filter* filter = NULL;
+    napi_value callback = NULL;
+    char* data;
+    size_t length;
+
+    if (!handle)
+        return except(env, "submit must be called on a stratum job.");
+
+    if (argc >= 1)
+        napi_typeof(env, args[argc - 1], &type);
+    if (type == napi_function)
+        callback = args[--argc];
+
+    /* a trailing object that is not a buffer holds the options */
+    if (argc >= 4)
+        napi_typeof(env, args[argc - 1], &options_type);
+    if (options_type == napi_object && !get_buffer(env, args[argc - 1], &data, &length)) {
+        if (!get_filter_option(env, args[argc - 1], &filter))
+            return except(env, "options.filter should be a share filter.");
+        argc--;
+    }
+
+    job_work* work = (job_work*) calloc(1, sizeof(job_work));
+
+    if (!work)
+        return except(env, "Could not allocate share.");
+
+    if (!get_share(env, args, argc, &work->share)) {
+        free(work);
+        return except(env, "You must provide extranonce2 (a buffer), ntime and nonce (numbers).");
+    }
+
+    work->handle = handle;
+    work->duplicate = !job_share_new(filter, handle, &work->share);
+    if (type == napi_function)
+        napi_create_reference(env, callback, 1, &work->callback);
+    else
+        napi_create_promise(env, &work->deferred, &promise);
+    /* the job must outlive the work */
+    napi_create_reference(env, self, 1, &work->self);
+
+    napi_create_string_utf8(env, "multihashing:share", NAPI_AUTO_LENGTH, &name);
+    napi_create_async_work(env, NULL, name, job_execute, job_complete, work, &work->work);
+    napi_queue_async_work(env, work->work);
+
+    return promise;
+}
+
+/*
+ * A batch of shares for one job. A libuv thread builds the headers and queues
+ * the batch on the scheduler, whose workers hash it. Block candidates go back
+ * to the main thread through a threadsafe function the moment a worker hashes
+ * them; the batch settles from its finalizer, so it never overtakes a
+ * candidate's onBlock. The function is held once for the async work and once
+ * for the queued batch, so it settles after both.
+ */
+struct job_batch_work {
+    napi_async_work work;
+    napi_threadsafe_function on_block;
+    napi_ref self;
+    napi_ref callback;
+    napi_deferred deferred;
+    napi_status status;
+    job_handle* handle;
+    multihash_scheduler* scheduler;
+    bool filtered;
+    job_share* shares;
+    uint32_t* positions;        /* of shares[i] in the caller's array, duplicates left out */
+    size_t count;
+    size_t total;               /* count plus the duplicates */
+    unsigned char* headers;
+    unsigned char* hashes;
+    int* statuses;
+    int rc;
+};
+
+struct job_block {
+    size_t index;
+    unsigned char header[80];
+    unsigned char hash[32];
+};
+
+static void job_batch_free(job_batch_work* work) {
+    free(work->shares);
+    free(work->positions);
+    free(work->headers);
+    free(work->hashes);
+    free(work->statuses);
+    free(work);
+}
+
+/* reads { extranonce2, ntime, nonce[, extranonce1] } for every share, then leaves out what the filter has seen */
+static const char* get_job_shares(napi_env env, napi_value array, multihash_share_filter* filter, job_batch_work* work) {
+    bool is_array = false, has;
+    uint32_t count;
+    napi_value args[4];
+    size_t argc;
+
+    if (napi_is_array(env, array, &is_array) != napi_ok || !is_array)
+        return "Argument 1 should be an array of shares.";
+    napi_get_array_length(env, array, &count);
+
+    work->total = count;
+    work->shares = (job_share*) calloc(count ? count : 1, sizeof(job_share));
+    work->positions = (uint32_t*) malloc(count ? count * sizeof(uint32_t) : 1);
+    work->headers = (unsigned char*) malloc(count ? count * 80 : 1);
+    work->hashes = (unsigned char*) malloc(count ? count * 32 : 1);
+    work->statuses = (int*) calloc(count ? count : 1, sizeof(int));
+    if (!work->shares || !work->positions || !work->headers || !work->hashes || !work->statuses)
+        return "Could not allocate the batch.";
+
+    for (uint32_t i = 0; i < count; i++) {
+        napi_value item;
+        napi_valuetype type;
+
+        napi_get_element(env, array, i, &item);
+        napi_typeof(env, item, &type);
+        if (type != napi_object)
+            return "Every share should be an object.";
+
+        napi_get_named_property(env, item, "extranonce2", &args[0]);
+        napi_get_named_property(env, item, "ntime", &args[1]);
+        napi_get_named_property(env, item, "nonce", &args[2]);
+        argc = 3;
+        if (napi_has_named_property(env, item, "extranonce1", &has) == napi_ok && has) {
+            napi_get_named_property(env, item, "extranonce1", &args[3]);
+            argc = 4;
+        }
+        if (!get_share(env, args, argc, &work->shares[i]))
+            return "Every share needs extranonce2 (a buffer), ntime and nonce (numbers).";
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (!job_share_new(filter, work->handle, &work->shares[i]))
+            continue;
+        work->shares[work->count] = work->shares[i];
+        work->positions[work->count++] = i;
+    }
+    return NULL;
+}
+
+static void job_block_found(void* arg, size_t index, const void* header, const void* hash) {
+    job_batch_work* work = (job_batch_work*) arg;
+    job_block* block = (job_block*) malloc(sizeof(job_block));
+
+    if (!block)
+        return;
+    block->index = work->positions[index];
+    memcpy(block->header, header, 80);
+    memcpy(block->hash, hash, 32);
+    if (napi_call_threadsafe_function(work->on_block, block, napi_tsfn_nonblocking) != napi_ok)
+        free(block);
+}
+
+/* onBlock(index, { hash, header, difficulty, block }) */
+static void job_block_call(napi_env env, napi_value on_block, void* context, void* data) {
+    job_batch_work* work = (job_batch_work*) context;
+    job_block* block = (job_block*) data;
+
+    if (env) {
+        napi_value global, argv[2];
+        napi_get_global(env, &global);
+        napi_create_uint32(env, block->index, &argv[0]);
+        argv[1] = job_result(env, work->handle, block->header, block->hash);
+        napi_call_function(env, global, on_block, 2, argv, NULL);
+    }
+    free(block);
+}
+
+/* on the last worker out of the batch */
+static void job_batch_done(void* arg, int status) {
+    job_batch_work* work = (job_batch_work*) arg;
+    napi_release_threadsafe_function(work->on_block, napi_tsfn_release);
+}
+
+static void job_batch_execute(napi_env env, void* data) {
+    job_batch_work* work = (job_batch_work*) data;
+    size_t i;
+    multihash_job_share* shares = (multihash_job_share*) calloc(work->count ? work->count : 1,
+                                                                 sizeof(multihash_job_share));
+
+    if (!shares) {
+        work->rc = MULTIHASH_ENOMEM;
+        return;
+    }
+    for (i = 0; i < work->count; i++) {
+        job_share* share = &work->shares[i];
+
+        shares[i].extranonce1 = share->has_extranonce1 ? share->extranonce1 : NULL;
+        shares[i].extranonce1_len = share->extranonce1_len;
+        shares[i].extranonce2 = share->extranonce2;
+        shares[i].extranonce2_len = share->extranonce2_len;
+        shares[i].ntime = share->ntime;
+        shares[i].nonce = share->nonce;
+    }
+    napi_acquire_threadsafe_function(work->on_block);
+    work->rc = multihash_job_submit_batch(work->scheduler, work->handle->job, shares, work->count,
+                                          work->headers, work->hashes, work->statuses,
+                                          job_block_found, job_batch_done, work);
+    if (work->rc != MULTIHASH_OK)
+        napi_release_threadsafe_function(work->on_block, napi_tsfn_release);
+    free(shares);
+}
+
+/*
+ * { hashes, headers, hashed: Uint8Array, blocks: [index] }, in the caller's
+ * order; with a filter also duplicates: [index], whose rows are zero.
+ */
+static napi_value job_batch_result(napi_env env, job_batch_work* work) {
+    napi_value result, arraybuffer, hashed, hashes, headers, blocks, duplicates, index;
+    void *status, *hash_data, *header_data;
+    uint32_t found = 0, repeated = 0;
+    size_t i, k = 0;
+
+    if (napi_create_arraybuffer(env, work->total, &status, &arraybuffer) != napi_ok ||
+        napi_create_typedarray(env, napi_uint8_array, work->total, arraybuffer, 0, &hashed) != napi_ok ||
+        napi_create_buffer(env, work->total * 32, &hash_data, &hashes) != napi_ok ||
+        napi_create_buffer(env, work->total * 80, &header_data, &headers) != napi_ok)
+        return NULL;
+
+    napi_create_array(env, &blocks);
+    napi_create_array(env, &duplicates);
+    for (i = 0; i < work->total; i++) {
+        unsigned char* hash = (unsigned char*) hash_data + i * 32;
+        unsigned char* header = (unsigned char*) header_data + i * 80;
+
+        if (k == work->count || work->positions[k] != i) {
+            memset(hash, 0, 32);
+            memset(header, 0, 80);
+            ((uint8_t*) status)[i] = 0;
+            napi_create_uint32(env, i, &index);
+            napi_set_element(env, duplicates, repeated++, index);
+            continue;
+        }
+
+        memcpy(hash, work->hashes + k * 32, 32);
+        memcpy(header, work->headers + k * 80, 80);
+        ((uint8_t*) status)[i] = work->statuses[k] == MULTIHASH_OK;
+        if (work->statuses[k] == MULTIHASH_OK && multihash_job_is_block(work->handle->job, hash)) {
+            napi_create_uint32(env, i, &index);
+            napi_set_element(env, blocks, found++, index);
+        }
+        k++;
+    }
+
+    napi_create_object(env, &result);
+    napi_set_named_property(env, result, "hashes", hashes);
+    napi_set_named_property(env, result, "headers", headers);
+    napi_set_named_property(env, result, "hashed", hashed);
+    napi_set_named_property(env, result, "blocks", blocks);
+    if (work->filtered)
+        napi_set_named_property(env, result, "duplicates", duplicates);
+    return result;
+}
+
+/* runs once the last queued onBlock has been called */
+static void job_batch_settle(napi_env env, void* data, void* hint) {
+    job_batch_work* work = (job_batch_work*) data;
+    napi_value error = NULL, result = NULL, message;
+
+    if (work->status != napi_ok || work->rc != MULTIHASH_OK) {
+        napi_create_string_utf8(env, work->status != napi_ok ? "Batch was cancelled." : job_error(work->rc),
+                                NAPI_AUTO_LENGTH, &message);
+        napi_create_error(env, NULL, message, &error);
+    } else {
+        result = job_batch_result(env, work);
+    }
+
+    if (work->callback) {
+        napi_value callback, global, argv[2];
+        napi_get_reference_value(env, work->callback, &callback);
+        napi_get_global(env, &global);
+        if (error)
+            argv[0] = error;
+        else
+            napi_get_null(env, &argv[0]);
+        if (result)
+            argv[1] = result;
+        else
+            napi_get_undefined(env, &argv[1]);
+        napi_call_function(env, global, callback, 2, argv, NULL);
+        napi_delete_reference(env, work->callback);
+    } else if (error) {
+        napi_reject_deferred(env, work->deferred, error);
+    } else {
+        napi_resolve_deferred(env, work->deferred, result);
+    }
+
+    napi_delete_reference(env, work->self);
+    job_batch_free(work);
+}
+
+static void job_batch_complete(napi_env env, napi_status status, void* data) {
+    job_batch_work* work = (job_batch_work*) data;
+
+    work->status = status;
+    napi_delete_async_work(env, work->work);
+    napi_release_threadsafe_function(work->on_block, napi_tsfn_release);
+}
+
+/*
+ * job.submitBatch(shares, onBlock[, options][, callback]): hashes { extranonce2,
+ * ntime, nonce[, extranonce1] } shares on the process's scheduler. onBlock(index,
+ * result) is called for a share meeting the job's block target while the rest
+ * of the batch still runs; callback(err, { hashes, headers, hashed, blocks }),
+ * or a Promise of the result without a callback, follows every onBlock. With
+ * options.filter (a shareFilter) shares the filter has seen are not hashed and
+ * are listed in the result's duplicates.
+ */
+static napi_value job_submit_batch(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_value self, promise = NULL, name;
+    napi_get_cb_info(env, info, &argc, args, &self, NULL);
+
+    job_handle* handle = unwrap_job(env, self);
+    napi_valuetype type = napi_undefined, callback_type = napi_undefined;
+    multihash_share_filter* filter = NULL;
+    size_t callback_arg = 2;
+    const char* error;
+
+    if (!handle)
+        return except(env, "submitBatch must be called on a stratum job.");
+
+    if (argc >= 2)
+        napi_typeof(env, args[1], &type);
+    if (type != napi_function)
+        return except(env, "You must provide the shares and an onBlock function.");
+    if (argc >= 3)
+        napi_typeof(env, args[2], &callback_type);
+    if (callback_type == napi_object) {
+        if (!get_filter_option(env, args[2], &filter))
+            return except(env, "options.filter should be a share filter.");
+        callback_arg = 3;
+        callback_type = napi_undefined;
+        if (argc >= 4)
+            napi_typeof(env, args[3], &callback_type);
+    }
+
+    multihash_scheduler* scheduler = get_scheduler(env);
+
+    if (!scheduler)
+        return except(env, "Could not start the scheduler.");
+
+    job_batch_work* work = (job_batch_work*) calloc(1, sizeof(job_batch_work));
+
+    if (!work)
+        return except(env, "Could not allocate the batch.");
+
+    work->handle = handle;
+    work->scheduler = scheduler;
+    work->filtered = filter != NULL;
+
+    if ((error = get_job_shares(env, args[0], filter, work))) {
+        job_batch_free(work);
+        return except(env, error);
+    }
+
+    napi_create_string_utf8(env, "multihashing:shares", NAPI_AUTO_LENGTH, &name);
+    if (napi_create_threadsafe_function(env, args[1], NULL, name, 0, 1, work, job_batch_settle, work,
+                                        job_block_call, &work->on_block) != napi_ok) {
+        job_batch_free(work);
+        return except(env, "Could not allocate the batch.");
+    }
+
+    if (callback_type == napi_function)
+        napi_create_reference(env, args[callback_arg], 1, &work->callback);
+    else
+        napi_create_promise(env, &work->deferred, &promise);
+    /* the job must outlive the work */
+    napi_create_reference(env, self, 1, &work->self);
+
+    napi_create_async_work(env, NULL, name, job_batch_execute, job_batch_complete, work, &work->work);
+    napi_queue_async_work(env, work->work);
+
+    return promise;
+}
+
+/* stratumJob(options) builds a job once per mining.notify */
+napi_value stratumJob(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    if (argc < 1)
+        return except(env, "You must provide the job options.");
+
+    napi_value constructor, result;
+
+    if (napi_get_reference_value(env, get_instance(env)->job_constructor, &constructor) != napi_ok)
+        return NULL;
+
+    if (napi_new_instance(env, constructor, 1, args, &result) != napi_ok)
+        return NULL;
+
+    return result;
+}
+
+/*
+ * Mixed batches: every task names its own algorithm and parameters, and the
+ * scheduler (sched.c) spreads them over its threads. The batch is
+ * queued straight from the main thread and settles through a threadsafe
+ * function, so it holds no libuv thread while it waits its turn. Inputs are
+ * copied; the task array is referenced so scratchpads outlive the work.
+ */
+struct tasks_work {
+    napi_threadsafe_function settle;
+    napi_ref tasks;
+    napi_ref callback;
+    napi_deferred deferred;
+    multihash_scheduler* scheduler;
+    multihash_task* items;
+    size_t count;
+    size_t total;               /* count plus the duplicates */
+    uint8_t* duplicate;         /* per task, with a filter */
+    char* inputs;
+    unsigned char* hashes;
+    int rc;
+};
+
+static void tasks_work_free(tasks_work* work) {
+    free(work->items);
+    free(work->duplicate);
+    free(work->inputs);
+    free(work->hashes);
+    free(work);
+}
+
+/* reads { algorithm, input[, N, r, nfactor, height, scratchpad] } for every task */
+static const char* get_tasks(napi_env env, napi_value array, tasks_work* work) {
+    bool is_array = false;
+    uint32_t count;
+    size_t total = 0, offset = 0, i;
+
+    if (napi_is_array(env, array, &is_array) != napi_ok || !is_array)
+        return "Argument 1 should be an array of tasks.";
+    napi_get_array_length(env, array, &count);
+
+    work->count = work->total = count;
+    work->items = (multihash_task*) calloc(count ? count : 1, sizeof(multihash_task));
+    work->hashes = (unsigned char*) malloc(count ? count * 32 : 1);
+    if (!work->items || !work->hashes)
+        return "Could not allocate the batch.";
+
+    for (i = 0; i < count; i++) {
+        multihash_task* task = &work->items[i];
+        napi_value item, value;
+        napi_valuetype type;
+        char* data;
+
+        napi_get_element(env, array, i, &item);
+        napi_typeof(env, item, &type);
+        if (type != napi_object)
+            return "Every task should be an object.";
+
+        napi_get_named_property(env, item, "algorithm", &value);
+        if (!get_algo(env, value, &task->algo) || !multihash_algo_available(task->algo))
+            return "Unknown algorithm.";
+
+        napi_get_named_property(env, item, "input", &value);
+        if (!get_buffer(env, value, &data, &task->len))
+            return "Every task should have an input buffer.";
+        task->input = data;
+
+        if (!get_params(env, item, &task->params))
+            return "Invalid algorithm parameters.";
+
+        task->output = work->hashes + i * 32;
+        total += task->len;
+    }
+
+    if (!(work->inputs = (char*) malloc(total ? total : 1)))
+        return "Could not allocate the batch.";
+    for (i = 0; i < count; i++) {
+        memcpy(work->inputs + offset, work->items[i].input, work->items[i].len);
+        work->items[i].input = work->inputs + offset;
+        offset += work->items[i].len;
+    }
+    return NULL;
+}
+
+/*
+ * Leaves out the tasks whose input the filter has seen. The others keep their
+ * output at their own position, so only the statuses need mapping back.
+ */
+static const char* filter_tasks(multihash_share_filter* filter, tasks_work* work) {
+    size_t i, k = 0;
+
+    if (!(work->duplicate = (uint8_t*) calloc(work->total ? work->total : 1, 1)))
+        return "Could not allocate the batch.";
+    for (i = 0; i < work->total; i++) {
+        multihash_task* task = &work->items[i];
+
+        if (multihash_share_filter_insert(filter, task->input, task->len) == 0) {
+            work->duplicate[i] = 1;
+            memset(task->output, 0, 32);
+            continue;
+        }
+        work->items[k++] = *task;
+    }
+    work->count = k;
+    return NULL;
+}
+
+/* { hashes, hashed: Uint8Array } with hashed[i] 0 where task i failed; with a filter also duplicates: [index] */
+static napi_value tasks_result(napi_env env, tasks_work* work) {
+    napi_value result, arraybuffer, hashed, duplicates, index;
+    void* status;
+    uint32_t repeated = 0;
+    size_t i, k = 0;
+
+    if (napi_create_arraybuffer(env, work->total, &status, &arraybuffer) != napi_ok ||
+        napi_create_typedarray(env, napi_uint8_array, work->total, arraybuffer, 0, &hashed) != napi_ok)
+        return NULL;
+
+    napi_create_array(env, &duplicates);
+    for (i = 0; i < work->total; i++) {
+        if (work->duplicate && work->duplicate[i]) {
+            ((uint8_t*) status)[i] = 0;
+            napi_create_uint32(env, i, &index);
+            napi_set_element(env, duplicates, repeated++, index);
+        } else {
+            ((uint8_t*) status)[i] = work->items[k++].status == MULTIHASH_OK;
+        }
+    }
+
+    napi_create_object(env, &result);
+    napi_set_named_property(env, result, "hashes", new_buffer(env, (const char*) work->hashes, work->total * 32));
+    napi_set_named_property(env, result, "hashed", hashed);
+    if (work->duplicate)
+        napi_set_named_property(env, result, "duplicates", duplicates);
+    return result;
+}
+
+/* on the last worker out of the batch */
+static void tasks_done(void* arg, int status) {
+    tasks_work* work = (tasks_work*) arg;
+    napi_threadsafe_function settle = work->settle;     /* work may be gone once it is queued */
+
+    work->rc = status;
+    /* closing: the environment is gone, nobody is left to settle */
+    if (napi_call_threadsafe_function(settle, work, napi_tsfn_blocking) != napi_ok)
+        tasks_work_free(work);
+    napi_release_threadsafe_function(settle, napi_tsfn_release);
+}
+
+static void tasks_settle(napi_env env, napi_value unused, void* context, void* data) {
+    tasks_work* work = (tasks_work*) data;
+    napi_value error = NULL, result = NULL, message;
+
+    /* the environment is going away */
+    if (!env) {
+        tasks_work_free(work);
+        return;
+    }
+
+    if (work->rc != MULTIHASH_OK) {
+        napi_create_string_utf8(env, scratchpad_error(work->rc), NAPI_AUTO_LENGTH, &message);
+        napi_create_error(env, NULL, message, &error);
+    } else {
+        result = tasks_result(env, work);
+    }
+
+    if (work->callback) {
+        napi_value callback, global, argv[2];
+        napi_get_reference_value(env, work->callback, &callback);
+        napi_get_global(env, &global);
+        if (error)
+            argv[0] = error;
+        else
+            napi_get_null(env, &argv[0]);
+        if (result)
+            argv[1] = result;
+        else
+            napi_get_undefined(env, &argv[1]);
+        napi_call_function(env, global, callback, 2, argv, NULL);
+        napi_delete_reference(env, work->callback);
+    } else if (error) {
+        napi_reject_deferred(env, work->deferred, error);
+    } else {
+        napi_resolve_deferred(env, work->deferred, result);
+    }
+
+    napi_delete_reference(env, work->tasks);
+    tasks_work_free(work);
+}
+
+/*
+ * hashTasks(tasks[, options][, callback]): hashes a batch of mixed algorithms
+ * off the main thread; callback(err, { hashes, hashed }), or a Promise of the
+ * result without a callback. With options.filter (a shareFilter, keyed on the input bytes as
+ * in hashBatch) tasks the filter has seen are not hashed and are listed in the
+ * result's duplicates.
+ */
+napi_value hashTasks(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3];
+    napi_value promise = NULL, name;
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    multihash_scheduler* scheduler;
+    napi_valuetype type = napi_undefined;
+    multihash_share_filter* filter = NULL;
+    size_t callback_arg = 1;
+    const char* error;
+    int rc;
+
+    if (argc < 1)
+        return except(env, "You must provide the tasks.");
+
+    if (argc >= 2)
+        napi_typeof(env, args[1], &type);
+    if (type == napi_object) {
+        if (!get_filter_option(env, args[1], &filter))
+            return except(env, "options.filter should be a share filter.");
+        callback_arg = 2;
+        type = napi_undefined;
+        if (argc >= 3)
+            napi_typeof(env, args[2], &type);
+    }
+
+    if (!(scheduler = get_scheduler(env)))
+        return except(env, "Could not start the scheduler.");
+
+    tasks_work* work = (tasks_work*) calloc(1, sizeof(tasks_work));
+
+    if (!work)
+        return except(env, "Could not allocate the batch.");
+
+    if ((error = get_tasks(env, args[0], work)) || (filter && (error = filter_tasks(filter, work)))) {
+        tasks_work_free(work);
+        return except(env, error);
+    }
+
+    work->scheduler = scheduler;
+
+    napi_create_string_utf8(env, "multihashing:tasks", NAPI_AUTO_LENGTH, &name);
+    if (napi_create_threadsafe_function(env, NULL, NULL, name, 0, 1, NULL, NULL, NULL,
+                                        tasks_settle, &work->settle) != napi_ok) {
+        tasks_work_free(work);
+        return except(env, "Could not allocate the batch.");
+    }
+
+    if ((rc = multihash_scheduler_submit(work->scheduler, work->items, work->count, tasks_done, work)) != MULTIHASH_OK) {
+        napi_release_threadsafe_function(work->settle, napi_tsfn_release);
+        tasks_work_free(work);
+        return except(env, scratchpad_error(rc));
+    }
+
+    if (type == napi_function)
+        napi_create_reference(env, args[callback_arg], 1, &work->callback);
+    else
+        napi_create_promise(env, &work->deferred, &promise);
+    napi_create_reference(env, args[0], 1, &work->tasks);
+
+    return promise;
+}
+
+/*
+ * Ring workers hash shares out of a SharedArrayBuffer laid out as described in
+ * multihash.h; ring.js is the JS end. The handle keeps the view alive for as
+ * long as its threads may touch the memory.
+ */
+struct ring_handle {
+    multihash_ring_workers* workers;
+    napi_ref view;
+    napi_ref filter;
+};
+
+/* at environment teardown, stops the threads before finalizers free the filter */
+static void ring_cleanup(void* arg) {
+    ring_handle* handle = (ring_handle*) arg;
+    multihash_ring_stop(handle->workers);
+    handle->workers = NULL;
+}
+
+static void ring_shutdown(napi_env env, ring_handle* handle) {
+    if (handle->workers) {
+        napi_remove_env_cleanup_hook(env, ring_cleanup, handle);
+        ring_cleanup(handle);
+    }
+    if (handle->view) {
+        napi_delete_reference(env, handle->view);
+        handle->view = NULL;
+    }
+    if (handle->filter) {
+        napi_delete_reference(env, handle->filter);
+        handle->filter = NULL;
+    }
+}
+
+static const napi_type_tag ring_type_tag = { 0x6d68736872696e67ULL, 0xc73a1d05e96b284fULL };
+
+static void ring_finalize(napi_env env, void* data, void* hint) {
+    ring_handle* handle = (ring_handle*) data;
+    ring_shutdown(env, handle);
+    free(handle);
+}
+
+static ring_handle* unwrap_ring(napi_env env, napi_value value) {
+    return (ring_handle*) unwrap_tagged(env, value, &ring_type_tag);
+}
+
+/* ringSize(slots): bytes of SharedArrayBuffer a ring with this many slots needs */
+napi_value ringSize(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    double slots;
+
+    if (argc < 1 || !get_number(env, args[0], &slots) || slots < 2)
+        return except(env, "You must provide the number of slots.");
+
+    napi_value value;
+    napi_create_double(env, multihash_ring_size(slots), &value);
+    return value;
+}
+
+/* initRing(view, slots): lays out empty rings over a Uint8Array of a SharedArrayBuffer */
+napi_value initRing(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    char * data;
+    size_t length;
+    double slots;
+
+    if (argc < 2 || !get_buffer(env, args[0], &data, &length))
+        return except(env, "You must provide a shared buffer view and the number of slots.");
+
+    if (!get_number(env, args[1], &slots))
+        return NULL;
+
+    if (multihash_ring_init(data, length, slots) != MULTIHASH_OK)
+        return except(env, "Slots should be a power of two and the buffer at least ringSize(slots) bytes.");
+
+    return NULL;
+}
+
+/* new RingWorkers(view, threads[, filter]), only reachable through ringWorkers() */
+static napi_value ring_constructor(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3];
+    napi_value self;
+    napi_get_cb_info(env, info, &argc, args, &self, NULL);
+
+    char * data;
+    size_t length;
+    double threads;
+    multihash_share_filter* filter = NULL;
+    napi_valuetype type = napi_undefined;
+
+    if (argc < 2 || !get_buffer(env, args[0], &data, &length))
+        return except(env, "You must provide a ring buffer view and the number of threads.");
+
+    if (!get_number(env, args[1], &threads) || threads < 1 || threads > 1024)
+        return except(env, "Threads should be between 1 and 1024.");
+
+    if (argc >= 3)
+        napi_typeof(env, args[2], &type);
+    if (type != napi_undefined && type != napi_null && !(filter = unwrap_filter(env, args[2])))
+        return except(env, "options.filter should be a share filter.");
+
+    if (length < MULTIHASH_RING_HEADER_SIZE)
+        return except(env, "Buffer is not an initialized ring.");
+
+    ring_handle* handle = (ring_handle*) calloc(1, sizeof(ring_handle));
+
+    if (!handle)
+        return except(env, "Could not start ring workers.");
+
+    if (!(handle->workers = multihash_ring_start_filtered(data, threads, filter))) {
+        free(handle);
+        return except(env, "Buffer is not an initialized ring, or threads could not be started.");
+    }
+
+    napi_add_env_cleanup_hook(env, ring_cleanup, handle);
+    napi_create_reference(env, args[0], 1, &handle->view);
+    /* the workers insert into the filter until they stop */
+    if (filter)
+        napi_create_reference(env, args[2], 1, &handle->filter);
+
+    if (napi_type_tag_object(env, self, &ring_type_tag) != napi_ok ||
+        napi_wrap(env, self, handle, ring_finalize, NULL, NULL) != napi_ok) {
+        ring_shutdown(env, handle);
+        free(handle);
+        return except(env, "Could not start ring workers.");
+    }
+
+    return self;
+}
+
+/* workers.wake(): look at the submission ring now instead of after the idle sleep */
+static napi_value ring_wake(napi_env env, napi_callback_info info) {
+    napi_value self;
+    napi_get_cb_info(env, info, NULL, NULL, &self, NULL);
+
+    ring_handle* handle = unwrap_ring(env, self);
+
+    if (!handle)
+        return except(env, "Must be called on ring workers.");
+
+    if (handle->workers)
+        multihash_ring_wake(handle->workers);
+    return NULL;
+}
+
+/* workers.stop(): joins the threads; submissions still queued stay in the ring */
+static napi_value ring_stop(napi_env env, napi_callback_info info) {
+    napi_value self;
+    napi_get_cb_info(env, info, NULL, NULL, &self, NULL);
+
+    ring_handle* handle = unwrap_ring(env, self);
+
+    if (!handle)
+        return except(env, "Must be called on ring workers.");
+
+    ring_shutdown(env, handle);
+    return NULL;
+}
+
+/*
+ * ringWorkers(view, threads[, filter]) starts native threads consuming the ring
+ * in view; with a shareFilter, inputs it has seen complete with status -3.
+ */
+napi_value ringWorkers(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    napi_value constructor, result;
+
+    if (napi_get_reference_value(env, get_instance(env)->ring_constructor, &constructor) != napi_ok)
+        return NULL;
+
+    if (napi_new_instance(env, constructor, argc, args, &result) != napi_ok)
+        return NULL;
+
+    return result;
+}
+
+/*
+ * setMemoryBudget(bytes): process-wide cap on the scratchpads of scrypt, scryptn,
+ * scryptjane and cryptonight, shared by every worker_thread. 0 removes the cap.
+ * Calls whose scratchpad does not fit wait their turn, except the synchronous exports
+ * on the main thread, which throw at once; larger than the cap, they throw.
+ */
+napi_value setMemoryBudget(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    double bytes;
+
+    if (argc < 1 || !get_number(env, args[0], &bytes) || bytes < 0)
+        return except(env, "You must provide the budget in bytes.");
+
+    multihash_memory_set_budget(bytes);
+    return NULL;
+}
+
+static void set_stat(napi_env env, napi_value object, const char* name, uint64_t value) {
+    napi_value number;
+    napi_create_double(env, (double) value, &number);
+    napi_set_named_property(env, object, name, number);
+}
+
+/* memoryUsage({ resetPeak }) -> { budget, inUse, peak, waiting, admitted, queued, rejected } */
+napi_value memoryUsage(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    multihash_memory_stats stats;
+    multihash_memory_get_stats(&stats);
+
+    if (argc >= 1) {
+        bool has = false, reset = false;
+        napi_valuetype type;
+        napi_value value;
+
+        napi_typeof(env, args[0], &type);
+        if (type == napi_object && napi_has_named_property(env, args[0], "resetPeak", &has) == napi_ok && has) {
+            napi_get_named_property(env, args[0], "resetPeak", &value);
+            napi_coerce_to_bool(env, value, &value);
+            napi_get_value_bool(env, value, &reset);
+        }
+        if (reset)
+            multihash_memory_reset_peak();
+    }
+
+    napi_value result;
+    napi_create_object(env, &result);
+    set_stat(env, result, "budget", stats.budget);
+    set_stat(env, result, "inUse", stats.in_use);
+    set_stat(env, result, "peak", stats.peak);
+    set_stat(env, result, "waiting", stats.waiting);
+    set_stat(env, result, "admitted", stats.admitted);
+    set_stat(env, result, "queued", stats.queued);
+    set_stat(env, result, "rejected", stats.rejected);
+    return result;
+}
+
+/*
+ * memoryGovernor() / useMemoryGovernor(governor): every module built from this
+ * file carries its own copy of the budget; index.js points the family modules
+ * at the core module's so the budget stays process-wide.
+ */
+static const napi_type_tag governor_type_tag = { 0x6d6873686d656d67ULL, 0x3e81c5f20ad7b694ULL };
+
+napi_value memoryGovernor(napi_env env, napi_callback_info info) {
+    napi_value governor = new_tagged_external(env, multihash_memory_governor(), &governor_type_tag);
+
+    if (!governor)
+        return except(env, "Could not create the governor handle.");
+    return governor;
+}
+
+napi_value useMemoryGovernor(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    void* governor = argc >= 1 ? get_tagged_external(env, args[0], &governor_type_tag) : NULL;
+
+    if (!governor)
+        return except(env, "You must provide a governor from memoryGovernor().");
+
+    multihash_memory_use_governor(governor);
+    return NULL;
+}
+
+/*
+ * scheduler() / useScheduler(scheduler): hashTasks and submitBatch in every module
+ * queue on one pool, one thread per cpu, started by whichever needs it first.
+ * families.js points the other modules at the core module's.
+ */
+static const napi_type_tag scheduler_type_tag = { 0x6d68736873636864ULL, 0x17f9b24c6e0da385ULL };
+
+napi_value scheduler(napi_env env, napi_callback_info info) {
+    napi_value scheduler = new_tagged_external(env, get_instance(env)->scheduler_slot, &scheduler_type_tag);
+
+    if (!scheduler)
+        return except(env, "Could not create the scheduler handle.");
+    return scheduler;
+}
+
+napi_value useScheduler(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    multihashing_instance* instance = get_instance(env);
+    void* slot = argc >= 1 ? get_tagged_external(env, args[0], &scheduler_type_tag) : NULL;
+
+    if (!slot)
+        return except(env, "You must provide a scheduler from scheduler().");
+    if (instance->scheduler)
+        return except(env, "This module has started its own scheduler already.");
+
+    instance->scheduler_slot = (multihash_scheduler**) slot;
+    return NULL;
+}
+
+/*
+ * variants(algo) -> names of the kernel variants this cpu can run, fastest on
+ * paper first; [] for algorithms with one implementation.
+ * selectVariant(algo, name) pins one process-wide (null: back to the default),
+ * selectedVariant(algo) -> the name that runs now. Variants live in the module
+ * that carries the algorithm, so index.js routes these by algorithm.
+ */
+napi_value variants(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    int algo;
+
+    if (argc < 1 || !get_algo(env, args[0], &algo))
+        return except(env, "You must provide an algorithm.");
+
+    napi_value result;
+    uint32_t length = 0;
+    napi_create_array(env, &result);
+
+    for (int i = 0; i < multihash_variant_count(algo); i++) {
+        const char* name = multihash_variant_name(algo, i);
+        if (!name)
+            continue;
+        napi_value value;
+        napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH, &value);
+        napi_set_element(env, result, length++, value);
+    }
+    return result;
+}
+
+napi_value selectVariant(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    int algo, variant = -1;
+    napi_valuetype type = napi_null;
+
+    if (argc < 1 || !get_algo(env, args[0], &algo))
+        return except(env, "You must provide an algorithm.");
+
+    if (argc >= 2)
+        napi_typeof(env, args[1], &type);
+
+    if (type == napi_string) {
+        char name[32];
+        size_t length;
+        napi_get_value_string_utf8(env, args[1], name, sizeof(name), &length);
+        for (variant = multihash_variant_count(algo) - 1; variant >= 0; variant--) {
+            const char* candidate = multihash_variant_name(algo, variant);
+            if (candidate && strcmp(candidate, name) == 0)
+                break;
+        }
+        if (variant < 0)
+            return except(env, "Unknown variant, or not supported by this cpu.");
+    } else if (type != napi_null && type != napi_undefined) {
+        return except(env, "Variant should be a name or null.");
+    }
+
+    if (multihash_variant_select(algo, variant) != MULTIHASH_OK)
+        return except(env, "This algorithm has no variants in this module.");
+    return NULL;
+}
+
+napi_value selectedVariant(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    int algo;
+
+    if (argc < 1 || !get_algo(env, args[0], &algo))
+        return except(env, "You must provide an algorithm.");
+
+    napi_value result;
+    int variant = multihash_variant_selected(algo);
+
+    if (variant < 0)
+        napi_get_null(env, &result);
+    else
+        napi_create_string_utf8(env, multihash_variant_name(algo, variant), NAPI_AUTO_LENGTH, &result);
+    return result;
+}
+
+/* isaLevel() -> { cpu, built }: the x86-64 level the cpu runs and the one this module was compiled for */
+napi_value isaLevel(napi_env env, napi_callback_info info) {
+    napi_value result, value;
+
+    napi_create_object(env, &result);
+    napi_create_int32(env, multihash_isa_level(), &value);
+    napi_set_named_property(env, result, "cpu", value);
+    napi_create_int32(env, multihash_isa_built(), &value);
+    napi_set_named_property(env, result, "built", value);
+    return result;
+}
+
+/*
+ * crossCheck({ rate, autoDisable }): recompute about one in rate fast-path hashes
+ * with the reference code on a background thread (0 or no rate turns it off).
+ * With autoDisable a mismatch switches that algorithm to the reference code.
+ */
+napi_value crossCheck(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    double rate = 0;
+    bool has = false, disable = false;
+    napi_valuetype type = napi_undefined;
+
+    if (argc >= 1)
+        napi_typeof(env, args[0], &type);
+    if (type != napi_object)
+        return except(env, "You must provide the options { rate, autoDisable }.");
+
+    if (!get_uint_property(env, args[0], "rate", &rate) || rate > UINT32_MAX)
+        return except(env, "rate should be a non-negative number.");
+
+    if (napi_has_named_property(env, args[0], "autoDisable", &has) == napi_ok && has) {
+        napi_value value;
+        napi_get_named_property(env, args[0], "autoDisable", &value);
+        napi_coerce_to_bool(env, value, &value);
+        napi_get_value_bool(env, value, &disable);
+    }
+
+    multihash_crosscheck_configure((uint32_t) rate, disable);
+    return NULL;
+}
+
+/* crossCheckStats(algo[, flush]) -> { sampled, checked, mismatches, dropped, fastPath } */
+napi_value crossCheckStats(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    int algo;
+    bool flush = false;
+
+    if (argc < 1 || !get_algo(env, args[0], &algo))
+        return except(env, "You must provide an algorithm.");
+
+    if (argc >= 2) {
+        napi_value value;
+        napi_coerce_to_bool(env, args[1], &value);
+        napi_get_value_bool(env, value, &flush);
+    }
+    if (flush)
+        multihash_crosscheck_flush();
+
+    multihash_crosscheck_stats stats;
+    multihash_crosscheck_get_stats(algo, &stats);
+
+    napi_value result, fast;
+    napi_create_object(env, &result);
+    set_stat(env, result, "sampled", stats.sampled);
+    set_stat(env, result, "checked", stats.checked);
+    set_stat(env, result, "mismatches", stats.mismatches);
+    set_stat(env, result, "dropped", stats.dropped);
+    napi_get_boolean(env, stats.fast_path != 0, &fast);
+    napi_set_named_property(env, result, "fastPath", fast);
+    return result;
+}
+
+/* setFastPath(algo, enabled): e.g. back on after a mismatch has been investigated */
+napi_value setFastPath(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    int algo;
+    bool enable = false;
+
+    if (argc < 2 || !get_algo(env, args[0], &algo))
+        return except(env, "You must provide an algorithm and true or false.");
+
+    napi_value value;
+    napi_coerce_to_bool(env, args[1], &value);
+    napi_get_value_bool(env, value, &enable);
+
+    multihash_fast_path_enable(algo, enable);
+    return NULL;
+}
+
+/* an algorithm, or 'chain' for all hash chains */
+static bool get_profile_algo(napi_env env, napi_value value, int* algo) {
+    napi_valuetype type;
+    char name[32];
+    size_t length;
+
+    napi_typeof(env, value, &type);
+    if (type == napi_string) {
+        napi_get_value_string_utf8(env, value, name, sizeof(name), &length);
+        if (strcmp(name, "chain") == 0) {
+            *algo = MULTIHASH_PERF_CHAIN;
+            return true;
+        }
+    }
+    return get_algo(env, value, algo);
+}
+
+/* profile(algo, enabled): count hardware events around every call for algo */
+napi_value profile(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    int algo;
+    bool enable = true;
+
+    if (argc < 1 || !get_profile_algo(env, args[0], &algo))
+        return except(env, "You must provide an algorithm or 'chain'.");
+
+    if (argc >= 2) {
+        napi_value value;
+        napi_coerce_to_bool(env, args[1], &value);
+        napi_get_value_bool(env, value, &enable);
+    }
+
+    multihash_perf_profile(algo, enable);
+    return NULL;
+}
+
+/*
+ * profileStats(algo) -> { calls, hashes, counted, cycles, instructions, l1dMisses,
+ * llcReferences, llcMisses, dtlbMisses, available, error }. Counters no thread
+ * could open are null; error is why the last one failed to open.
+ */
+napi_value profileStats(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    int algo;
+
+    if (argc < 1 || !get_profile_algo(env, args[0], &algo))
+        return except(env, "You must provide an algorithm or 'chain'.");
+
+    multihash_perf_stats stats;
+    multihash_perf_get_stats(algo, &stats);
+
+    unsigned available = multihash_perf_available();
+    int error = multihash_perf_error();
+    napi_value result, names, value;
+    uint32_t count = 0;
+
+    napi_create_object(env, &result);
+    set_stat(env, result, "calls", stats.calls);
+    set_stat(env, result, "hashes", stats.hashes);
+    set_stat(env, result, "counted", stats.counted);
+
+    napi_create_array(env, &names);
+    for (int i = 0; i < MULTIHASH_PERF_COUNTERS; i++) {
+        const char* name = multihash_perf_counter_name(i);
+        if (available & (1u << i)) {
+            set_stat(env, result, name, stats.counters[i]);
+            napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH, &value);
+            napi_set_element(env, names, count++, value);
+        } else {
+            napi_get_null(env, &value);
+            napi_set_named_property(env, result, name, value);
+        }
+    }
+    napi_set_named_property(env, result, "available", names);
+
+    if (error)
+        napi_create_string_utf8(env, strerror(error), NAPI_AUTO_LENGTH, &value);
+    else
+        napi_get_null(env, &value);
+    napi_set_named_property(env, result, "error", value);
+    return result;
+}
+
+napi_value profileReset(napi_env env, napi_callback_info info) {
+    multihash_perf_reset();
+    return NULL;
+}
+
+/*
+ * recordSlowHashes({ size, window }): keep the size slowest memory-hard calls of
+ * the last window ms (size 0 stops recording). slowHashes() -> those calls,
+ * slowest first: { algorithm, error, N, r, nfactor, height, start (ms since
+ * the epoch), time, phases: { alloc, init, main, final } (ms), minorFaults,
+ * majorFaults, voluntarySwitches, involuntarySwitches, cpu }.
+ */
+napi_value recordSlowHashes(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    double size = 32, window = 60000;
+
+    if ((argc >= 1 && (!get_uint_property(env, args[0], "size", &size) ||
+                       !get_uint_property(env, args[0], "window", &window))) ||
+        multihash_flight_configure(size, window) != MULTIHASH_OK)
+        return except(env, "size should be at most 1024 and window at least 1 ms.");
+    return NULL;
+}
+
+static void set_ms(napi_env env, napi_value object, const char* name, uint64_t ns) {
+    napi_value value;
+    napi_create_double(env, ns / 1e6, &value);
+    napi_set_named_property(env, object, name, value);
+}
+
+napi_value slowHashes(napi_env env, napi_callback_info info) {
+    static const char* const phases[MULTIHASH_PHASE_COUNT] = { "alloc", "init", "main", "final" };
+    multihash_flight_record* records =
+        (multihash_flight_record*) malloc(MULTIHASH_FLIGHT_MAX * sizeof(multihash_flight_record));
+    napi_value result, entry, times, value;
+
+    if (!records)
+        return except(env, "Could not allocate the records.");
+
+    size_t count = multihash_flight_dump(records, MULTIHASH_FLIGHT_MAX);
+
+    napi_create_array_with_length(env, count, &result);
+    for (size_t i = 0; i < count; i++) {
+        const multihash_flight_record* record = &records[i];
+
+        napi_create_object(env, &entry);
+        napi_create_string_utf8(env, multihash_algo_name(record->algo), NAPI_AUTO_LENGTH, &value);
+        napi_set_named_property(env, entry, "algorithm", value);
+        if (record->status != MULTIHASH_OK)
+            napi_create_string_utf8(env, scratchpad_error(record->status), NAPI_AUTO_LENGTH, &value);
+        else
+            napi_get_null(env, &value);
+        napi_set_named_property(env, entry, "error", value);
+        set_stat(env, entry, "N", record->N);
+        set_stat(env, entry, "r", record->r);
+        set_stat(env, entry, "nfactor", record->nfactor);
+        set_stat(env, entry, "height", record->height);
+        napi_create_double(env, record->start_ns / 1e6, &value);
+        napi_set_named_property(env, entry, "start", value);
+        set_ms(env, entry, "time", record->total_ns);
+
+        napi_create_object(env, &times);
+        for (int phase = 0; phase < MULTIHASH_PHASE_COUNT; phase++)
+            set_ms(env, times, phases[phase], record->phase_ns[phase]);
+        napi_set_named_property(env, entry, "phases", times);
+
+        set_stat(env, entry, "minorFaults", record->minor_faults);
+        set_stat(env, entry, "majorFaults", record->major_faults);
+        set_stat(env, entry, "voluntarySwitches", record->voluntary_switches);
+        set_stat(env, entry, "involuntarySwitches", record->involuntary_switches);
+        napi_create_int32(env, record->cpu, &value);
+        napi_set_named_property(env, entry, "cpu", value);
+
+        napi_set_element(env, result, i, entry);
+    }
+
+    free(records);
+    return result;
+}
+
+napi_value clearSlowHashes(napi_env env, napi_callback_info info) {
+    multihash_flight_reset();
+    return NULL;
+}
+
+static const napi_type_tag recorder_type_tag = { 0x6d68736866726563ULL, 0xa46d0e39b1c2f857ULL };
+
+/* flightRecorder() / useFlightRecorder(recorder): one table per process, like memoryGovernor */
+napi_value flightRecorder(napi_env env, napi_callback_info info) {
+    napi_value recorder = new_tagged_external(env, multihash_flight_recorder(), &recorder_type_tag);
+
+    if (!recorder)
+        return except(env, "Could not create the recorder handle.");
+    return recorder;
+}
+
+napi_value useFlightRecorder(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+
+    void* recorder = argc >= 1 ? get_tagged_external(env, args[0], &recorder_type_tag) : NULL;
+
+    if (!recorder)
+        return except(env, "You must provide a recorder from flightRecorder().");
+
+    multihash_flight_use_recorder(recorder);
+    return NULL;
+}
+
+#define EXPORT_FUNCTION(name) { #name, NULL, name, NULL, NULL, NULL, napi_enumerable, NULL }
+
+/*
+ * NAPI_MODULE_INIT registers a context-aware module: this runs once per
+ * environment (main thread or worker_thread) that requires the addon.
+ */
+NAPI_MODULE_INIT() {
+    multihashing_instance* instance = (multihashing_instance*) calloc(1, sizeof(multihashing_instance));
+
+    if (instance)
+        instance->scheduler_slot = &instance->scheduler;
+    if (instance && !(instance->ctx = multihash_ctx_new())) {
+        free(instance);
+        instance = NULL;
+    }
+
+    if (!instance || napi_set_instance_data(env, instance, instance_finalize, NULL) != napi_ok) {
+        if (instance)
+            multihash_ctx_free(instance->ctx);
+        free(instance);
+        return except(env, "Could not initialize multihashing instance.");
+    }
+
+    /* the synchronous exports hash on the main thread's context: never park the event loop on the budget */
+    uv_loop_t* loop = NULL;
+    if (napi_get_uv_event_loop(env, &loop) == napi_ok && loop == uv_default_loop())
+        multihash_ctx_set_wait(instance->ctx, 0);
+
+#ifdef MULTIHASHING_SPH
+    napi_property_descriptor chain_methods[] = {
+        { "hash", NULL, chain_hash, NULL, NULL, NULL, napi_default, NULL },
+        { "hashBatch", NULL, chain_hash_batch, NULL, NULL, NULL, napi_default, NULL },
+    };
+    napi_value chain_class;
+
+    napi_define_class(env, "HashChain", NAPI_AUTO_LENGTH, chain_constructor, NULL,
+                      sizeof(chain_methods) / sizeof(chain_methods[0]), chain_methods, &chain_class);
+    napi_create_reference(env, chain_class, 1, &instance->chain_constructor);
+#endif
+
+    napi_property_descriptor filter_methods[] = {
+        { "check", NULL, filter_check, NULL, NULL, NULL, napi_default, NULL },
+        { "has", NULL, filter_has, NULL, NULL, NULL, napi_default, NULL },
+        { "clear", NULL, filter_clear, NULL, NULL, NULL, napi_default, NULL },
+        { "size", NULL, NULL, filter_size, NULL, NULL, napi_default, NULL },
+    };
+    napi_value filter_class;
+
+    napi_define_class(env, "ShareFilter", NAPI_AUTO_LENGTH, filter_constructor, NULL,
+                      sizeof(filter_methods) / sizeof(filter_methods[0]), filter_methods, &filter_class);
+    napi_create_reference(env, filter_class, 1, &instance->filter_constructor);
+
+    napi_property_descriptor ring_methods[] = {
+        { "wake", NULL, ring_wake, NULL, NULL, NULL, napi_default, NULL },
+        { "stop", NULL, ring_stop, NULL, NULL, NULL, napi_default, NULL },
+    };
+    napi_value ring_class;
+
+    napi_define_class(env, "RingWorkers", NAPI_AUTO_LENGTH, ring_constructor, NULL,
+                      sizeof(ring_methods) / sizeof(ring_methods[0]), ring_methods, &ring_class);
+    napi_create_reference(env, ring_class, 1, &instance->ring_constructor);
+
+    napi_property_descriptor job_methods[] = {
+        { "hash", NULL, job_hash, NULL, NULL, NULL, napi_default, NULL },
+        { "submit", NULL, job_submit, NULL, NULL, NULL, napi_default, NULL },
+        { "submitBatch", NULL, job_submit_batch, NULL, NULL, NULL, napi_default, NULL },
+    };
+    napi_value job_class;
+
+    napi_define_class(env, "StratumJob", NAPI_AUTO_LENGTH, job_constructor, NULL,
+                      sizeof(job_methods) / sizeof(job_methods[0]), job_methods, &job_class);
+    napi_create_reference(env, job_class, 1, &instance->job_constructor);
+
+    napi_property_descriptor desc[] = {
+#ifdef MULTIHASHING_SPH
+        EXPORT_FUNCTION(quark),
+        EXPORT_FUNCTION(x11),
+        EXPORT_FUNCTION(keccak),
+        EXPORT_FUNCTION(skein),
+        EXPORT_FUNCTION(groestl),
+        EXPORT_FUNCTION(groestlmyriad),
+        EXPORT_FUNCTION(blake),
+        EXPORT_FUNCTION(fugue),
+        EXPORT_FUNCTION(qubit),
+        EXPORT_FUNCTION(hefty1),
+        EXPORT_FUNCTION(shavite3),
+        EXPORT_FUNCTION(x13),
+        EXPORT_FUNCTION(nist5),
+        EXPORT_FUNCTION(x15),
+        EXPORT_FUNCTION(fresh),
+        EXPORT_FUNCTION(sophia),
+        EXPORT_FUNCTION(chain),
+        EXPORT_FUNCTION(keccakInto),
+        EXPORT_FUNCTION(blakeInto),
+        EXPORT_FUNCTION(skeinInto),
+        EXPORT_FUNCTION(groestlInto),
+#endif
+#ifdef MULTIHASHING_SCRYPT
+        EXPORT_FUNCTION(scrypt),
+        EXPORT_FUNCTION(scryptn),
+        EXPORT_FUNCTION(scryptjane),
+#endif
+#ifdef MULTIHASHING_CRYPTONOTE
+        EXPORT_FUNCTION(cryptonight),
+        EXPORT_FUNCTION(boolberry),
+        EXPORT_FUNCTION(cryptonightFastInto),
+#endif
+#ifdef MULTIHASHING_MISC
+        EXPORT_FUNCTION(bcrypt),
+        EXPORT_FUNCTION(sha1),
+#endif
+        EXPORT_FUNCTION(hashToDifficulty),
+        EXPORT_FUNCTION(hashToDifficultyBatch),
+        EXPORT_FUNCTION(meetsTarget),
+        EXPORT_FUNCTION(meetsTargetBatch),
+        EXPORT_FUNCTION(shareFilter),
+        EXPORT_FUNCTION(hashBatch),
+        EXPORT_FUNCTION(stratumJob),
+        EXPORT_FUNCTION(hashTasks),
+        EXPORT_FUNCTION(setMemoryBudget),
+        EXPORT_FUNCTION(memoryUsage),
+        EXPORT_FUNCTION(memoryGovernor),
+        EXPORT_FUNCTION(useMemoryGovernor),
+        EXPORT_FUNCTION(scheduler),
+        EXPORT_FUNCTION(useScheduler),
+        EXPORT_FUNCTION(ringSize),
+        EXPORT_FUNCTION(initRing),
+        EXPORT_FUNCTION(ringWorkers),
+        EXPORT_FUNCTION(variants),
+        EXPORT_FUNCTION(selectVariant),
+        EXPORT_FUNCTION(selectedVariant),
+        EXPORT_FUNCTION(isaLevel),
+        EXPORT_FUNCTION(crossCheck),
+        EXPORT_FUNCTION(crossCheckStats),
+        EXPORT_FUNCTION(setFastPath),
+        EXPORT_FUNCTION(profile),
+        EXPORT_FUNCTION(profileStats),
+        EXPORT_FUNCTION(profileReset),
+        EXPORT_FUNCTION(recordSlowHashes),
+        EXPORT_FUNCTION(slowHashes),
+        EXPORT_FUNCTION(clearSlowHashes),
+        EXPORT_FUNCTION(flightRecorder),
+        EXPORT_FUNCTION(useFlightRecorder),
+    };
+
+    napi_define_properties(env, exports, sizeof(desc) / sizeof(desc[0]), desc);
+
+    napi_value algorithms;
+    napi_create_array_with_length(env, MULTIHASH_ALGO_COUNT, &algorithms);
+    for (uint32_t i = 0; i < MULTIHASH_ALGO_COUNT; i++) {
+        napi_value name;
+        napi_create_string_utf8(env, multihash_algo_name(i), NAPI_AUTO_LENGTH, &name);
+        napi_set_element(env, algorithms, i, name);
+    }
+    napi_set_named_property(env, exports, "algorithms", algorithms);
+
+    return exports;
+}
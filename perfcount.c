@@ -0,0 +1,295 @@
+#include "multihash.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Per-algorithm hardware counters (see multihash_perf_profile). Each thread
+ * that makes a profiled call opens one perf event group on itself, counting
+ * user space only, and keeps it until it exits. A profiled call costs two
+ * read()s of that group; calls for algorithms nobody profiles only test a
+ * byte in multihash_perf_selected.
+ */
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define HAVE_PERF_EVENTS 1
+#endif
+
+/* a snapshot as multihash_perf_begin takes it: time enabled, time running, then one value per counter */
+#define SNAPSHOT_ENABLED 0
+#define SNAPSHOT_RUNNING 1
+#define SNAPSHOT_VALUES  2
+
+unsigned char multihash_perf_selected[MULTIHASH_PERF_CHAIN + 1];
+
+static uint64_t calls[MULTIHASH_PERF_CHAIN + 1];
+static uint64_t hashes[MULTIHASH_PERF_CHAIN + 1];
+static uint64_t counted[MULTIHASH_PERF_CHAIN + 1];
+static uint64_t totals[MULTIHASH_PERF_CHAIN + 1][MULTIHASH_PERF_COUNTERS];
+
+static unsigned available;
+static int last_error;
+
+static const char* const counter_names[MULTIHASH_PERF_COUNTERS] = {
+    "cycles", "instructions", "l1dMisses", "llcReferences", "llcMisses", "dtlbMisses"
+};
+
+const char* multihash_perf_counter_name(int counter)
+{
+    return counter >= 0 && counter < MULTIHASH_PERF_COUNTERS ? counter_names[counter] : NULL;
+}
+
+int multihash_perf_profile(int algo, int enable)
+{
+    if (algo < 0 || algo > MULTIHASH_PERF_CHAIN)
+        return MULTIHASH_EINVAL;
+    __atomic_store_n(&multihash_perf_selected[algo], enable != 0, __ATOMIC_RELAXED);
+    return MULTIHASH_OK;
+}
+
+int multihash_perf_profiling(int algo)
+{
+    return algo >= 0 && algo <= MULTIHASH_PERF_CHAIN &&
+           __atomic_load_n(&multihash_perf_selected[algo], __ATOMIC_RELAXED);
+}
+
+unsigned multihash_perf_available(void)
+{
+    return __atomic_load_n(&available, __ATOMIC_RELAXED);
+}
+
+int multihash_perf_error(void)
+{
+    return __atomic_load_n(&last_error, __ATOMIC_RELAXED);
+}
+
+void multihash_perf_get_stats(int algo, multihash_perf_stats* stats)
+{
+    int i;
+
+    memset(stats, 0, sizeof(*stats));
+    if (algo < 0 || algo > MULTIHASH_PERF_CHAIN)
+        return;
+    stats->calls = __atomic_load_n(&calls[algo], __ATOMIC_RELAXED);
+    stats->hashes = __atomic_load_n(&hashes[algo], __ATOMIC_RELAXED);
+    stats->counted = __atomic_load_n(&counted[algo], __ATOMIC_RELAXED);
+    for (i = 0; i < MULTIHASH_PERF_COUNTERS; i++)
+        stats->counters[i] = __atomic_load_n(&totals[algo][i], __ATOMIC_RELAXED);
+}
+
+void multihash_perf_reset(void)
+{
+    int algo, i;
+
+    for (algo = 0; algo <= MULTIHASH_PERF_CHAIN; algo++) {
+        __atomic_store_n(&calls[algo], 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&hashes[algo], 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&counted[algo], 0, __ATOMIC_RELAXED);
+        for (i = 0; i < MULTIHASH_PERF_COUNTERS; i++)
+            __atomic_store_n(&totals[algo][i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+#ifdef HAVE_PERF_EVENTS
+
+typedef struct perf_thread {
+    int leader;                              /* -1: no counter opened */
+    int count;                               /* events in the group */
+    int fds[MULTIHASH_PERF_COUNTERS];
+    int slot[MULTIHASH_PERF_COUNTERS];       /* position in a group read, -1 when not open */
+} perf_thread;
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} events[MULTIHASH_PERF_COUNTERS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+};
+
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+static __thread perf_thread* self;
+static __thread int depth;
+
+static void close_counters(void* arg)
+{
+    perf_thread* t = (perf_thread*) arg;
+    int i;
+
+    for (i = 0; i < MULTIHASH_PERF_COUNTERS; i++)
+        if (t->slot[i] >= 0)
+            close(t->fds[i]);
+    free(t);
+}
+
+static void make_key(void)
+{
+    pthread_key_create(&key, close_counters);
+}
+
+static int read_group(perf_thread* t, uint64_t* buffer)
+{
+    size_t size = (3 + t->count) * sizeof(uint64_t);
+    return read(t->leader, buffer, size) == (ssize_t) size;
+}
+
+/* a group larger than the pmu can hold at once is never scheduled */
+static int group_runs(perf_thread* t)
+{
+    uint64_t buffer[3 + MULTIHASH_PERF_COUNTERS];
+    volatile unsigned spin = 0;
+    unsigned i;
+
+    for (i = 0; i < 100000; i++)
+        spin += i;
+    return read_group(t, buffer) && buffer[2] > 0;
+}
+
+static perf_thread* open_counters(void)
+{
+    perf_thread* t = (perf_thread*) malloc(sizeof(perf_thread));
+    struct perf_event_attr attr;
+    int i;
+
+    if (!t)
+        return NULL;
+    t->leader = -1;
+    t->count = 0;
+
+    for (i = 0; i < MULTIHASH_PERF_COUNTERS; i++) {
+        t->slot[i] = -1;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        t->fds[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, t->leader, PERF_FLAG_FD_CLOEXEC);
+        if (t->fds[i] < 0) {
+            __atomic_store_n(&last_error, errno, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (t->leader < 0)
+            t->leader = t->fds[i];
+        t->slot[i] = t->count++;
+    }
+
+    /* drop members from the end until the pmu fits the group */
+    for (i = MULTIHASH_PERF_COUNTERS - 1; i >= 0 && t->count > 1 && !group_runs(t); i--) {
+        if (t->slot[i] < 0 || t->fds[i] == t->leader)
+            continue;
+        close(t->fds[i]);
+        t->slot[i] = -1;
+        t->count--;
+    }
+    if (t->leader >= 0 && !group_runs(t)) {
+        close(t->leader);
+        for (i = 0; i < MULTIHASH_PERF_COUNTERS; i++)
+            t->slot[i] = -1;
+        t->leader = -1;
+        t->count = 0;
+    }
+
+    for (i = 0; i < MULTIHASH_PERF_COUNTERS; i++)
+        if (t->slot[i] >= 0)
+            __atomic_fetch_or(&available, 1u << i, __ATOMIC_RELAXED);
+
+    pthread_once(&key_once, make_key);
+    pthread_setspecific(key, t);
+    return t;
+}
+
+static int snapshot(perf_thread* t, uint64_t* snap)
+{
+    uint64_t buffer[3 + MULTIHASH_PERF_COUNTERS];
+    int i;
+
+    if (t->leader < 0 || !read_group(t, buffer))
+        return 0;
+    snap[SNAPSHOT_ENABLED] = buffer[1];
+    snap[SNAPSHOT_RUNNING] = buffer[2];
+    for (i = 0; i < MULTIHASH_PERF_COUNTERS; i++)
+        snap[SNAPSHOT_VALUES + i] = t->slot[i] >= 0 ? buffer[3 + t->slot[i]] : 0;
+    return 1;
+}
+
+#else
+
+typedef int perf_thread;
+
+static __thread perf_thread* self;
+static __thread int depth;
+
+static perf_thread* open_counters(void)
+{
+    __atomic_store_n(&last_error, ENOSYS, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static int snapshot(perf_thread* t, uint64_t* snap)
+{
+    (void) t;
+    (void) snap;
+    return 0;
+}
+
+#endif
+
+/*
+ * multihash.c and hashchain.c bracket a profiled call with these, passing
+ * MULTIHASH_PERF_COUNTERS + 2 words of snapshot. begin returns 0 for calls
+ * nested in one already being counted (a batch hashing record by record);
+ * end must only follow a begin that returned 1.
+ */
+int multihash_perf_begin(uint64_t* snap)
+{
+    if (depth++)
+        return 0;
+    if (!self)
+        self = open_counters();
+    if (!self || !snapshot(self, snap))
+        snap[SNAPSHOT_RUNNING] = UINT64_MAX;
+    return 1;
+}
+
+void multihash_perf_end(int algo, uint64_t count, const uint64_t* snap)
+{
+    uint64_t now[SNAPSHOT_VALUES + MULTIHASH_PERF_COUNTERS];
+    uint64_t enabled, running, value;
+    int i;
+
+    depth = 0;
+    __sync_fetch_and_add(&calls[algo], 1);
+    __sync_fetch_and_add(&hashes[algo], count);
+
+    if (snap[SNAPSHOT_RUNNING] == UINT64_MAX || !snapshot(self, now))
+        return;
+    enabled = now[SNAPSHOT_ENABLED] - snap[SNAPSHOT_ENABLED];
+    running = now[SNAPSHOT_RUNNING] - snap[SNAPSHOT_RUNNING];
+    if (!running)
+        return;
+
+    for (i = 0; i < MULTIHASH_PERF_COUNTERS; i++) {
+        value = now[SNAPSHOT_VALUES + i] - snap[SNAPSHOT_VALUES + i];
+        if (running < enabled)
+            value = (uint64_t) ((double) value * enabled / running);
+        if (value)
+            __sync_fetch_and_add(&totals[algo][i], value);
+    }
+    __sync_fetch_and_add(&counted[algo], 1);
+}
@@ -0,0 +1,96 @@
+#ifndef MULTIHASH_PROBES_H
+#define MULTIHASH_PROBES_H
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+	USDT (statically defined tracing) probes, provider "multihash", in the format
+	<sys/sdt.h> emits, so bpftrace, perf, bcc and SystemTap attach to them without
+	the systemtap headers at build time:
+
+		bpftrace -e 'usdt:./build/Release/multihashing.node:multihash:hash__done
+		             { @us[arg0] = hist(arg3 / 1000); }'
+
+	A probe site is a single nop until a tracer attaches. Each probe also has a
+	semaphore the tracer increments while attached; arguments that cost something
+	to compute (timestamps) are only computed behind MULTIHASH_PROBE_ENABLED.
+
+	Every probe must be declared once per translation unit with
+	MULTIHASH_PROBE_DEFINE(name). Define MULTIHASH_NO_PROBES to compile them out.
+*/
+
+#if !defined(MULTIHASH_NO_PROBES) && defined(__GNUC__) && defined(__ELF__) && \
+    (defined(__x86_64__) || defined(__aarch64__))
+
+#define MULTIHASH_PROBE_DEFINE(name) \
+	static volatile unsigned short multihash_##name##_semaphore \
+		__attribute__((used, section(".probes")))
+
+#define MULTIHASH_PROBE_ENABLED(name) __builtin_expect(multihash_##name##_semaphore != 0, 0)
+
+/* argument size as the tracers read it: negative for signed types */
+#define MULTIHASH_PROBE_SIZE(x) \
+	(((__typeof__((x) + 0)) -1 < 1) ? -(int) sizeof((x) + 0) : (int) sizeof((x) + 0))
+
+#define MULTIHASH_PROBE_NOTE(name, args) \
+	"990: nop\n" \
+	".pushsection .note.stapsdt,\"\",\"note\"\n" \
+	".balign 4\n" \
+	".4byte 992f-991f, 994f-993f, 3\n" \
+	"991: .asciz \"stapsdt\"\n" \
+	"992: .balign 4\n" \
+	"993: .8byte 990b\n" \
+	".8byte _.stapsdt.base\n" \
+	".8byte multihash_" #name "_semaphore\n" \
+	".asciz \"multihash\"\n" \
+	".asciz \"" #name "\"\n" \
+	".asciz \"" args "\"\n" \
+	"994: .balign 4\n" \
+	".popsection\n" \
+	".ifndef _.stapsdt.base\n" \
+	".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+	".weak _.stapsdt.base\n" \
+	".hidden _.stapsdt.base\n" \
+	"_.stapsdt.base: .space 1\n" \
+	".size _.stapsdt.base, 1\n" \
+	".popsection\n" \
+	".endif\n"
+
+#define MULTIHASH_PROBE2(name, x1, x2) \
+	__asm__ __volatile__(MULTIHASH_PROBE_NOTE(name, "%c[s1]@%[a1] %c[s2]@%[a2]") :: \
+		[s1] "n" (MULTIHASH_PROBE_SIZE(x1)), [a1] "nor" (x1), \
+		[s2] "n" (MULTIHASH_PROBE_SIZE(x2)), [a2] "nor" (x2))
+
+#define MULTIHASH_PROBE3(name, x1, x2, x3) \
+	__asm__ __volatile__(MULTIHASH_PROBE_NOTE(name, "%c[s1]@%[a1] %c[s2]@%[a2] %c[s3]@%[a3]") :: \
+		[s1] "n" (MULTIHASH_PROBE_SIZE(x1)), [a1] "nor" (x1), \
+		[s2] "n" (MULTIHASH_PROBE_SIZE(x2)), [a2] "nor" (x2), \
+		[s3] "n" (MULTIHASH_PROBE_SIZE(x3)), [a3] "nor" (x3))
+
+#define MULTIHASH_PROBE4(name, x1, x2, x3, x4) \
+	__asm__ __volatile__(MULTIHASH_PROBE_NOTE(name, "%c[s1]@%[a1] %c[s2]@%[a2] %c[s3]@%[a3] %c[s4]@%[a4]") :: \
+		[s1] "n" (MULTIHASH_PROBE_SIZE(x1)), [a1] "nor" (x1), \
+		[s2] "n" (MULTIHASH_PROBE_SIZE(x2)), [a2] "nor" (x2), \
+		[s3] "n" (MULTIHASH_PROBE_SIZE(x3)), [a3] "nor" (x3), \
+		[s4] "n" (MULTIHASH_PROBE_SIZE(x4)), [a4] "nor" (x4))
+
+#else
+
+#define MULTIHASH_PROBE_DEFINE(name) struct multihash_##name##_unused
+#define MULTIHASH_PROBE_ENABLED(name) 0
+#define MULTIHASH_PROBE2(name, x1, x2) do { } while (0)
+#define MULTIHASH_PROBE3(name, x1, x2, x3) do { } while (0)
+#define MULTIHASH_PROBE4(name, x1, x2, x3, x4) do { } while (0)
+
+#endif
+
+/* CLOCK_MONOTONIC, the clock bpftrace's nsecs and Node's process.hrtime use */
+static inline uint64_t multihash_probe_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+#endif
@@ -0,0 +1,396 @@
+#!/usr/bin/env node
+/*
+    Trace replay load test. Shares recorded from a pool (arrival time, algorithm,
+    header and parameters, one JSON object per line) are fed to the module at their
+    recorded pace, or sped up, through one of its entry points:
+
+        sync   hashBatch of one share on the main thread, as a stratum handler would
+        async  hashTasks of one share each, all in flight at once
+        batch  hashTasks of the shares that arrived within batchMs (or batchSize of them)
+
+    and the run reports sustained throughput, how many shares were waiting (due but
+    not yet hashed), event loop lag, and latency percentiles per algorithm. Latency
+    runs from a share's due time, so it includes the time it waited behind others.
+
+        multihashing-replay shares.jsonl --mode sync,batch --speed 1,10
+
+    A trace line:
+
+        {"t": 1532.5, "algorithm": "scrypt", "header": "<hex>", "N": 1024, "r": 1}
+
+    t is in milliseconds; N, r, nfactor and height are optional. Without a recorded
+    trace, --synthesize writes one with bursts and job changes.
+*/
+
+var fs = require('fs');
+var perfHooks = require('perf_hooks');
+
+var PERCENTILES = [50, 90, 99, 99.9];
+
+function now(){
+    return Number(process.hrtime.bigint()) / 1e6;
+}
+
+function params(share){
+    return {N: share.N || 0, r: share.r || 0, nfactor: share.nfactor || 0, height: share.height || 0};
+}
+
+/* shares sorted by arrival, t relative to the first one */
+function parse(text){
+    var shares = text.split('\n').filter(function(line){
+        return line.trim() !== '';
+    }).map(function(line, i){
+        var share = JSON.parse(line);
+        if (typeof share.t !== 'number' || typeof share.algorithm !== 'string' || typeof share.header !== 'string')
+            throw new Error('Trace line ' + (i + 1) + ' needs t, algorithm and header.');
+        share.header = Buffer.from(share.header, 'hex');
+        return share;
+    });
+
+    shares.sort(function(a, b){ return a.t - b.t; });
+    var first = shares.length ? shares[0].t : 0;
+    shares.forEach(function(share){ share.t -= first; });
+    return shares;
+}
+
+function load(trace){
+    if (Array.isArray(trace))
+        return trace;
+    return parse(fs.readFileSync(trace, 'utf8'));
+}
+
+/* a small seeded generator, so a synthetic trace can be written again */
+function random(seed){
+    var state = seed >>> 0 || 1;
+    return function(){
+        state ^= state << 13;
+        state ^= state >>> 17;
+        state ^= state << 5;
+        return (state >>> 0) / 4294967296;
+    };
+}
+
+/*
+    A synthetic trace: options.rate shares per second for options.duration ms, in
+    the proportions of options.mix ({algorithm: weight}); every options.burstEvery
+    ms the rate goes up burstFactor times for burstLength ms, and a new job (new
+    prevhash) starts every options.jobEvery ms.
+*/
+function synthesize(options){
+    options = options || {};
+
+    var duration = options.duration || 10000;
+    var rate = options.rate || 200;
+    var mix = options.mix || {x11: 0.8, scrypt: 0.15, cryptonight: 0.05};
+    var burstEvery = options.burstEvery || 2000;
+    var burstLength = options.burstLength || 200;
+    var burstFactor = options.burstFactor || 10;
+    var jobEvery = options.jobEvery || 5000;
+    var next = random(options.seed || 1);
+    var names = Object.keys(mix);
+    var total = names.reduce(function(sum, name){ return sum + mix[name]; }, 0);
+    var prevhash = Buffer.alloc(32);
+    var job = -1;
+    var shares = [];
+    var t = 0;
+
+    while (t < duration){
+        if (Math.floor(t / jobEvery) !== job){
+            job = Math.floor(t / jobEvery);
+            for (var i = 0; i < 32; i++)
+                prevhash[i] = next() * 256;
+        }
+
+        var pick = next() * total, algorithm = names[names.length - 1];
+        for (var j = 0; j < names.length; j++){
+            if ((pick -= mix[names[j]]) < 0){
+                algorithm = names[j];
+                break;
+            }
+        }
+
+        var header = Buffer.alloc(algorithm === 'cryptonight' ? 76 : 80);
+        prevhash.copy(header, 4);
+        header.writeUInt32LE(Math.floor(next() * 4294967296), header.length - 4);
+
+        var share = {t: t, algorithm: algorithm, header: header};
+        if (algorithm === 'scrypt'){
+            share.N = 1024;
+            share.r = 1;
+        }
+        shares.push(share);
+
+        var burst = t % burstEvery < burstLength ? burstFactor : 1;
+        t += -Math.log(1 - next()) * 1000 / (rate * burst);
+    }
+    return shares;
+}
+
+function save(shares, file){
+    fs.writeFileSync(file, shares.map(function(share){
+        var line = {t: share.t, algorithm: share.algorithm, header: share.header.toString('hex')};
+        ['N', 'r', 'nfactor', 'height'].forEach(function(name){
+            if (share[name])
+                line[name] = share[name];
+        });
+        return JSON.stringify(line);
+    }).join('\n') + '\n');
+}
+
+function percentiles(values){
+    var result = {};
+
+    values.sort(function(a, b){ return a - b; });
+    PERCENTILES.forEach(function(p){
+        result['p' + p] = values.length ? values[Math.min(values.length - 1, Math.floor(values.length * p / 100))] : 0;
+    });
+    result.max = values.length ? values[values.length - 1] : 0;
+    return result;
+}
+
+/*
+    Replays a trace (an array from parse or synthesize, or a file name) and resolves
+    with the report. options: mode ('sync', 'async' or 'batch'), speed (1; 10 replays
+    ten times faster than recorded), batchSize (256), batchMs (5), sampleMs (how
+    often the queue depth is sampled, 10).
+*/
+function replay(trace, options){
+    var multiHashing = require('./index');
+
+    options = options || {};
+
+    var shares = load(trace);
+    var mode = options.mode || 'sync';
+    var speed = options.speed || 1;
+    var batchSize = options.batchSize || 256;
+    var batchMs = options.batchMs || 5;
+    var latencies = {};
+    var completed = {};
+    var dispatched = 0, done = 0, errors = 0;
+    var pending = [], flushTimer = null;
+    var depthMax = 0, depthSum = 0, depthSamples = 0;
+    var start, last;
+
+    if (['sync', 'async', 'batch'].indexOf(mode) < 0)
+        return Promise.reject(new Error('mode should be sync, async or batch.'));
+
+    shares.forEach(function(share){
+        latencies[share.algorithm] = [];
+        completed[share.algorithm] = 0;
+    });
+
+    return new Promise(function(resolve){
+        var lag = perfHooks.monitorEventLoopDelay({resolution: 1});
+
+        function finish(share, failed){
+            var at = now();
+
+            done++;
+            last = at;
+            if (failed){
+                errors++;
+            } else {
+                completed[share.algorithm]++;
+                latencies[share.algorithm].push(at - start - share.t / speed);
+            }
+            if (done === shares.length)
+                report();
+        }
+
+        function task(share){
+            var item = params(share);
+            item.algorithm = share.algorithm;
+            item.input = share.header;
+            return item;
+        }
+
+        function flush(){
+            var batch = pending;
+
+            clearTimeout(flushTimer);
+            flushTimer = null;
+            pending = [];
+            multiHashing.hashTasks(batch.map(task), function(err, result){
+                batch.forEach(function(share, i){
+                    finish(share, err || !result.hashed[i]);
+                });
+            });
+        }
+
+        function dispatch(share){
+            dispatched++;
+            if (mode === 'sync'){
+                var failed = false;
+                try {
+                    multiHashing.hashBatch(share.algorithm, share.header, share.header.length, params(share));
+                }
+                catch (e){
+                    failed = true;
+                }
+                finish(share, failed);
+            } else if (mode === 'async'){
+                multiHashing.hashTasks([task(share)], function(err, result){
+                    finish(share, err || !result.hashed[0]);
+                });
+            } else {
+                pending.push(share);
+                if (pending.length >= batchSize)
+                    flush();
+                else if (!flushTimer)
+                    flushTimer = setTimeout(flush, batchMs);
+            }
+        }
+
+        function pump(){
+            var elapsed = now() - start;
+
+            while (dispatched < shares.length && shares[dispatched].t / speed <= elapsed)
+                dispatch(shares[dispatched]);
+            if (dispatched < shares.length)
+                setTimeout(pump, Math.max(0, shares[dispatched].t / speed - (now() - start)));
+        }
+
+        /* due but not hashed yet: not dispatched, waiting for a batch, or in flight */
+        var sampler = setInterval(function(){
+            var elapsed = now() - start, due = dispatched;
+
+            while (due < shares.length && shares[due].t / speed <= elapsed)
+                due++;
+            var depth = due - done;
+            depthMax = Math.max(depthMax, depth);
+            depthSum += depth;
+            depthSamples++;
+        }, options.sampleMs || 10);
+
+        function report(){
+            var seconds = (last - start) / 1000;
+            var offered = shares.length ? shares[shares.length - 1].t / speed / 1000 : 0;
+            var algorithms = {};
+
+            clearInterval(sampler);
+            lag.disable();
+
+            Object.keys(latencies).forEach(function(name){
+                algorithms[name] = {
+                    count: completed[name],
+                    throughput: seconds ? completed[name] / seconds : 0,
+                    latency: percentiles(latencies[name])
+                };
+            });
+
+            resolve({
+                mode: mode,
+                speed: speed,
+                shares: shares.length,
+                errors: errors,
+                seconds: seconds,
+                offered: offered ? shares.length / offered : 0,
+                throughput: seconds ? (done - errors) / seconds : 0,
+                queue: {max: depthMax, mean: depthSamples ? depthSum / depthSamples : 0},
+                eventLoopLag: {
+                    mean: lag.count ? lag.mean / 1e6 : 0,
+                    p99: lag.count ? lag.percentile(99) / 1e6 : 0,
+                    max: lag.count ? lag.max / 1e6 : 0
+                },
+                algorithms: algorithms
+            });
+        }
+
+        lag.enable();
+        start = now();
+        last = start;
+        if (!shares.length)
+            return report();
+        pump();
+    });
+}
+
+function format(result){
+    var lines = [
+        result.mode + ' x' + result.speed + ': ' + result.throughput.toFixed(1) + ' shares/s (' +
+        result.offered.toFixed(1) + ' offered), ' + result.errors + ' errors, queue max ' + result.queue.max +
+        ' mean ' + result.queue.mean.toFixed(1) + ', event loop lag mean ' + result.eventLoopLag.mean.toFixed(2) +
+        ' p99 ' + result.eventLoopLag.p99.toFixed(2) + ' max ' + result.eventLoopLag.max.toFixed(2) + ' ms'
+    ];
+
+    Object.keys(result.algorithms).forEach(function(name){
+        var a = result.algorithms[name];
+        lines.push('  ' + name + ': ' + a.count + ' shares, ' + a.throughput.toFixed(1) + '/s, latency ' +
+                   PERCENTILES.concat(['max']).map(function(p){
+                       var key = p === 'max' ? 'max' : 'p' + p;
+                       return key + ' ' + a.latency[key].toFixed(2);
+                   }).join(' ') + ' ms');
+    });
+    return lines.join('\n');
+}
+
+exports.replay = replay;
+exports.parse = parse;
+exports.synthesize = synthesize;
+exports.save = save;
+exports.format = format;
+
+if (require.main === module){
+    var args = process.argv.slice(2);
+    var options = {};
+    var modes = ['sync', 'async', 'batch'];
+    var speeds = [1];
+    var trace = null, output = null, synthetic = {};
+
+    for (var i = 0; i < args.length; i++){
+        switch (args[i]){
+            case '--mode': modes = args[++i].split(','); break;
+            case '--speed': speeds = args[++i].split(',').map(Number); break;
+            case '--batch-size': options.batchSize = +args[++i]; break;
+            case '--batch-ms': options.batchMs = +args[++i]; break;
+            case '--json': options.json = true; break;
+            case '--synthesize': output = args[++i]; break;
+            case '--duration': synthetic.duration = +args[++i]; break;
+            case '--rate': synthetic.rate = +args[++i]; break;
+            case '--seed': synthetic.seed = +args[++i]; break;
+            case '--mix':
+                synthetic.mix = {};
+                args[++i].split(',').forEach(function(part){
+                    var pair = part.split(':');
+                    synthetic.mix[pair[0]] = pair.length > 1 ? +pair[1] : 1;
+                });
+                break;
+            default:
+                if (args[i][0] !== '-' && !trace){
+                    trace = args[i];
+                    break;
+                }
+                console.error('usage: multihashing-replay trace.jsonl [--mode sync,async,batch] [--speed 1,10] ' +
+                              '[--batch-size n] [--batch-ms ms] [--json]\n' +
+                              '       multihashing-replay --synthesize trace.jsonl [--duration ms] [--rate n] ' +
+                              '[--mix x11:0.8,scrypt:0.2] [--seed n]');
+                process.exit(1);
+        }
+    }
+
+    if (output){
+        save(synthesize(synthetic), output);
+        console.log('wrote ' + output);
+        process.exit(0);
+    }
+
+    var shares = trace ? load(trace) : synthesize(synthetic);
+    var runs = [];
+    modes.forEach(function(mode){
+        speeds.forEach(function(speed){
+            runs.push({mode: mode, speed: speed, batchSize: options.batchSize, batchMs: options.batchMs});
+        });
+    });
+
+    /* one run at a time, so they do not compete for the cpu */
+    runs.reduce(function(previous, run){
+        return previous.then(function(){
+            return replay(shares, run).then(function(result){
+                console.log(options.json ? JSON.stringify(result) : format(result));
+            });
+        });
+    }, Promise.resolve()).catch(function(err){
+        console.error(err.message);
+        process.exit(1);
+    });
+}
@@ -0,0 +1,384 @@
+#include "multihash.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "probes.h"
+
+/*
+ * Submission/completion rings in memory shared with the producer (typically a
+ * JS SharedArrayBuffer). Both rings are bounded MPMC queues in Vyukov's style:
+ * every slot starts with a sequence number, a position is claimed with a CAS
+ * on the enqueue or dequeue counter, and the slot is handed over by storing
+ * its next sequence number with release semantics. The JS side (ring.js)
+ * speaks the same protocol through Atomics on an Int32Array view.
+ */
+
+#define OFF_MAGIC       0
+#define OFF_VERSION     4
+#define OFF_SLOTS       8
+#define OFF_FLAGS       12
+#define OFF_SQ_ENQUEUE  64
+#define OFF_SQ_DEQUEUE  128
+#define OFF_CQ_ENQUEUE  192
+#define OFF_CQ_DEQUEUE  256
+
+/* submission slot */
+#define SQ_SEQ      0
+#define SQ_ID       4
+#define SQ_ALGO     8
+#define SQ_FLAGS    9
+#define SQ_LEN      10
+#define SQ_PARAM0   12
+#define SQ_PARAM1   16
+#define SQ_SUBMITTED 24
+#define SQ_TARGET   32
+#define SQ_INPUT    64
+
+/* completion slot */
+#define CQ_SEQ      0
+#define CQ_ID       4
+#define CQ_STATUS   8
+#define CQ_MEETS    12
+#define CQ_HASH     16
+
+#define FLAG_TARGET 1
+
+/* header flags */
+#define RING_STAMP  1   /* a tracer is attached: producers stamp submissions */
+
+#define IDLE_SPINS  256
+#define IDLE_WAIT_NS 200000 /* a worker with nothing to do sleeps at most this long, unless woken */
+#define IDLE_TRIM_WAITS 250 /* after this many idle waits (~50 ms) a worker trims its context */
+
+/*
+ * ring__dequeue: id, algo, len, queue wait in ns (0 unless the producer stamped
+ * the submission); ring__done: id, algo, status, service time in ns.
+ */
+MULTIHASH_PROBE_DEFINE(ring__dequeue);
+MULTIHASH_PROBE_DEFINE(ring__done);
+
+typedef struct ring {
+    uint8_t* base;
+    uint32_t slots;
+    uint32_t mask;
+    uint8_t* sq;
+    uint8_t* cq;
+} ring;
+
+static uint32_t* u32_at(uint8_t* p)
+{
+    return (uint32_t*) p;
+}
+
+static int ring_open(ring* r, void* mem)
+{
+    r->base = (uint8_t*) mem;
+    if (*u32_at(r->base + OFF_MAGIC) != MULTIHASH_RING_MAGIC || *u32_at(r->base + OFF_VERSION) != MULTIHASH_RING_VERSION)
+        return MULTIHASH_EINVAL;
+    r->slots = *u32_at(r->base + OFF_SLOTS);
+    r->mask = r->slots - 1;
+    r->sq = r->base + MULTIHASH_RING_HEADER_SIZE;
+    r->cq = r->sq + (size_t) r->slots * MULTIHASH_RING_SUBMIT_SIZE;
+    return MULTIHASH_OK;
+}
+
+size_t multihash_ring_size(uint32_t slots)
+{
+    return MULTIHASH_RING_HEADER_SIZE + (size_t) slots * (MULTIHASH_RING_SUBMIT_SIZE + MULTIHASH_RING_COMPLETE_SIZE);
+}
+
+int multihash_ring_init(void* mem, size_t size, uint32_t slots)
+{
+    uint8_t* base = (uint8_t*) mem;
+    ring r;
+    uint32_t i;
+
+    if (slots < 2 || (slots & (slots - 1)) || slots > (1u << 24) || size < multihash_ring_size(slots) ||
+        ((uintptr_t) mem & 7))
+        return MULTIHASH_EINVAL;
+
+    memset(base, 0, MULTIHASH_RING_HEADER_SIZE);
+    *u32_at(base + OFF_SLOTS) = slots;
+    *u32_at(base + OFF_VERSION) = MULTIHASH_RING_VERSION;
+
+    r.sq = base + MULTIHASH_RING_HEADER_SIZE;
+    r.cq = r.sq + (size_t) slots * MULTIHASH_RING_SUBMIT_SIZE;
+    for (i = 0; i < slots; i++) {
+        *u32_at(r.sq + (size_t) i * MULTIHASH_RING_SUBMIT_SIZE + SQ_SEQ) = i;
+        *u32_at(r.cq + (size_t) i * MULTIHASH_RING_COMPLETE_SIZE + CQ_SEQ) = i;
+    }
+
+    /* the magic goes last: a ring is usable once it reads back */
+    __atomic_store_n(u32_at(base + OFF_MAGIC), MULTIHASH_RING_MAGIC, __ATOMIC_RELEASE);
+    return MULTIHASH_OK;
+}
+
+/*
+ * Claims the next slot of a queue: with dequeue == 0 a free slot to fill, with
+ * dequeue == 1 a filled slot to drain. Returns NULL when the queue is full or
+ * empty respectively.
+ */
+static uint8_t* claim(uint8_t* slots, size_t slot_size, uint32_t mask, uint32_t* counter, int dequeue, uint32_t* pos_out)
+{
+    uint32_t pos = __atomic_load_n(counter, __ATOMIC_RELAXED);
+
+    for (;;) {
+        uint8_t* slot = slots + (size_t) (pos & mask) * slot_size;
+        uint32_t seq = __atomic_load_n(u32_at(slot), __ATOMIC_ACQUIRE);
+        int32_t dif = (int32_t) (seq - (pos + dequeue));
+
+        if (dif == 0) {
+            if (__sync_bool_compare_and_swap(counter, pos, pos + 1)) {
+                *pos_out = pos;
+                return slot;
+            }
+            pos = __atomic_load_n(counter, __ATOMIC_RELAXED);
+        } else if (dif < 0) {
+            return NULL;
+        } else {
+            pos = __atomic_load_n(counter, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void publish(uint8_t* slot, uint32_t seq)
+{
+    __atomic_store_n(u32_at(slot), seq, __ATOMIC_RELEASE);
+}
+
+int multihash_ring_submit(void* mem, uint32_t id, int algo, const multihash_params* params,
+                          const void* input, size_t len, const void* target)
+{
+    ring r;
+    uint8_t* slot;
+    uint32_t pos;
+
+    if (ring_open(&r, mem) != MULTIHASH_OK || algo < 0 || algo >= MULTIHASH_ALGO_COUNT ||
+        len > MULTIHASH_RING_INPUT_MAX)
+        return MULTIHASH_EINVAL;
+
+    if (!(slot = claim(r.sq, MULTIHASH_RING_SUBMIT_SIZE, r.mask, u32_at(r.base + OFF_SQ_ENQUEUE), 0, &pos)))
+        return 0;
+
+    *u32_at(slot + SQ_ID) = id;
+    slot[SQ_ALGO] = (uint8_t) algo;
+    slot[SQ_FLAGS] = target ? FLAG_TARGET : 0;
+    slot[SQ_LEN] = (uint8_t) len;
+    slot[SQ_LEN + 1] = (uint8_t) (len >> 8);
+    *u32_at(slot + SQ_PARAM0) = params ? (algo == MULTIHASH_SCRYPT ? params->N : params->nfactor) : 0;
+    *u32_at(slot + SQ_PARAM1) = params ? params->r : 0;
+    if (__atomic_load_n(u32_at(r.base + OFF_FLAGS), __ATOMIC_RELAXED) & RING_STAMP)
+        *(uint64_t*) (slot + SQ_SUBMITTED) = multihash_probe_ns();
+    if (target)
+        memcpy(slot + SQ_TARGET, target, 32);
+    memcpy(slot + SQ_INPUT, input, len);
+
+    publish(slot, pos + 1);
+    return 1;
+}
+
+int multihash_ring_poll(void* mem, multihash_ring_completion* completion)
+{
+    ring r;
+    uint8_t* slot;
+    uint32_t pos;
+
+    if (ring_open(&r, mem) != MULTIHASH_OK)
+        return MULTIHASH_EINVAL;
+
+    if (!(slot = claim(r.cq, MULTIHASH_RING_COMPLETE_SIZE, r.mask, u32_at(r.base + OFF_CQ_DEQUEUE), 1, &pos)))
+        return 0;
+
+    completion->id = *u32_at(slot + CQ_ID);
+    completion->status = (int32_t) *u32_at(slot + CQ_STATUS);
+    completion->meets_target = *u32_at(slot + CQ_MEETS);
+    memcpy(completion->hash, slot + CQ_HASH, 32);
+
+    publish(slot, pos + r.mask + 1);
+    return 1;
+}
+
+struct multihash_ring_workers {
+    ring r;
+    unsigned count;
+    volatile int stop;
+    multihash_share_filter* filter;     /* NULL: every submission is hashed */
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t* threads;
+};
+
+static void idle(multihash_ring_workers* w)
+{
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += IDLE_WAIT_NS;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    if (!w->stop)
+        pthread_cond_timedwait(&w->wake, &w->lock, &deadline);
+    pthread_mutex_unlock(&w->lock);
+}
+
+static void process(multihash_ctx* ctx, multihash_share_filter* filter, const uint8_t* in, uint8_t* out)
+{
+    multihash_params params;
+    int algo = in[SQ_ALGO];
+    size_t len = in[SQ_LEN] | (size_t) in[SQ_LEN + 1] << 8;
+    uint32_t param0 = *(const uint32_t*) (in + SQ_PARAM0);
+    uint32_t id = *(const uint32_t*) (in + SQ_ID);
+    uint64_t submitted = *(const uint64_t*) (in + SQ_SUBMITTED);
+    uint64_t start = 0, wait = 0, service;
+    int rc;
+
+    if (MULTIHASH_PROBE_ENABLED(ring__dequeue) || MULTIHASH_PROBE_ENABLED(ring__done)) {
+        start = multihash_probe_ns();
+        wait = submitted && submitted < start ? start - submitted : 0;
+    }
+    MULTIHASH_PROBE4(ring__dequeue, id, algo, len, wait);
+
+    memset(&params, 0, sizeof(params));
+    params.N = param0;
+    params.nfactor = param0;
+    params.r = *(const uint32_t*) (in + SQ_PARAM1);
+
+    *u32_at(out + CQ_ID) = id;
+
+    if (len > MULTIHASH_RING_INPUT_MAX)
+        rc = MULTIHASH_EINVAL;
+    else if (filter && multihash_share_filter_insert(filter, in + SQ_INPUT, len) == 0)
+        rc = MULTIHASH_EDUPLICATE;
+    else
+        rc = multihash_hash(ctx, algo, &params, in + SQ_INPUT, len, out + CQ_HASH);
+
+    *u32_at(out + CQ_STATUS) = (uint32_t) rc;
+    *u32_at(out + CQ_MEETS) = rc == MULTIHASH_OK && (in[SQ_FLAGS] & FLAG_TARGET) &&
+                              multihash_meets_target(out + CQ_HASH, in + SQ_TARGET);
+
+    service = start ? multihash_probe_ns() - start : 0;
+    MULTIHASH_PROBE4(ring__done, id, algo, rc, service);
+}
+
+/* asks producers for submission timestamps only while a tracer wants queue waits */
+static void update_stamp_flag(ring* r)
+{
+    uint32_t* flags = u32_at(r->base + OFF_FLAGS);
+    uint32_t want = MULTIHASH_PROBE_ENABLED(ring__dequeue) ? RING_STAMP : 0;
+
+    if ((__atomic_load_n(flags, __ATOMIC_RELAXED) & RING_STAMP) != want)
+        __atomic_store_n(flags, want ? *flags | RING_STAMP : *flags & ~RING_STAMP, __ATOMIC_RELAXED);
+}
+
+static void* worker_main(void* arg)
+{
+    multihash_ring_workers* w = (multihash_ring_workers*) arg;
+    ring* r = &w->r;
+    multihash_ctx* ctx = multihash_ctx_new();
+    uint8_t record[MULTIHASH_RING_SUBMIT_SIZE];
+    uint8_t *sq_slot, *cq_slot;
+    uint32_t sq_pos, cq_pos;
+    unsigned spins = 0;
+
+    while (!w->stop) {
+        if (!(sq_slot = claim(r->sq, MULTIHASH_RING_SUBMIT_SIZE, r->mask, u32_at(r->base + OFF_SQ_DEQUEUE), 1, &sq_pos))) {
+            if (++spins < IDLE_SPINS)
+                continue;
+            if (spins == IDLE_SPINS + IDLE_TRIM_WAITS)
+                multihash_ctx_trim(ctx);
+            idle(w);
+            continue;
+        }
+        spins = 0;
+
+        /* copy the record out so its slot goes back to the producer before we hash */
+        memcpy(record + 4, sq_slot + 4, MULTIHASH_RING_SUBMIT_SIZE - 4);
+        if (*(uint64_t*) (record + SQ_SUBMITTED))
+            *(uint64_t*) (sq_slot + SQ_SUBMITTED) = 0;
+        publish(sq_slot, sq_pos + r->mask + 1);
+        update_stamp_flag(r);
+
+        while (!(cq_slot = claim(r->cq, MULTIHASH_RING_COMPLETE_SIZE, r->mask, u32_at(r->base + OFF_CQ_ENQUEUE), 0, &cq_pos))) {
+            if (w->stop)
+                goto out;
+            idle(w);
+        }
+
+        process(ctx, w->filter, record, cq_slot);
+        publish(cq_slot, cq_pos + 1);
+    }
+
+out:
+    multihash_ctx_free(ctx);
+    return NULL;
+}
+
+multihash_ring_workers* multihash_ring_start(void* mem, unsigned threads)
+{
+    return multihash_ring_start_filtered(mem, threads, NULL);
+}
+
+multihash_ring_workers* multihash_ring_start_filtered(void* mem, unsigned threads, multihash_share_filter* filter)
+{
+    multihash_ring_workers* w;
+    unsigned i;
+
+    if (threads == 0 || !(w = (multihash_ring_workers*) calloc(1, sizeof(multihash_ring_workers))))
+        return NULL;
+    if (ring_open(&w->r, mem) != MULTIHASH_OK ||
+        !(w->threads = (pthread_t*) calloc(threads, sizeof(pthread_t)))) {
+        free(w);
+        return NULL;
+    }
+
+    w->filter = filter;
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->wake, NULL);
+
+    for (i = 0; i < threads; i++) {
+        if (pthread_create(&w->threads[i], NULL, worker_main, w) != 0)
+            break;
+        w->count++;
+    }
+
+    if (w->count == 0) {
+        multihash_ring_stop(w);
+        return NULL;
+    }
+    return w;
+}
+
+void multihash_ring_wake(multihash_ring_workers* w)
+{
+    pthread_mutex_lock(&w->lock);
+    pthread_cond_broadcast(&w->wake);
+    pthread_mutex_unlock(&w->lock);
+}
+
+void multihash_ring_stop(multihash_ring_workers* w)
+{
+    unsigned i;
+
+    if (!w)
+        return;
+
+    pthread_mutex_lock(&w->lock);
+    w->stop = 1;
+    pthread_cond_broadcast(&w->wake);
+    pthread_mutex_unlock(&w->lock);
+
+    for (i = 0; i < w->count; i++)
+        pthread_join(w->threads[i], NULL);
+
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->wake);
+    free(w->threads);
+    free(w);
+}
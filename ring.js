@@ -0,0 +1,200 @@
+/*
+    JS end of the shared-memory share rings (layout in multihash.h). Records are
+    written straight into a SharedArrayBuffer and native worker threads hash them;
+    no V8 call, request object or Buffer is created per share.
+
+        var ring = new HashRing({slots: 65536, threads: 4});   // or threads: 'auto'
+        ring.submit(id, 'x11', header, target);
+        ring.poll(function(id, status, meetsTarget, hash){ ... });
+
+    Other worker_threads can submit and poll too: post them ring.buffer and call
+    HashRing.attach(buffer).
+
+    With options.filter (a shareFilter) the workers insert every input into it before
+    hashing; an input it has seen completes with status HashRing.DUPLICATE unhashed.
+*/
+
+var os = require('os');
+var families = require('./families');
+
+var OFF_SLOTS = 8;
+var OFF_FLAGS = 12;
+var OFF_SQ_ENQUEUE = 64;
+var OFF_SQ_DEQUEUE = 128;
+var OFF_CQ_ENQUEUE = 192;
+var OFF_CQ_DEQUEUE = 256;
+var HEADER_SIZE = 320;
+var SUBMIT_SIZE = 192;
+var COMPLETE_SIZE = 64;
+var INPUT_MAX = 128;
+var MAGIC = 0x4752484d;
+var RING_STAMP = 1;
+var EDUPLICATE = -3;
+
+var algoIds = null;
+
+function HashRing(options, buffer){
+    /* workers may be handed any algorithm, so the ring runs on the complete module */
+    var native = families.load('all');
+
+    options = options || {};
+
+    if (!algoIds){
+        algoIds = {};
+        native.algorithms.forEach(function(name, id){ algoIds[name] = id; });
+    }
+
+    if (!buffer){
+        var slots = options.slots || 4096;
+        buffer = new SharedArrayBuffer(native.ringSize(slots));
+        native.initRing(new Uint8Array(buffer), slots);
+    }
+
+    this.buffer = buffer;
+    this.bytes = new Uint8Array(buffer);
+    this.words = new Int32Array(buffer);
+    this.view = new DataView(buffer);
+    /* poll() copies each completed hash here before it releases the slot */
+    this.hash = Buffer.alloc(32);
+
+    if (this.view.getUint32(0, true) !== MAGIC)
+        throw new Error('Buffer is not an initialized hash ring.');
+
+    this.slots = this.view.getUint32(OFF_SLOTS, true);
+    this.mask = this.slots - 1;
+    this.sq = HEADER_SIZE;
+    this.cq = HEADER_SIZE + this.slots * SUBMIT_SIZE;
+    this.workers = options.threads ? native.ringWorkers(this.bytes, workerCount(options), options.filter) : null;
+}
+
+/* threads: 'auto' takes what tune() measured for options.algorithm (or the most any algorithm wanted) */
+function workerCount(options){
+    if (options.threads !== 'auto')
+        return options.threads;
+
+    var tuned = require('./tune').cached().threads;
+    if (options.algorithm)
+        return tuned[options.algorithm] || os.cpus().length;
+
+    var counts = Object.keys(tuned).map(function(algo){ return tuned[algo]; });
+    return counts.length ? Math.max.apply(null, counts) : os.cpus().length;
+}
+
+/* completion status of a submission options.filter had seen */
+HashRing.DUPLICATE = EDUPLICATE;
+
+HashRing.attach = function(buffer){
+    return new HashRing({}, buffer);
+};
+
+/* Vyukov-style claim, see ring.c: dequeue is 0 to fill a slot, 1 to drain one */
+HashRing.prototype._claim = function(base, size, counter, dequeue){
+    var words = this.words;
+    var pos = Atomics.load(words, counter >> 2);
+
+    for (;;){
+        var slot = base + (pos & this.mask) * size;
+        var dif = (Atomics.load(words, slot >> 2) - (pos + dequeue)) | 0;
+
+        if (dif === 0){
+            var seen = Atomics.compareExchange(words, counter >> 2, pos, (pos + 1) | 0);
+            if (seen === pos){
+                this._pos = pos;
+                return slot;
+            }
+            pos = seen;
+        }
+        else if (dif < 0)
+            return -1;
+        else
+            pos = Atomics.load(words, counter >> 2);
+    }
+};
+
+/*
+    Queues one share; returns false when the ring is full. params is N for scrypt or
+    the nfactor for scryptn/scryptjane, r for scrypt. target (32 bytes, little endian)
+    is optional.
+*/
+HashRing.prototype.submit = function(id, algo, input, target, param0, param1){
+    var algoId = typeof algo === 'number' ? algo : algoIds[algo];
+
+    if (algoId === undefined)
+        throw new Error('Unknown algorithm ' + algo);
+    if (input.length > INPUT_MAX)
+        throw new Error('Input should be at most ' + INPUT_MAX + ' bytes.');
+
+    var slot = this._claim(this.sq, SUBMIT_SIZE, OFF_SQ_ENQUEUE, 0);
+    if (slot < 0)
+        return false;
+    var pos = this._pos;
+    var view = this.view;
+
+    view.setUint32(slot + 4, id, true);
+    view.setUint8(slot + 8, algoId);
+    view.setUint8(slot + 9, target ? 1 : 0);
+    view.setUint16(slot + 10, input.length, true);
+    view.setUint32(slot + 12, param0 || 0, true);
+    view.setUint32(slot + 16, param1 || 0, true);
+    /* only while a tracer measures queue wait, see probes.h */
+    if (this.words[OFF_FLAGS >> 2] & RING_STAMP)
+        view.setBigUint64(slot + 24, process.hrtime.bigint(), true);
+    if (target)
+        this.bytes.set(target, slot + 32);
+    this.bytes.set(input, slot + 64);
+
+    Atomics.store(this.words, slot >> 2, (pos + 1) | 0);
+    return true;
+};
+
+/*
+    Hands up to max completions (default: all there are) to callback(id, status,
+    meetsTarget, hash) and returns how many. Each slot is released before its
+    callback runs, so a callback that throws does not wedge the ring. hash is a
+    32-byte buffer reused for every completion of this HashRing, valid only until
+    the callback returns; copy it to keep it. status is 0, or a negative
+    MULTIHASH_E* code when the share could not be hashed (HashRing.DUPLICATE for a
+    duplicate).
+*/
+HashRing.prototype.poll = function(callback, max){
+    var view = this.view;
+    var hash = this.hash;
+    var count = 0;
+
+    max = max || Infinity;
+
+    while (count < max){
+        var slot = this._claim(this.cq, COMPLETE_SIZE, OFF_CQ_DEQUEUE, 1);
+        if (slot < 0)
+            break;
+        var id = view.getUint32(slot + 4, true);
+        var status = view.getInt32(slot + 8, true);
+        var meetsTarget = view.getUint32(slot + 12, true) !== 0;
+        hash.set(this.bytes.subarray(slot + 16, slot + 48));
+
+        Atomics.store(this.words, slot >> 2, (this._pos + this.mask + 1) | 0);
+        count++;
+
+        callback(id, status, meetsTarget, hash);
+    }
+    return count;
+};
+
+/* Submissions not yet taken by a worker */
+HashRing.prototype.pending = function(){
+    return (Atomics.load(this.words, OFF_SQ_ENQUEUE >> 2) - Atomics.load(this.words, OFF_SQ_DEQUEUE >> 2)) | 0;
+};
+
+/* Idle workers otherwise notice new submissions within a fraction of a millisecond */
+HashRing.prototype.wake = function(){
+    if (this.workers)
+        this.workers.wake();
+};
+
+HashRing.prototype.stop = function(){
+    if (this.workers)
+        this.workers.stop();
+    this.workers = null;
+};
+
+module.exports = HashRing;
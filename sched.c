@@ -0,0 +1,441 @@
+#include "multihash.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Work-stealing scheduler for mixed batches (see multihash_scheduler_run).
+ *
+ * A batch is known in full before it starts and no task spawns others, so a
+ * deque is just a range of positions in the batch's order[] array, packed as
+ * head << 32 | tail into one word. The owner pops from the tail and thieves
+ * take from the head, both with a CAS on that word; a thief moves what it
+ * took into its own (empty) deque, where it can be stolen again. A position
+ * is handed out exactly once, so a deque never returns to an earlier value
+ * and the CAS cannot be fooled by ABA.
+ *
+ * Every worker has one deque per cost class. Light tasks (10 us sph chains)
+ * are all taken before any worker starts on a heavy one (milliseconds of
+ * scrypt-jane or cryptonight), so they never wait behind one; light ranges
+ * are stolen by halves, heavy tasks one at a time.
+ *
+ * Batches queue up in the scheduler instead of blocking their submitters.
+ * Every batch has deques of its own; the workers all start on the oldest,
+ * and the first to find nothing left in it takes it off the queue and moves
+ * on to the next while the others finish what they hold. The last worker out
+ * of a batch completes it.
+ *
+ * A worker that has had nothing to do for LINGER_NS trims its contexts, so
+ * the scratchpads of the last batch do not stay with the pool for good.
+ *
+ * The per-family Node modules each link their own copy of this file and
+ * share one scheduler. A batch records the kernel of the copy that submitted
+ * it (its multihash_hash and context functions), and a worker keeps one
+ * context per kernel, so every task runs on code and scratchpads of the
+ * module that carries its algorithm whichever module started the threads.
+ */
+
+#define CLASS_LIGHT 0
+#define CLASS_HEAVY 1
+#define CLASS_COUNT 2
+
+#define LINGER_NS   50000000        /* 50 ms */
+#define KERNEL_MAX  8               /* modules sharing a scheduler: binding.gyp builds six */
+
+typedef struct kernel {
+    int (*hash)(multihash_ctx* ctx, int algo, const multihash_params* params,
+                const void* input, size_t len, void* output);
+    multihash_ctx* (*ctx_new)(void);
+    void (*ctx_trim)(multihash_ctx* ctx);
+    void (*ctx_free)(multihash_ctx* ctx);
+} kernel;
+
+/* this module's; its address tells the modules apart */
+static const kernel local_kernel = {
+    multihash_hash, multihash_ctx_new, multihash_ctx_trim, multihash_ctx_free
+};
+
+typedef struct deque {
+    uint64_t range;
+    char pad[64 - sizeof(uint64_t)];        /* one cache line per deque */
+} deque;
+
+typedef struct batch {
+    struct batch* next;
+    multihash_task* tasks;
+    uint32_t* order;
+    deque* deques;                  /* CLASS_COUNT per worker */
+    unsigned users;                 /* workers draining it */
+    int exhausted;                  /* every task handed out, off the queue */
+    const kernel* kernel;           /* of the module that submitted it */
+    multihash_batch_fn complete;
+    void* arg;
+} batch;
+
+typedef struct worker_ctx {
+    const kernel* kernel;
+    multihash_ctx* ctx;
+} worker_ctx;
+
+typedef struct worker {
+    worker_ctx ctxs[KERNEL_MAX];    /* filled on first use, in order */
+    pthread_t thread;
+    multihash_scheduler* s;
+    unsigned index;
+} worker;
+
+struct multihash_scheduler {
+    unsigned count;                 /* workers */
+    worker* workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start;           /* a batch was queued, or stop */
+    batch* head;                    /* queued batches, oldest first */
+    batch* tail;
+    int stop;
+};
+
+/* what multihash_scheduler_run waits on */
+typedef struct waiter {
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    int finished;
+} waiter;
+
+static uint64_t pack(uint32_t head, uint32_t tail)
+{
+    return (uint64_t) head << 32 | tail;
+}
+
+static int cost_class(const multihash_task* task)
+{
+    switch (task->algo) {
+    case MULTIHASH_BCRYPT:
+    case MULTIHASH_BOOLBERRY:
+        return CLASS_HEAVY;
+    }
+    return multihash_scratchpad_size(task->algo, &task->params) ? CLASS_HEAVY : CLASS_LIGHT;
+}
+
+/* w's context for k; NULL (hash without caching) once KERNEL_MAX modules have one */
+static multihash_ctx* worker_ctx_for(worker* w, const kernel* k)
+{
+    unsigned i;
+
+    for (i = 0; i < KERNEL_MAX && w->ctxs[i].kernel; i++)
+        if (w->ctxs[i].kernel == k)
+            return w->ctxs[i].ctx;
+    if (i == KERNEL_MAX)
+        return NULL;
+    w->ctxs[i].ctx = k->ctx_new();
+    w->ctxs[i].kernel = k;
+    return w->ctxs[i].ctx;
+}
+
+static void worker_trim(worker* w)
+{
+    unsigned i;
+
+    for (i = 0; i < KERNEL_MAX && w->ctxs[i].kernel; i++)
+        w->ctxs[i].kernel->ctx_trim(w->ctxs[i].ctx);
+}
+
+static void run_task(worker* w, const kernel* k, multihash_task* task)
+{
+    task->status = k->hash(worker_ctx_for(w, k), task->algo, &task->params, task->input, task->len, task->output);
+    if (task->done)
+        task->done(task);
+}
+
+/* the owner's end: the last position of its range, or -1 when it is empty */
+static int64_t pop(deque* d)
+{
+    uint64_t range = __atomic_load_n(&d->range, __ATOMIC_ACQUIRE);
+    uint32_t head, tail;
+
+    for (;;) {
+        head = (uint32_t) (range >> 32);
+        tail = (uint32_t) range;
+        if (head >= tail)
+            return -1;
+        if (__atomic_compare_exchange_n(&d->range, &range, pack(head, tail - 1), 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return tail - 1;
+    }
+}
+
+/* takes work of class c from another worker's deque of b into self's; 0 when there is none left */
+static int steal(multihash_scheduler* s, batch* b, worker* self, int c)
+{
+    unsigned i;
+
+    for (i = 1; i < s->count; i++) {
+        deque* victim = &b->deques[(self->index + i) % s->count * CLASS_COUNT + c];
+        uint64_t range = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+        uint32_t head, tail, take;
+
+        for (;;) {
+            head = (uint32_t) (range >> 32);
+            tail = (uint32_t) range;
+            if (head >= tail)
+                break;
+            take = c == CLASS_LIGHT ? (tail - head + 1) / 2 : 1;
+            if (__atomic_compare_exchange_n(&victim->range, &range, pack(head + take, tail), 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&b->deques[self->index * CLASS_COUNT + c].range, pack(head, head + take),
+                                 __ATOMIC_RELEASE);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* runs tasks of b until none is left to take */
+static void drain(multihash_scheduler* s, batch* b, worker* self)
+{
+    deque* own = &b->deques[self->index * CLASS_COUNT];
+    int64_t position;
+    int c;
+
+    for (c = 0; c < CLASS_COUNT; c++) {
+        for (;;) {
+            if ((position = pop(&own[c])) >= 0)
+                run_task(self, b->kernel, &b->tasks[b->order[position]]);
+            else if (!steal(s, b, self, c))
+                break;
+        }
+    }
+}
+
+static void finish(batch* b)
+{
+    b->complete(b->arg, MULTIHASH_OK);
+    free(b->order);
+    free(b->deques);
+    free(b);
+}
+
+/* waits up to LINGER_NS for a batch; 0 when none came */
+static int linger(multihash_scheduler* s)
+{
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += LINGER_NS;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    while (!s->stop && !s->head)
+        if (pthread_cond_timedwait(&s->start, &s->lock, &deadline) == ETIMEDOUT)
+            return s->stop || s->head;
+    return 1;
+}
+
+static void* worker_main(void* arg)
+{
+    worker* self = (worker*) arg;
+    multihash_scheduler* s = self->s;
+    batch* b;
+    int last;
+
+    for (;;) {
+        pthread_mutex_lock(&s->lock);
+        if (!linger(s)) {
+            pthread_mutex_unlock(&s->lock);
+            worker_trim(self);
+            pthread_mutex_lock(&s->lock);
+        }
+        while (!s->stop && !s->head)
+            pthread_cond_wait(&s->start, &s->lock);
+        if (!(b = s->head)) {
+            pthread_mutex_unlock(&s->lock);
+            break;
+        }
+        b->users++;
+        pthread_mutex_unlock(&s->lock);
+
+        drain(s, b, self);
+
+        pthread_mutex_lock(&s->lock);
+        if (!b->exhausted) {
+            b->exhausted = 1;
+            s->head = b->next;
+            if (!s->head)
+                s->tail = NULL;
+        }
+        last = --b->users == 0;
+        pthread_mutex_unlock(&s->lock);
+
+        /* off the queue and nobody left in it: every task has run */
+        if (last)
+            finish(b);
+    }
+    return NULL;
+}
+
+multihash_scheduler* multihash_scheduler_new(unsigned threads)
+{
+    multihash_scheduler* s;
+    unsigned i;
+
+    if (threads == 0 || !(s = (multihash_scheduler*) calloc(1, sizeof(multihash_scheduler))))
+        return NULL;
+    if (!(s->workers = (worker*) calloc(threads, sizeof(worker)))) {
+        free(s);
+        return NULL;
+    }
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->start, NULL);
+
+    for (i = 0; i < threads; i++) {
+        worker* w = &s->workers[i];
+
+        w->s = s;
+        w->index = i;
+        if (pthread_create(&w->thread, NULL, worker_main, w) != 0)
+            break;
+        s->count++;
+    }
+
+    if (s->count == 0) {
+        multihash_scheduler_free(s);
+        return NULL;
+    }
+    return s;
+}
+
+void multihash_scheduler_free(multihash_scheduler* s)
+{
+    unsigned i;
+
+    if (!s)
+        return;
+
+    /* workers finish the queued batches before they exit */
+    pthread_mutex_lock(&s->lock);
+    s->stop = 1;
+    pthread_cond_broadcast(&s->start);
+    pthread_mutex_unlock(&s->lock);
+
+    for (i = 0; i < s->count; i++) {
+        worker* w = &s->workers[i];
+        unsigned k;
+
+        pthread_join(w->thread, NULL);
+        for (k = 0; k < KERNEL_MAX && w->ctxs[k].kernel; k++)
+            w->ctxs[k].kernel->ctx_free(w->ctxs[k].ctx);
+    }
+
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->start);
+    free(s->workers);
+    free(s);
+}
+
+unsigned multihash_scheduler_threads(const multihash_scheduler* s)
+{
+    return s->count;
+}
+
+int multihash_scheduler_submit(multihash_scheduler* s, multihash_task* tasks, size_t count,
+                               multihash_batch_fn complete, void* arg)
+{
+    size_t class_count[CLASS_COUNT] = { 0 }, class_start[CLASS_COUNT], fill[CLASS_COUNT];
+    unsigned char* classes;
+    batch* b;
+    size_t i;
+    unsigned w;
+    int c;
+
+    if (!s || !complete || (!tasks && count) || count >= UINT32_MAX)
+        return MULTIHASH_EINVAL;
+    if (count == 0) {
+        complete(arg, MULTIHASH_OK);
+        return MULTIHASH_OK;
+    }
+
+    b = (batch*) calloc(1, sizeof(batch));
+    classes = (unsigned char*) malloc(count);
+    if (!b || !classes ||
+        !(b->order = (uint32_t*) malloc(count * sizeof(uint32_t))) ||
+        !(b->deques = (deque*) calloc((size_t) s->count * CLASS_COUNT, sizeof(deque)))) {
+        if (b)
+            free(b->order);
+        free(b);
+        free(classes);
+        return MULTIHASH_ENOMEM;
+    }
+
+    /* order[] holds the light tasks, then the heavy ones, each class dealt out in equal runs */
+    for (i = 0; i < count; i++) {
+        classes[i] = (unsigned char) cost_class(&tasks[i]);
+        class_count[classes[i]]++;
+    }
+    class_start[CLASS_LIGHT] = 0;
+    class_start[CLASS_HEAVY] = class_count[CLASS_LIGHT];
+    for (c = 0; c < CLASS_COUNT; c++)
+        fill[c] = class_start[c];
+    for (i = 0; i < count; i++)
+        b->order[fill[classes[i]]++] = (uint32_t) i;
+    free(classes);
+
+    for (w = 0; w < s->count; w++) {
+        for (c = 0; c < CLASS_COUNT; c++) {
+            size_t head = class_start[c] + class_count[c] * w / s->count;
+            size_t tail = class_start[c] + class_count[c] * (w + 1) / s->count;
+            b->deques[w * CLASS_COUNT + c].range = pack((uint32_t) head, (uint32_t) tail);
+        }
+    }
+
+    b->tasks = tasks;
+    b->kernel = &local_kernel;
+    b->complete = complete;
+    b->arg = arg;
+
+    pthread_mutex_lock(&s->lock);
+    if (s->tail)
+        s->tail->next = b;
+    else
+        s->head = b;
+    s->tail = b;
+    pthread_cond_broadcast(&s->start);
+    pthread_mutex_unlock(&s->lock);
+    return MULTIHASH_OK;
+}
+
+static void wake(void* arg, int status)
+{
+    waiter* wt = (waiter*) arg;
+
+    pthread_mutex_lock(&wt->lock);
+    wt->finished = 1;
+    pthread_cond_signal(&wt->done);
+    pthread_mutex_unlock(&wt->lock);
+}
+
+int multihash_scheduler_run(multihash_scheduler* s, multihash_task* tasks, size_t count)
+{
+    waiter wt;
+    int rc;
+
+    pthread_mutex_init(&wt.lock, NULL);
+    pthread_cond_init(&wt.done, NULL);
+    wt.finished = 0;
+
+    rc = multihash_scheduler_submit(s, tasks, count, wake, &wt);
+    if (rc == MULTIHASH_OK) {
+        pthread_mutex_lock(&wt.lock);
+        while (!wt.finished)
+            pthread_cond_wait(&wt.done, &wt.lock);
+        pthread_mutex_unlock(&wt.lock);
+    }
+
+    pthread_mutex_destroy(&wt.lock);
+    pthread_cond_destroy(&wt.done);
+    return rc;
+}
@@ -6,7 +6,11 @@
 
 #include <string.h>
 
+/* the ROMix is chosen at run time from scrypt_mixes below, not by scrypt_getROMix */
+#define SCRYPT_MIX_TABLE
+
 #include "scryptjane.h"
+#include "multihash.h"
 #include "scryptjane/scrypt-jane-portable.h"
 #include "scryptjane/scrypt-jane-hash.h"
 #include "scryptjane/scrypt-jane-romix.h"
@@ -29,6 +33,71 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+typedef struct scrypt_mix_impl_t {
+	const char *name;
+	scrypt_ROMixfn fn;
+	size_t cpu;
+} scrypt_mix_impl;
+
+static const scrypt_mix_impl scrypt_mixes[] = {
+#if defined(SCRYPT_CHACHA_AVX)
+	{ "avx", scrypt_ROMix_avx, cpu_avx },
+#endif
+#if defined(SCRYPT_CHACHA_SSSE3)
+	{ "ssse3", scrypt_ROMix_ssse3, cpu_ssse3 },
+#endif
+#if defined(SCRYPT_CHACHA_SSE2)
+	{ "sse2", scrypt_ROMix_sse2, cpu_sse2 },
+#endif
+	{ "basic", scrypt_ROMix_basic, 0 },
+};
+
+#define scrypt_mix_count (int)(sizeof(scrypt_mixes) / sizeof(scrypt_mixes[0]))
+
+/* index of the pinned kernel, -1 for the cpu default; read once per scrypt() call */
+static int scrypt_mix_pinned = -1;
+
+static int
+scrypt_mix_supported(int index) {
+	static size_t cpuflags = (size_t)-1;
+	if (cpuflags == (size_t)-1) {
+#if defined(CPU_X86) || defined(CPU_X86_64)
+		cpuflags = detect_cpu();
+#else
+		cpuflags = 0;
+#endif
+	}
+	return index >= 0 && index < scrypt_mix_count && (scrypt_mixes[index].cpu & cpuflags) == scrypt_mixes[index].cpu;
+}
+
+int
+scryptjane_mix_count(void) {
+	return scrypt_mix_count;
+}
+
+const char *
+scryptjane_mix_name(int index) {
+	return scrypt_mix_supported(index) ? scrypt_mixes[index].name : NULL;
+}
+
+int
+scryptjane_select_mix(int index) {
+	if (index != -1 && !scrypt_mix_supported(index))
+		return -1;
+	__atomic_store_n(&scrypt_mix_pinned, index, __ATOMIC_RELAXED);
+	return 0;
+}
+
+int
+scryptjane_selected_mix(void) {
+	int index = __atomic_load_n(&scrypt_mix_pinned, __ATOMIC_RELAXED);
+	if (index >= 0)
+		return index;
+	for (index = 0; !scrypt_mix_supported(index); index++)
+		;
+	return index;
+}
+
 static void
 scrypt_fatal_error_default(const char *msg) {
 	fprintf(stderr, "%s\n", msg);
@@ -113,12 +182,12 @@ scrypt_alloc(uint64_t size) {
 	static const size_t max_alloc = (size_t)-1;
 	scrypt_aligned_alloc aa;
 	size += (SCRYPT_BLOCK_BYTES - 1);
-	if (size > max_alloc)
-		scrypt_fatal_error("scrypt: not enough address space on this CPU to allocate required memory");
+	if (size > max_alloc) {
+		aa.mem = aa.ptr = NULL;
+		return aa;
+	}
 	aa.mem = (uint8_t *)malloc((size_t)size);
 	aa.ptr = (uint8_t *)(((size_t)aa.mem + (SCRYPT_BLOCK_BYTES - 1)) & ~(SCRYPT_BLOCK_BYTES - 1));
-	if (!aa.mem)
-		scrypt_fatal_error("scrypt: out of memory");
 	return aa;
 }
 
@@ -129,16 +198,12 @@ scrypt_free(scrypt_aligned_alloc *aa) {
 #endif
 
 
-void
-scrypt(const uint8_t *password, size_t password_len, const uint8_t *salt, size_t salt_len, uint8_t Nfactor, uint8_t rfactor, uint8_t pfactor, uint8_t *out, size_t bytes) {
+static int
+scrypt_with_mix(scrypt_ROMixfn scrypt_ROMix, const uint8_t *password, size_t password_len, const uint8_t *salt, size_t salt_len, uint8_t Nfactor, uint8_t rfactor, uint8_t pfactor, uint8_t *out, size_t bytes) {
 	scrypt_aligned_alloc YX, V;
 	uint8_t *X, *Y;
 	uint32_t N, r, p, chunk_bytes, i;
 
-#if !defined(SCRYPT_CHOOSE_COMPILETIME)
-	scrypt_ROMixfn scrypt_ROMix = scrypt_getROMix();
-#endif
-
 #if !defined(SCRYPT_TEST)
 	static int power_on_self_test = 0;
 	if (!power_on_self_test) {
@@ -148,12 +213,8 @@ scrypt(const uint8_t *password, size_t password_len, const uint8_t *salt, size_t
 	}
 #endif
 
-	if (Nfactor > scrypt_maxN)
-		scrypt_fatal_error("scrypt: N out of range");
-	if (rfactor > scrypt_maxr)
-		scrypt_fatal_error("scrypt: r out of range");
-	if (pfactor > scrypt_maxp)
-		scrypt_fatal_error("scrypt: p out of range");
+	if (Nfactor > scrypt_maxN || rfactor > scrypt_maxr || pfactor > scrypt_maxp)
+		return -1;
 
 	N = (1 << (Nfactor + 1));
 	r = (1 << rfactor);
@@ -162,23 +223,45 @@ scrypt(const uint8_t *password, size_t password_len, const uint8_t *salt, size_t
 	chunk_bytes = SCRYPT_BLOCK_BYTES * r * 2;
 	V = scrypt_alloc((uint64_t)N * chunk_bytes);
 	YX = scrypt_alloc((p + 1) * chunk_bytes);
+	if (!V.mem || !YX.mem) {
+		scrypt_free(&V);
+		scrypt_free(&YX);
+		return -2;
+	}
 
 	/* 1: X = PBKDF2(password, salt) */
+	multihash_flight_mark(MULTIHASH_PHASE_INIT);
 	Y = YX.ptr;
 	X = Y + chunk_bytes;
 	scrypt_pbkdf2(password, password_len, salt, salt_len, 1, X, chunk_bytes * p);
 
 	/* 2: X = ROMix(X) */
+	multihash_flight_mark(MULTIHASH_PHASE_MAIN);
 	for (i = 0; i < p; i++)
 		scrypt_ROMix((scrypt_mix_word_t *)(X + (chunk_bytes * i)), (scrypt_mix_word_t *)Y, (scrypt_mix_word_t *)V.ptr, N, r);
 
 	/* 3: Out = PBKDF2(password, X) */
+	multihash_flight_mark(MULTIHASH_PHASE_FINAL);
 	scrypt_pbkdf2(password, password_len, X, chunk_bytes * p, 1, out, bytes);
 
 	scrypt_ensure_zero(YX.ptr, (p + 1) * chunk_bytes);
 
 	scrypt_free(&V);
 	scrypt_free(&YX);
+	return 0;
+}
+
+int
+scrypt(const uint8_t *password, size_t password_len, const uint8_t *salt, size_t salt_len, uint8_t Nfactor, uint8_t rfactor, uint8_t pfactor, uint8_t *out, size_t bytes) {
+	return scrypt_with_mix(scrypt_mixes[scryptjane_selected_mix()].fn, password, password_len, salt, salt_len, Nfactor, rfactor, pfactor, out, bytes);
+}
+
+/* what scrypt() allocates for the given factors, alignment slack included */
+uint64_t
+scrypt_memory_size(unsigned char Nfactor, unsigned char rfactor, unsigned char pfactor) {
+	uint64_t chunk_bytes = (uint64_t)SCRYPT_BLOCK_BYTES * (1 << rfactor) * 2;
+	return ((uint64_t)1 << (Nfactor + 1)) * chunk_bytes + (SCRYPT_BLOCK_BYTES - 1) +
+	       ((uint64_t)(1 << pfactor) + 1) * chunk_bytes + (SCRYPT_BLOCK_BYTES - 1);
 }
 
 #define max(a,b)            (((a) > (b)) ? (a) : (b))
@@ -215,9 +298,17 @@ unsigned char GetNfactorJane(int nTimestamp, int nChainStartTime, int nMin, int
         return min(max(N, minNfactor), maxNfactor);
 }
 
-void scryptjane_hash(const void* input, size_t inputlen, uint32_t *res, unsigned char Nfactor)
+int scryptjane_hash(const void* input, size_t inputlen, uint32_t *res, unsigned char Nfactor)
 {
     return scrypt((const unsigned char*)input, inputlen,
                   (const unsigned char*)input, inputlen,
                    Nfactor, 0, 0, (unsigned char*)res, 32);
 }
+
+/* always the portable kernel, whatever scryptjane_select_mix chose */
+int scryptjane_hash_reference(const void* input, size_t inputlen, uint32_t *res, unsigned char Nfactor)
+{
+    return scrypt_with_mix(scrypt_ROMix_basic, (const unsigned char*)input, inputlen,
+                           (const unsigned char*)input, inputlen,
+                           Nfactor, 0, 0, (unsigned char*)res, 32);
+}
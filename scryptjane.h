@@ -5,7 +5,6 @@
 
 #define SCRYPT_KECCAK512
 #define SCRYPT_CHACHA
-#define SCRYPT_CHOOSE_COMPILETIME
 
 /*
 	Nfactor: Increases CPU & Memory Hardness
@@ -28,9 +27,23 @@
 typedef void (*scrypt_fatal_errorfn)(const char *msg);
 void scrypt_set_fatal_error(scrypt_fatal_errorfn fn);
 
-void scrypt(const unsigned char *password, size_t password_len, const unsigned char *salt, size_t salt_len, unsigned char Nfactor, unsigned char rfactor, unsigned char pfactor, unsigned char *out, size_t bytes);
+/* Returns 0, -1 for factors out of range or -2 when the scratchpad cannot be allocated */
+int scrypt(const unsigned char *password, size_t password_len, const unsigned char *salt, size_t salt_len, unsigned char Nfactor, unsigned char rfactor, unsigned char pfactor, unsigned char *out, size_t bytes);
+uint64_t scrypt_memory_size(unsigned char Nfactor, unsigned char rfactor, unsigned char pfactor);
+
+/*
+	The ChaCha ROMix kernels built in (avx, ssse3, sse2, basic), fastest first. By
+	default the first one the cpu supports runs; scryptjane_select_mix pins another,
+	-1 returns to the default. scryptjane_mix_name is NULL for kernels this cpu
+	cannot run, which scryptjane_select_mix refuses with -1.
+*/
+int scryptjane_mix_count(void);
+const char *scryptjane_mix_name(int index);
+int scryptjane_select_mix(int index);
+int scryptjane_selected_mix(void);
 
 unsigned char GetNfactorJane(int nTimestamp, int nChainStartTime, int nMin, int nMax);
-void scryptjane_hash(const void* input, size_t inputlen, uint32_t *res, unsigned char Nfactor);
+int scryptjane_hash(const void* input, size_t inputlen, uint32_t *res, unsigned char Nfactor);
+int scryptjane_hash_reference(const void* input, size_t inputlen, uint32_t *res, unsigned char Nfactor);
 
 #endif /* SCRYPT_JANE_H */
@@ -50,7 +50,8 @@ typedef uint32_t scrypt_mix_word_t;
 #define SCRYPT_ROMIX_UNTANGLE_FN scrypt_romix_convert_endian
 #include "scrypt-jane-romix-template.h"
 
-#if !defined(SCRYPT_CHOOSE_COMPILETIME)
+/* scryptjane.c picks the mix from a table of its own (SCRYPT_MIX_TABLE) */
+#if !defined(SCRYPT_CHOOSE_COMPILETIME) && !defined(SCRYPT_MIX_TABLE)
 static scrypt_ROMixfn
 scrypt_getROMix() {
 	size_t cpuflags = detect_cpu();
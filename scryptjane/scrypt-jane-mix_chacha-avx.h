@@ -134,8 +134,8 @@ asm_naked_fn(scrypt_ChunkMix_avx)
 	a2(lea rax,[rsi+r9])
 	a2(lea r9,[rdx+r9])
 	a2(and rdx, rdx)
-	a2(vmovdqa xmm4,[ssse3_rotl16_32bit])
-	a2(vmovdqa xmm5,[ssse3_rotl8_32bit])
+	a2(vmovdqa xmm4,[rip+ssse3_rotl16_32bit])
+	a2(vmovdqa xmm5,[rip+ssse3_rotl8_32bit])
 	a2(vmovdqa xmm0,[rax+0])
 	a2(vmovdqa xmm1,[rax+16])
 	a2(vmovdqa xmm2,[rax+32])
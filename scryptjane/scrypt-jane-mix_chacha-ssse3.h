@@ -138,8 +138,8 @@ asm_naked_fn(scrypt_ChunkMix_ssse3)
 	a2(lea rax,[rsi+r9])
 	a2(lea r9,[rdx+r9])
 	a2(and rdx, rdx)
-	a2(movdqa xmm4,[ssse3_rotl16_32bit])
-	a2(movdqa xmm5,[ssse3_rotl8_32bit])
+	a2(movdqa xmm4,[rip+ssse3_rotl16_32bit])
+	a2(movdqa xmm5,[rip+ssse3_rotl8_32bit])
 	a2(movdqa xmm0,[rax+0])
 	a2(movdqa xmm1,[rax+16])
 	a2(movdqa xmm2,[rax+32])
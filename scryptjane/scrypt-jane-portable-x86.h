@@ -116,10 +116,16 @@
 #endif
 
 #if defined(X86_INTRINSIC_SSSE3) || defined(X86ASM_SSSE3) || defined(X86_64ASM_SSSE3)
-	const packedelem8 MM16 ssse3_rotr16_64bit      = {{2,3,4,5,6,7,0,1,10,11,12,13,14,15,8,9}};
-	const packedelem8 MM16 ssse3_rotl16_32bit      = {{2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13}};
-	const packedelem8 MM16 ssse3_rotl8_32bit       = {{3,0,1,2,7,4,5,6,11,8,9,10,15,12,13,14}};
-	const packedelem8 MM16 ssse3_endian_swap_64bit = {{7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8}};
+	/* file-local so the x86-64 asm can address them rip-relative from a shared object */
+	#if defined(COMPILER_GCC)
+		#define SSSE3_CONST static const __attribute__((used))
+	#else
+		#define SSSE3_CONST const
+	#endif
+	SSSE3_CONST packedelem8 MM16 ssse3_rotr16_64bit      = {{2,3,4,5,6,7,0,1,10,11,12,13,14,15,8,9}};
+	SSSE3_CONST packedelem8 MM16 ssse3_rotl16_32bit      = {{2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13}};
+	SSSE3_CONST packedelem8 MM16 ssse3_rotl8_32bit       = {{3,0,1,2,7,4,5,6,11,8,9,10,15,12,13,14}};
+	SSSE3_CONST packedelem8 MM16 ssse3_endian_swap_64bit = {{7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8}};
 #endif
 
 /*
@@ -200,6 +206,10 @@ typedef enum cpu_vendors_x86_t {
 	cpu_amd
 } cpu_vendors_x86;
 
+#if defined(COMPILER_GCC)
+	#include <cpuid.h>
+#endif
+
 typedef struct x86_regs_t {
 	uint32_t eax, ebx, ecx, edx;
 } x86_regs;
@@ -230,22 +240,8 @@ get_cpuid(x86_regs *regs, uint32_t flags) {
 #if defined(COMPILER_MSVC)
 	__cpuid((int *)regs, (int)flags);
 #else
-	#if defined(CPU_X86_64)
-		#define cpuid_bx rbx
-	#else
-		#define cpuid_bx ebx
-	#endif
-
-	asm_gcc()
-		a1(push cpuid_bx)
-		a1(cpuid)
-		a2(mov [%1 + 0], eax)
-		a2(mov [%1 + 4], ebx)
-		a2(mov [%1 + 8], ecx)
-		a2(mov [%1 + 12], edx)
-		a1(pop cpuid_bx)
-		asm_gcc_parms() : "+a"(flags) : "S"(regs)  : "%ecx", "%edx", "cc"
-	asm_gcc_end()
+	/* the stores are visible to the compiler, unlike an asm block writing through regs */
+	__cpuid_count(flags, 0, regs->eax, regs->ebx, regs->ecx, regs->edx);
 #endif
 }
 
@@ -33,6 +33,7 @@
 
 #include "scryptn.h"
 #include "sha256.h"
+#include "multihash.h"
 
 static void blkcpy(void *, void *, size_t);
 static void blkxor(void *, void *, size_t);
@@ -233,15 +234,18 @@ void scrypt_N_R_1_256_sp(const char* input, char* output, char* scratchpad, uint
 	V = (uint32_t *)(B + (128 * r * p) + (256 * r + 64));
 
 	/* 1: (B_0 ... B_{p-1}) <-- PBKDF2(P, S, 1, p * MFLen) */
+	multihash_flight_mark(MULTIHASH_PHASE_INIT);
 	PBKDF2_SHA256((const uint8_t*)input, len, (const uint8_t*)input, len, 1, B, p * 128 * r);
 
 	/* 2: for i = 0 to p - 1 do */
+	multihash_flight_mark(MULTIHASH_PHASE_MAIN);
 	for (i = 0; i < p; i++) {
 		/* 3: B_i <-- MF(B_i, N) */
 		smix(&B[i * 128 * r], r, N, V, XY);
 	}
 
 	/* 5: DK <-- PBKDF2(P, B, 1, dkLen) */
+	multihash_flight_mark(MULTIHASH_PHASE_FINAL);
 	PBKDF2_SHA256((const uint8_t*)input, len, B, p * 128 * r, 1, (uint8_t*)output, 32);
 }
 
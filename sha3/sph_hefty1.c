@@ -163,6 +163,12 @@ static inline uint8_t Smoosh2(uint32_t X)
     return (n >> 2) ^ (n & 0x3);
 }
 
+/*
+ * The sponge is serial by design (see RoundFunc), but its branches are not:
+ * r is effectively random, so Mangle and Br compute every candidate and pick
+ * one by index instead of paying a mispredicted switch several hundred times
+ * per block.
+ */
 static void Mangle(uint32_t *S)
 {
     uint32_t *R = S;
@@ -178,32 +184,17 @@ static void Mangle(uint32_t *S)
     /* Diffuse */
     uint32_t tmp = 0;
     for (i = 0; i < HEFTY1_SPONGE_WORDS - 1; i++) {
-        uint8_t r = Smoosh2(tmp);
-        switch (r) {
-        case 0:
-            C[i] ^= Rr(R[0], i + r0);
-            break;
-        case 1:
-            C[i] += Rr(~R[0], i + r1);
-            break;
-        case 2:
-            C[i] &= Rr(~R[0], i + r2);
-            break;
-        case 3:
-            C[i] ^= Rr(R[0], i + r3);
-            break;
-        }
+        uint32_t c[4];
+        c[0] = C[i] ^ Rr(R[0], i + r0);
+        c[1] = C[i] + Rr(~R[0], i + r1);
+        c[2] = C[i] & Rr(~R[0], i + r2);
+        c[3] = C[i] ^ Rr(R[0], i + r3);
+        C[i] = c[Smoosh2(tmp)];
         tmp ^= C[i];
     }
 
     /* Compress */
-    tmp = 0;
-    for (i = 0; i < HEFTY1_SPONGE_WORDS - 1; i++)
-        if (i % 2)
-            tmp ^= C[i];
-        else
-            tmp += C[i];
-    R[0] ^= tmp;
+    R[0] ^= (C[0] ^ C[1]) + C[2];
 }
 
 static void Absorb(uint32_t *S, uint32_t X)
@@ -229,21 +220,14 @@ static inline uint32_t Br(HEFTY1_CTX *ctx, uint32_t X)
     uint8_t r1 = R & 0xff;
 
     uint32_t Y = 1 << (r0 % 32);
+    uint32_t x[4];
 
-    switch (r1 % 4)
-    {
-    case 0:
-        /* Do nothing */
-        break;
-    case 1:
-        return X & ~Y;
-    case 2:
-        return X | Y;
-    case 3:
-        return X ^ Y;
-    }
+    x[0] = X;
+    x[1] = X & ~Y;
+    x[2] = X | Y;
+    x[3] = X ^ Y;
 
-    return X;
+    return x[r1 % 4];
 }
 
 static void HashBlock(HEFTY1_CTX *ctx)
@@ -0,0 +1,220 @@
+#include "multihash.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Duplicate share filter: an open addressing set of 64 bit key fingerprints,
+ * filled with compare-and-swap so any number of threads can insert without a
+ * lock. Fingerprints use a per-filter random seed, so miners cannot aim
+ * collisions at someone else's shares. The optional Bloom filter sits in
+ * front: a key whose bits are not all set was never inserted, which answers
+ * the common "new share" case from a bitmap that stays in cache long after
+ * the table has outgrown it.
+ */
+
+#define BLOOM_PROBES 3
+
+struct multihash_share_filter {
+    uint64_t* slots;
+    size_t mask;
+    size_t capacity;
+    size_t count;
+    uint64_t* bloom;
+    size_t bloom_mask;
+    uint64_t seed;
+};
+
+/* MurmurHash64A */
+static uint64_t fingerprint(const void* key, size_t len, uint64_t seed)
+{
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    const uint8_t* data = (const uint8_t*) key;
+    const uint8_t* end = data + (len & ~(size_t) 7);
+    uint64_t h = seed ^ (len * m);
+    uint64_t k;
+
+    while (data != end) {
+        memcpy(&k, data, 8);
+        data += 8;
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    switch (len & 7) {
+    case 7: h ^= (uint64_t) data[6] << 48;
+        /* fall through */
+    case 6: h ^= (uint64_t) data[5] << 40;
+        /* fall through */
+    case 5: h ^= (uint64_t) data[4] << 32;
+        /* fall through */
+    case 4: h ^= (uint64_t) data[3] << 24;
+        /* fall through */
+    case 3: h ^= (uint64_t) data[2] << 16;
+        /* fall through */
+    case 2: h ^= (uint64_t) data[1] << 8;
+        /* fall through */
+    case 1: h ^= (uint64_t) data[0];
+            h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+
+    return h ? h : 1; /* 0 marks an empty slot */
+}
+
+static size_t round_pow2(size_t n)
+{
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+multihash_share_filter* multihash_share_filter_new(size_t capacity, size_t bloom_bits)
+{
+    multihash_share_filter* f;
+    size_t slots;
+
+    if (capacity == 0 || capacity > ((size_t) -1) / 4 / sizeof(uint64_t))
+        return NULL;
+    if (!(f = (multihash_share_filter*) calloc(1, sizeof(multihash_share_filter))))
+        return NULL;
+
+    /* keep the load factor at or below one half */
+    slots = round_pow2(capacity * 2);
+    f->mask = slots - 1;
+    f->capacity = capacity;
+    f->slots = (uint64_t*) calloc(slots, sizeof(uint64_t));
+    f->seed = ((uint64_t) time(NULL) << 32) ^ (uint64_t) (uintptr_t) f ^ (uint64_t) clock();
+
+    if (bloom_bits) {
+        bloom_bits = round_pow2(bloom_bits < 64 ? 64 : bloom_bits);
+        f->bloom_mask = bloom_bits - 1;
+        f->bloom = (uint64_t*) calloc(bloom_bits / 64, sizeof(uint64_t));
+    }
+
+    if (!f->slots || (bloom_bits && !f->bloom)) {
+        multihash_share_filter_free(f);
+        return NULL;
+    }
+    return f;
+}
+
+void multihash_share_filter_free(multihash_share_filter* f)
+{
+    if (!f)
+        return;
+    free(f->slots);
+    free(f->bloom);
+    free(f);
+}
+
+void multihash_share_filter_clear(multihash_share_filter* f)
+{
+    memset(f->slots, 0, (f->mask + 1) * sizeof(uint64_t));
+    if (f->bloom)
+        memset(f->bloom, 0, (f->bloom_mask + 1) / 8);
+    f->count = 0;
+}
+
+size_t multihash_share_filter_count(const multihash_share_filter* f)
+{
+    return f->count;
+}
+
+/* double hashing over the two halves of the fingerprint */
+static size_t bloom_bit(const multihash_share_filter* f, uint64_t fp, int i)
+{
+    return (size_t) ((fp >> 32) + i * (fp | 1)) & f->bloom_mask;
+}
+
+static int bloom_maybe_contains(const multihash_share_filter* f, uint64_t fp)
+{
+    int i;
+    for (i = 0; i < BLOOM_PROBES; i++) {
+        size_t bit = bloom_bit(f, fp, i);
+        if (!(f->bloom[bit / 64] & ((uint64_t) 1 << (bit % 64))))
+            return 0;
+    }
+    return 1;
+}
+
+static void bloom_add(multihash_share_filter* f, uint64_t fp)
+{
+    int i;
+    for (i = 0; i < BLOOM_PROBES; i++) {
+        size_t bit = bloom_bit(f, fp, i);
+        __sync_fetch_and_or(&f->bloom[bit / 64], (uint64_t) 1 << (bit % 64));
+    }
+}
+
+static int table_contains(const multihash_share_filter* f, uint64_t fp)
+{
+    size_t i = (size_t) fp & f->mask, probes;
+
+    for (probes = 0; probes <= f->mask; probes++, i = (i + 1) & f->mask) {
+        uint64_t cur = ((volatile uint64_t*) f->slots)[i];
+        if (cur == fp)
+            return 1;
+        if (cur == 0)
+            return 0;
+    }
+    return 0;
+}
+
+int multihash_share_filter_contains(const multihash_share_filter* f, const void* key, size_t len)
+{
+    uint64_t fp = fingerprint(key, len, f->seed);
+
+    if (f->bloom && !bloom_maybe_contains(f, fp))
+        return 0;
+    return table_contains(f, fp);
+}
+
+int multihash_share_filter_insert(multihash_share_filter* f, const void* key, size_t len)
+{
+    uint64_t fp = fingerprint(key, len, f->seed);
+    size_t i = (size_t) fp & f->mask, probes;
+
+    /*
+     * Bloom first: a key it already holds costs no atomic writes. A definite
+     * miss is a new key, so a full table fails before the walk; the walk itself
+     * stays, since the key still needs its empty slot and two threads racing
+     * to insert it must meet there.
+     */
+    if (f->bloom && !bloom_maybe_contains(f, fp)) {
+        if (f->count >= f->capacity)
+            return MULTIHASH_ENOMEM;
+        bloom_add(f, fp);
+    }
+
+    for (probes = 0; probes <= f->mask; probes++, i = (i + 1) & f->mask) {
+        uint64_t cur = ((volatile uint64_t*) f->slots)[i];
+
+        if (cur == fp)
+            return 0;
+        if (cur != 0)
+            continue;
+
+        if (f->count >= f->capacity)
+            return MULTIHASH_ENOMEM;
+
+        cur = __sync_val_compare_and_swap(&f->slots[i], (uint64_t) 0, fp);
+        if (cur == 0) {
+            __sync_fetch_and_add(&f->count, 1);
+            return 1;
+        }
+        if (cur == fp)
+            return 0;
+    }
+
+    return MULTIHASH_ENOMEM;
+}
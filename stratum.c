@@ -0,0 +1,284 @@
+#include "multihash.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sha256.h"
+
+/*
+ * Share reconstruction for Bitcoin-framed stratum jobs. The job keeps the
+ * sha256 state after coinbase1 (and after the job's extranonce1), so a share
+ * only hashes its extranonces and coinbase2 on top of a copied midstate.
+ */
+
+struct multihash_job {
+    int algo;
+    multihash_params params;
+    SHA256_CTX coinbase1;           /* after coinbase1 */
+    SHA256_CTX extranonce1;         /* after coinbase1 and the job's extranonce1 */
+    int has_extranonce1;
+    size_t extranonce2_len;
+    unsigned char* coinbase2;
+    size_t coinbase2_len;
+    unsigned char* branches;
+    size_t branch_count;
+    unsigned char header[80];       /* version, prevhash and nbits filled in */
+    unsigned char block_target[32];
+    int has_block_target;
+};
+
+static void sha256d(const void* a, size_t a_len, const void* b, size_t b_len, unsigned char out[32])
+{
+    SHA256_CTX ctx;
+
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, a, a_len);
+    SHA256_Update(&ctx, b, b_len);
+    SHA256_Final(out, &ctx);
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, out, 32);
+    SHA256_Final(out, &ctx);
+}
+
+multihash_job* multihash_job_new(const multihash_job_template* t)
+{
+    multihash_job* job;
+
+    if (!t || !multihash_algo_available(t->algo) || t->algo == MULTIHASH_BOOLBERRY || !t->prevhash ||
+        (t->merkle_count && !t->merkle_branches) || t->extranonce2_len > MULTIHASH_JOB_EXTRANONCE_MAX)
+        return NULL;
+
+    job = (multihash_job*) calloc(1, sizeof(multihash_job));
+    if (!job)
+        return NULL;
+
+    job->coinbase2 = (unsigned char*) malloc(t->coinbase2_len ? t->coinbase2_len : 1);
+    job->branches = (unsigned char*) malloc(t->merkle_count ? t->merkle_count * 32 : 1);
+    if (!job->coinbase2 || !job->branches) {
+        multihash_job_free(job);
+        return NULL;
+    }
+
+    job->algo = t->algo;
+    job->params = t->params;
+
+    SHA256_Init(&job->coinbase1);
+    SHA256_Update(&job->coinbase1, t->coinbase1, t->coinbase1_len);
+    job->extranonce1 = job->coinbase1;
+    if (t->extranonce1) {
+        SHA256_Update(&job->extranonce1, t->extranonce1, t->extranonce1_len);
+        job->has_extranonce1 = 1;
+    }
+    job->extranonce2_len = t->extranonce2_len;
+
+    if (t->coinbase2_len)
+        memcpy(job->coinbase2, t->coinbase2, t->coinbase2_len);
+    job->coinbase2_len = t->coinbase2_len;
+    if (t->merkle_count)
+        memcpy(job->branches, t->merkle_branches, t->merkle_count * 32);
+    job->branch_count = t->merkle_count;
+
+    le32enc(job->header, t->version);
+    memcpy(job->header + 4, t->prevhash, 32);
+    le32enc(job->header + 72, t->nbits);
+
+    if (t->block_target) {
+        memcpy(job->block_target, t->block_target, 32);
+        job->has_block_target = 1;
+    } else {
+        job->has_block_target = multihash_nbits_to_target(t->nbits, job->block_target) == MULTIHASH_OK;
+    }
+    return job;
+}
+
+void multihash_job_free(multihash_job* job)
+{
+    if (!job)
+        return;
+    free(job->coinbase2);
+    free(job->branches);
+    free(job);
+}
+
+int multihash_job_header(const multihash_job* job, const void* extranonce1, size_t extranonce1_len,
+                         const void* extranonce2, size_t extranonce2_len,
+                         uint32_t ntime, uint32_t nonce, void* header)
+{
+    unsigned char* out = (unsigned char*) header;
+    unsigned char root[32];
+    SHA256_CTX ctx;
+    size_t i;
+
+    if (!job || (!extranonce1 && !job->has_extranonce1) || extranonce2_len > MULTIHASH_JOB_EXTRANONCE_MAX ||
+        (job->extranonce2_len && extranonce2_len != job->extranonce2_len))
+        return MULTIHASH_EINVAL;
+
+    if (extranonce1) {
+        ctx = job->coinbase1;
+        SHA256_Update(&ctx, extranonce1, extranonce1_len);
+    } else {
+        ctx = job->extranonce1;
+    }
+    SHA256_Update(&ctx, extranonce2, extranonce2_len);
+    SHA256_Update(&ctx, job->coinbase2, job->coinbase2_len);
+    SHA256_Final(root, &ctx);
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, root, 32);
+    SHA256_Final(root, &ctx);
+
+    for (i = 0; i < job->branch_count; i++)
+        sha256d(root, 32, job->branches + i * 32, 32, root);
+
+    memcpy(out, job->header, 36);
+    memcpy(out + 36, root, 32);
+    le32enc(out + 68, ntime);
+    memcpy(out + 72, job->header + 72, 4);
+    le32enc(out + 76, nonce);
+    return MULTIHASH_OK;
+}
+
+int multihash_job_hash(multihash_ctx* ctx, const multihash_job* job, const void* extranonce1, size_t extranonce1_len,
+                       const void* extranonce2, size_t extranonce2_len, uint32_t ntime, uint32_t nonce,
+                       void* header, void* output)
+{
+    unsigned char buffer[80];
+    unsigned char* h = header ? (unsigned char*) header : buffer;
+    int rc;
+
+    rc = multihash_job_header(job, extranonce1, extranonce1_len, extranonce2, extranonce2_len, ntime, nonce, h);
+    if (rc != MULTIHASH_OK)
+        return rc;
+    return multihash_hash(ctx, job->algo, &job->params, h, 80, output);
+}
+
+int multihash_job_is_block(const multihash_job* job, const void* hash)
+{
+    return job && job->has_block_target && multihash_meets_target(hash, job->block_target);
+}
+
+/* one batch of shares; each task's arg points here */
+typedef struct share_batch {
+    const multihash_job* job;
+    multihash_task* tasks;
+    size_t count;
+    int* statuses;
+    multihash_block_fn on_block;
+    multihash_batch_fn complete;
+    void* arg;
+} share_batch;
+
+static void share_done(multihash_task* task)
+{
+    share_batch* batch = (share_batch*) task->arg;
+
+    if (task->status == MULTIHASH_OK && multihash_job_is_block(batch->job, task->output))
+        batch->on_block(batch->arg, (size_t) (task - batch->tasks), task->input, task->output);
+}
+
+/* builds the headers and the tasks that hash them */
+static int share_batch_init(share_batch* batch, const multihash_job* job, const multihash_job_share* shares,
+                            size_t count, void* headers, void* hashes, int* statuses,
+                            multihash_block_fn on_block, void* arg)
+{
+    unsigned char* h = (unsigned char*) headers;
+    size_t i;
+    int rc;
+
+    if (!job || (count && (!shares || !headers || !hashes || !statuses)))
+        return MULTIHASH_EINVAL;
+
+    for (i = 0; i < count; i++) {
+        rc = multihash_job_header(job, shares[i].extranonce1, shares[i].extranonce1_len,
+                                  shares[i].extranonce2, shares[i].extranonce2_len,
+                                  shares[i].ntime, shares[i].nonce, h + i * 80);
+        if (rc != MULTIHASH_OK)
+            return rc;
+    }
+
+    if (!(batch->tasks = (multihash_task*) calloc(count ? count : 1, sizeof(multihash_task))))
+        return MULTIHASH_ENOMEM;
+    batch->job = job;
+    batch->count = count;
+    batch->statuses = statuses;
+    batch->on_block = on_block;
+    batch->arg = arg;
+
+    for (i = 0; i < count; i++) {
+        multihash_task* task = &batch->tasks[i];
+
+        task->algo = job->algo;
+        task->params = job->params;
+        task->input = h + i * 80;
+        task->len = 80;
+        task->output = (unsigned char*) hashes + i * MULTIHASH_OUTPUT_SIZE;
+        if (on_block) {
+            task->done = share_done;
+            task->arg = batch;
+        }
+    }
+    return MULTIHASH_OK;
+}
+
+static void share_batch_statuses(share_batch* batch)
+{
+    size_t i;
+
+    for (i = 0; i < batch->count; i++)
+        batch->statuses[i] = batch->tasks[i].status;
+}
+
+int multihash_job_hash_batch(multihash_scheduler* scheduler, const multihash_job* job,
+                             const multihash_job_share* shares, size_t count,
+                             void* headers, void* hashes, int* statuses,
+                             multihash_block_fn on_block, void* arg)
+{
+    share_batch batch;
+    int rc;
+
+    if (!scheduler)
+        return MULTIHASH_EINVAL;
+    rc = share_batch_init(&batch, job, shares, count, headers, hashes, statuses, on_block, arg);
+    if (rc != MULTIHASH_OK)
+        return rc;
+
+    rc = multihash_scheduler_run(scheduler, batch.tasks, count);
+    if (rc == MULTIHASH_OK)
+        share_batch_statuses(&batch);
+    free(batch.tasks);
+    return rc;
+}
+
+static void share_batch_complete(void* arg, int status)
+{
+    share_batch* batch = (share_batch*) arg;
+
+    share_batch_statuses(batch);
+    batch->complete(batch->arg, status);
+    free(batch->tasks);
+    free(batch);
+}
+
+int multihash_job_submit_batch(multihash_scheduler* scheduler, const multihash_job* job,
+                               const multihash_job_share* shares, size_t count,
+                               void* headers, void* hashes, int* statuses,
+                               multihash_block_fn on_block, multihash_batch_fn complete, void* arg)
+{
+    share_batch* batch;
+    int rc;
+
+    if (!scheduler || !complete)
+        return MULTIHASH_EINVAL;
+    if (!(batch = (share_batch*) calloc(1, sizeof(share_batch))))
+        return MULTIHASH_ENOMEM;
+
+    rc = share_batch_init(batch, job, shares, count, headers, hashes, statuses, on_block, arg);
+    if (rc == MULTIHASH_OK) {
+        batch->complete = complete;
+        rc = multihash_scheduler_submit(scheduler, batch->tasks, count, share_batch_complete, batch);
+        if (rc == MULTIHASH_OK)
+            return rc;
+        free(batch->tasks);
+    }
+    free(batch);
+    return rc;
+}
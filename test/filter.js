@@ -0,0 +1,31 @@
+/*
+    options.filter only takes share filters: other wrapped objects (a chain, a job)
+    and plain objects throw instead of being read as one.
+*/
+var assert = require('assert');
+var multiHashing = require('..');
+
+var job = multiHashing.stratumJob({
+    algorithm: 'x11', coinbase1: Buffer.alloc(40, 1), coinbase2: Buffer.alloc(40, 2),
+    extranonce1: Buffer.alloc(4, 3), extranonce2Size: 4, merkleBranches: [],
+    version: 2, nbits: 0x1d00ffff, prevHash: Buffer.alloc(32)
+});
+var share = [{extranonce2: Buffer.alloc(4), ntime: 1, nonce: 1}];
+var message = /options.filter should be a share filter/;
+
+[multiHashing.chain(['blake', 'keccak']), job, {}].forEach(function(wrong){
+    assert.throws(function(){ multiHashing.hashBatch('keccak', Buffer.alloc(800), 80, {filter: wrong}); }, message);
+    assert.throws(function(){ job.submit(Buffer.alloc(4), 1, 1, {filter: wrong}); }, message);
+    assert.throws(function(){ job.submitBatch(share, function(){}, {filter: wrong}); }, message);
+    assert.throws(function(){ multiHashing.hashTasks([{algorithm: 'x11', input: Buffer.alloc(80)}], {filter: wrong}); }, message);
+    assert.throws(function(){ new multiHashing.HashRing({slots: 16, threads: 1, filter: wrong}); }, message);
+});
+
+/* a filter from the core module still works in the family modules */
+var seen = multiHashing.shareFilter(100);
+var result = multiHashing.hashBatch('keccak', Buffer.alloc(160), 80, {filter: seen});
+assert.deepStrictEqual(Array.from(result.hashed), [1, 0]);
+assert.strictEqual(seen.check('job', 1), true);
+assert.strictEqual(seen.check('job', 1), false);
+
+console.log('filter: ok');
@@ -0,0 +1,47 @@
+/*
+    A poll callback that throws releases its slot first: the ring keeps taking
+    submissions and completing them afterwards.
+*/
+var assert = require('assert');
+var multiHashing = require('..');
+
+var ring = new multiHashing.HashRing({slots: 4, threads: 1});
+var target = Buffer.alloc(32, 0xff);
+var seen = [];
+var thrown = 0;
+
+function submit(from, to){
+    for (var id = from; id < to; id++)
+        assert.ok(ring.submit(id, 'keccak', Buffer.alloc(80, id), target));
+    ring.wake();
+}
+
+function drain(until, done){
+    try {
+        ring.poll(function(id, status, meetsTarget, hash){
+            assert.strictEqual(status, 0);
+            seen.push(id);
+            if (id % 2 === 0){
+                thrown++;
+                throw new Error('callback ' + id);
+            }
+        });
+    } catch (e){
+        assert.ok(/^callback \d+$/.test(e.message));
+    }
+    if (seen.length < until)
+        return setTimeout(drain, 1, until, done);
+    done();
+}
+
+submit(0, 4);
+drain(4, function(){
+    /* every slot was handed back even though half the callbacks threw */
+    submit(4, 8);
+    drain(8, function(){
+        ring.stop();
+        assert.deepStrictEqual(seen.slice().sort(function(a, b){ return a - b; }), [0, 1, 2, 3, 4, 5, 6, 7]);
+        assert.strictEqual(thrown, 4);
+        console.log('ring: ok');
+    });
+});
@@ -0,0 +1,62 @@
+/*
+    Methods called on another kind of wrapped object throw (V8's receiver check or
+    the type tag) instead of reading its pointer as their own.
+*/
+var assert = require('assert');
+var multiHashing = require('..');
+
+var chain = multiHashing.chain(['blake', 'keccak']);
+var filter = multiHashing.shareFilter(10);
+var header = Buffer.alloc(80);
+
+var HashChain = Object.getPrototypeOf(chain);
+
+[filter, {}].forEach(function(wrong){
+    assert.throws(function(){ HashChain.hash.call(wrong, header); });
+    assert.throws(function(){ HashChain.hashBatch.call(wrong, header, 80); });
+});
+assert.throws(function(){ Object.getPrototypeOf(filter).check.call(chain, 'job', 1); });
+
+var job = multiHashing.stratumJob({
+    algorithm: 'x11', coinbase1: Buffer.alloc(40, 1), coinbase2: Buffer.alloc(40, 2),
+    extranonce1: Buffer.alloc(4, 3), extranonce2Size: 4, merkleBranches: [],
+    version: 2, nbits: 0x1d00ffff, prevHash: Buffer.alloc(32)
+});
+var StratumJob = Object.getPrototypeOf(job);
+
+[chain, filter, {}].forEach(function(wrong){
+    assert.throws(function(){ StratumJob.hash.call(wrong, Buffer.alloc(4), 1, 1); });
+    assert.throws(function(){ StratumJob.submit.call(wrong, Buffer.alloc(4), 1, 1); });
+    assert.throws(function(){ StratumJob.submitBatch.call(wrong, [], function(){}); });
+});
+assert.strictEqual(job.hash(Buffer.alloc(4), 1, 1).header.length, 80);
+
+var ring = new multiHashing.HashRing({slots: 16, threads: 1});
+var RingWorkers = Object.getPrototypeOf(ring.workers);
+
+[chain, filter, job, {}].forEach(function(wrong){
+    assert.throws(function(){ RingWorkers.wake.call(wrong); });
+    assert.throws(function(){ RingWorkers.stop.call(wrong); });
+});
+ring.stop();
+
+var families = require('../families');
+var core = families.load('core');
+var sph = families.load('sph');
+
+[core.flightRecorder(), filter, {}].forEach(function(wrong){
+    assert.throws(function(){ sph.useMemoryGovernor(wrong); }, /governor from memoryGovernor/);
+});
+sph.useMemoryGovernor(core.memoryGovernor());
+
+[core.memoryGovernor(), filter, {}].forEach(function(wrong){
+    assert.throws(function(){ sph.useFlightRecorder(wrong); }, /recorder from flightRecorder/);
+});
+sph.useFlightRecorder(core.flightRecorder());
+
+[core.memoryGovernor(), filter, {}].forEach(function(wrong){
+    assert.throws(function(){ sph.useScheduler(wrong); }, /scheduler from scheduler/);
+});
+sph.useScheduler(core.scheduler());
+
+console.log('unwrap: ok');
@@ -0,0 +1,288 @@
+#!/usr/bin/env node
+/*
+    Startup autotuner. Measures the candidate configurations on this machine and
+    keeps the fastest: the kernel variant of every algorithm that has several (see
+    variants()), and the number of HashRing worker threads per algorithm. Every
+    candidate is first checked against the reference output (the portable kernel,
+    or a direct hash call for ring threads); one that disagrees is never selected.
+
+        multiHashing.tune({algorithms: ['scryptjane', 'x11']});
+
+    or from the shell, once per host:
+
+        multihashing-tune --algorithms scryptjane,x11
+
+    The result goes to a small JSON cache file (MULTIHASHING_TUNE_FILE, by default
+    ~/.cache/multi-hashing/tune.json) that every later process reads when it loads
+    its first native module. A cache written on a different cpu, core count, Node
+    ABI or version of this package is ignored.
+*/
+
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+
+var VERSION = 1;
+var HEADER_LENGTH = 80;
+var SAMPLES = 16;
+
+/* what the memory-hard algorithms are measured with unless options.params says otherwise */
+var defaultParams = {
+    scrypt: {N: 1024, r: 1},
+    scryptn: {nfactor: 10},
+    scryptjane: {nfactor: 10}
+};
+
+var cache = null;
+
+function cacheFile(file){
+    return file || process.env.MULTIHASHING_TUNE_FILE ||
+        path.join(os.homedir(), '.cache', 'multi-hashing', 'tune.json');
+}
+
+function host(){
+    var cpus = os.cpus();
+    return [process.arch, cpus.length ? cpus[0].model : '', cpus.length,
+            process.versions.modules, require('./package.json').version].join('|');
+}
+
+function empty(){
+    return {version: VERSION, host: host(), variants: {}, threads: {}, rates: {}};
+}
+
+/* the selections in effect; read from the cache file once per process */
+function cached(file){
+    if (cache && !file)
+        return cache;
+
+    var result = empty();
+    try {
+        var stored = JSON.parse(fs.readFileSync(cacheFile(file), 'utf8'));
+        if (stored.version === VERSION && stored.host === result.host)
+            result = stored;
+    }
+    catch (e){
+    }
+
+    if (!file)
+        cache = result;
+    return result;
+}
+
+function save(config, file){
+    file = cacheFile(file);
+    fs.mkdirSync(path.dirname(file), {recursive: true});
+    fs.writeFileSync(file + '.tmp', JSON.stringify(config, null, 2) + '\n');
+    fs.renameSync(file + '.tmp', file);
+}
+
+function now(){
+    return Number(process.hrtime.bigint()) / 1e9;
+}
+
+/* headers that differ in the nonce, as consecutive records */
+function samples(){
+    var records = Buffer.alloc(SAMPLES * HEADER_LENGTH);
+    for (var i = 0; i < SAMPLES; i++){
+        for (var j = 0; j < HEADER_LENGTH; j++)
+            records[i * HEADER_LENGTH + j] = (j * 131 + 7) & 0xff;
+        records.writeUInt32LE(i, i * HEADER_LENGTH + HEADER_LENGTH - 4);
+    }
+    return records;
+}
+
+/* hashes per second of batches over records, for at least seconds */
+function rate(native, algo, records, params, seconds){
+    var count = 0;
+    var start = now();
+    var elapsed;
+
+    do {
+        native.hashBatch(algo, records, HEADER_LENGTH, params);
+        count += SAMPLES;
+        elapsed = now() - start;
+    } while (elapsed < seconds);
+
+    return count / elapsed;
+}
+
+function tuneVariants(families, algo, records, params, seconds, report){
+    var native = families.forAlgorithm(algo);
+    var names = native.variants(algo);
+
+    if (names.length < 2)
+        return null;
+
+    /* the last variant is the portable kernel */
+    native.selectVariant(algo, names[names.length - 1]);
+    var reference = native.hashBatch(algo, records, HEADER_LENGTH, params);
+
+    var rates = {};
+    var best = null;
+
+    names.forEach(function(name){
+        native.selectVariant(algo, name);
+        if (!native.hashBatch(algo, records, HEADER_LENGTH, params).equals(reference)){
+            report(algo + ' variant ' + name + ': wrong output, skipped');
+            return;
+        }
+        rates[name] = rate(native, algo, records, params, seconds);
+        report(algo + ' variant ' + name + ': ' + rates[name].toFixed(1) + ' H/s');
+        if (best === null || rates[name] > rates[best])
+            best = name;
+    });
+
+    native.selectVariant(algo, null);
+    return {best: best, rates: rates};
+}
+
+/* completions per second of a ring with this many workers, or 0 when a hash is wrong */
+function ringRate(HashRing, algoId, records, reference, params, threads, seconds){
+    var ring = new HashRing({slots: 1024, threads: threads});
+    var p0 = params.N || params.nfactor || 0;
+    var p1 = params.r || 0;
+    var done = 0;
+    var wrong = false;
+    var next = 0;
+    var start = now();
+    var elapsed;
+
+    function complete(id, status, meetsTarget, hash){
+        if (status !== 0 || !reference.subarray(id * 32, id * 32 + 32).equals(hash))
+            wrong = true;
+        done++;
+    }
+
+    try {
+        do {
+            while (ring.submit(next % SAMPLES, algoId,
+                               records.subarray((next % SAMPLES) * HEADER_LENGTH, (next % SAMPLES + 1) * HEADER_LENGTH),
+                               null, p0, p1))
+                next++;
+            ring.wake();
+            ring.poll(complete);
+            elapsed = now() - start;
+        } while (elapsed < seconds && !wrong);
+    }
+    finally {
+        ring.stop();
+    }
+
+    return wrong ? 0 : done / elapsed;
+}
+
+function threadCandidates(options){
+    if (options.threads)
+        return options.threads;
+
+    var cpus = os.cpus().length || 1;
+    var list = [];
+    for (var n = 1; n < cpus; n *= 2)
+        list.push(n);
+    list.push(cpus);
+    return list;
+}
+
+function tuneThreads(families, algo, records, params, seconds, candidates, report){
+    var HashRing = require('./ring');
+    var algoId = families.load('core').algorithms.indexOf(algo);
+    var reference = families.forAlgorithm(algo).hashBatch(algo, records, HEADER_LENGTH, params);
+    var rates = {};
+    var best = null;
+
+    candidates.forEach(function(threads){
+        var r = ringRate(HashRing, algoId, records, reference, params, threads, seconds);
+        if (!r){
+            report(algo + ' x' + threads + ' threads: wrong output, skipped');
+            return;
+        }
+        rates[threads] = r;
+        report(algo + ' x' + threads + ' threads: ' + r.toFixed(1) + ' H/s');
+        /* more threads have to be clearly faster to be worth their memory */
+        if (best === null || r > rates[best] * 1.03)
+            best = threads;
+    });
+
+    return {best: best, rates: rates};
+}
+
+/*
+    Measures and selects, then (unless options.save is false) writes the cache file.
+    options: algorithms (default: every one the ring can run), time per candidate in
+    ms (200), threads (candidate worker counts, default 1, 2, 4, ... up to the core
+    count), params ({algo: {N, r, nfactor}}), file, log (function(line)).
+    Returns the new configuration.
+*/
+function tune(options){
+    var families = require('./families');
+
+    options = options || {};
+
+    var algorithms = options.algorithms || families.load('core').algorithms.filter(function(name){
+        return name !== 'boolberry';
+    });
+    var seconds = (options.time || 200) / 1000;
+    var candidates = threadCandidates(options);
+    var report = options.log || function(){};
+    var records = samples();
+    var config = empty();
+
+    algorithms.forEach(function(algo){
+        var params = (options.params && options.params[algo]) || defaultParams[algo] || {};
+        var result = tuneVariants(families, algo, records, params, seconds, report);
+
+        config.rates[algo] = {};
+        if (result && result.best){
+            config.variants[algo] = result.best;
+            config.rates[algo].variants = result.rates;
+            families.selectVariant(algo, result.best);
+        }
+
+        result = tuneThreads(families, algo, records, params, seconds, candidates, report);
+        if (result.best){
+            config.threads[algo] = result.best;
+            config.rates[algo].threads = result.rates;
+        }
+    });
+
+    config.created = new Date().toISOString();
+    if (options.save !== false)
+        save(config, options.file);
+    if (!options.file)
+        cache = config;
+    return config;
+}
+
+exports.tune = tune;
+exports.cached = cached;
+exports.file = cacheFile;
+
+if (require.main === module){
+    var args = process.argv.slice(2);
+    var options = {log: function(line){ console.log(line); }};
+
+    for (var i = 0; i < args.length; i++){
+        switch (args[i]){
+            case '--algorithms': options.algorithms = args[++i].split(','); break;
+            case '--time': options.time = +args[++i]; break;
+            case '--threads': options.threads = args[++i].split(',').map(Number); break;
+            case '--file': options.file = args[++i]; break;
+            case '--dry-run': options.save = false; break;
+            case '--show': options.show = true; break;
+            default:
+                console.error('usage: multihashing-tune [--algorithms a,b] [--time ms] [--threads 1,2,4] [--file path] [--dry-run] [--show]');
+                process.exit(1);
+        }
+    }
+
+    if (options.show){
+        console.log(JSON.stringify(cached(options.file || cacheFile()), null, 2));
+        process.exit(0);
+    }
+
+    var config = tune(options);
+    console.log('variants: ' + JSON.stringify(config.variants));
+    console.log('threads:  ' + JSON.stringify(config.threads));
+    if (options.save !== false)
+        console.log('saved to ' + cacheFile(options.file));
+}